@@ -20,7 +20,7 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
 	[Monitor("LinuxDebugger", true)]
 	[Parameter("Executable", typeof(string), "Executable to launch")]
 	[Parameter("Arguments", typeof(string), "Optional command line arguments", "")]
-	[Parameter("GdbPath", typeof(string), "Path to gdb", "/usr/bin/gdb")]
+	[Parameter("GdbPath", typeof(string), "Ignored, kept for older pits", "/usr/bin/gdb")]
 	[Parameter("RestartOnEachTest", typeof(bool), "Restart process for each interation", "false")]
 	[Parameter("FaultOnEarlyExit", typeof(bool), "Trigger fault if process exists", "false")]
 	[Parameter("NoCpuKill", typeof(bool), "Disable process killing when CPU usage nears zero", "false")]
@@ -33,39 +33,10 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
 
 		static string strPid;
 
-		static readonly string template = @"
-define log_if_crash
- if ($_thread != 0x00)
-  printf ""*** Crash detected. ***\n""
-  set logging overwrite on
-  set logging redirect on
-  set logging on {0}
-  set logging off
- end
-end
-
-handle all nostop noprint
-handle SIGABRT SIGSEGV EXC_BAD_ACCESS EXC_BAD_INSTRUCTION EXC_ARITHMETIC stop print
-
-file {1}
-set args {2}
-
-start
-python with open('{4}', 'w') as f: f.write(str(gdb.inferiors()[0].pid))
-cont
-log_if_crash
-quit
-";
-
-		Process _procHandler;
-		Process _procCommand;
+		NativeDebugger _debugger;
+		SanitizerReport _report;
 		Fault _fault = null;
 		bool _messageExit = false;
-		string _exploitable = null;
-		string _tmpPath = null;
-		string _gdbCmd = null;
-		string _gdbPid = null;
-		string _gdbLog = null;
 
 		Regex reHash = new Regex(@"^Hash: (\w+)\.(\w+)$", RegexOptions.Multiline);
 		Regex reClassification = new Regex(@"^Exploitability Classification: (.*)$", RegexOptions.Multiline);
@@ -86,129 +57,61 @@ quit
 			: base(agent, name, args)
 		{
 			ParameterParser.Parse(this, args);
-
-			_exploitable = FindExploitable();
-		}
-
-		string FindExploitable()
-		{
-			var target = "gdb/exploitable/exploitable.py";
-
-			var dirs = new List<string> {
-				Path.GetDirectoryName(Assembly.GetExecutingAssembly().Location),
-				Directory.GetCurrentDirectory(),
-			};
-
-			string path = Environment.GetEnvironmentVariable("PATH");
-			if (!string.IsNullOrEmpty(path))
-				dirs.AddRange(path.Split(Path.PathSeparator));
-
-			foreach (var dir in dirs)
-			{
-				string full = Path.Combine(dir, target);
-				if (File.Exists(full))
-					return full;
-			};
-
-			throw new PeachException("Error, LinuxDebugger could not find '" + target + "' in search path.");
 		}
 
 		void _Start()
 		{
-			System.Environment.SetEnvironmentVariable("ASAN_OPTIONS", "abort_on_error=1:detect_leaks=0:symbolize=1:allocator_may_return_null=1:" + "log_path=" + Peach.Core.Runtime.SHARE.pathAsanReport);
-			System.Environment.SetEnvironmentVariable("MSAN_OPTIONS", "exit_code=86:msan_track_origins=0:symbolize=1:abort_on_error=1:allocator_may_return_null=1");
-
-			var si = new ProcessStartInfo();
-			si.FileName = GdbPath;
-			si.Arguments = "-batch -n -x " + _gdbCmd;
-			si.UseShellExecute = false;
+			string logPath = Peach.Core.Runtime.SHARE.pathAsanReport;
 
-			_procHandler = new System.Diagnostics.Process();
-			_procHandler.StartInfo = si;
+			var env = new Dictionary<string, string>();
+			env["ASAN_OPTIONS"] = "abort_on_error=1:detect_leaks=0:symbolize=1:allocator_may_return_null=1:" + "log_path=" + logPath;
+			env["MSAN_OPTIONS"] = "exit_code=86:msan_track_origins=0:symbolize=1:abort_on_error=1:allocator_may_return_null=1:" + "log_path=" + logPath;
+			env["UBSAN_OPTIONS"] = "halt_on_error=1:abort_on_error=1:print_stacktrace=1:symbolize=1:" + "log_path=" + logPath;
 
-			logger.Debug("_Start(): Starting gdb process");
+			_Close();
 
-			if (File.Exists(_gdbLog))
-				File.Delete(_gdbLog);
-
-			if (File.Exists(_gdbPid))
-				File.Delete(_gdbPid);
+			logger.Debug("_Start(): Starting process");
 
 			try
 			{
-				_procHandler.Start();
+				_debugger = new NativeDebugger(Executable, Arguments, env);
 			}
-			catch (Exception ex)
+			catch (DllNotFoundException ex)
 			{
-				_procHandler = null;
-				throw new PeachException("Could not start debugger '" + GdbPath + "'.  " + ex.Message + ".", ex);
+				throw new PeachException("Could not load libpeachDebugger.  " + ex.Message + ".", ex);
 			}
 
-			// Wait for pid file to exist, open it up and read it
-			while (!File.Exists(_gdbPid) && !_procHandler.HasExited)
-				Thread.Sleep(250);
-
-			if (!File.Exists(_gdbPid) && _procHandler.HasExited)
-				throw new PeachException("GDB was unable to start '" + Executable + "'.");
+			// "stderr" leaves the reports on the console
+			_report = new SanitizerReport();
+			if (logPath != "stderr")
+				_debugger.SetLog(logPath);
 
-			strPid = File.ReadAllText(_gdbPid);
-			int pid = Convert.ToInt32(strPid);
-
-			try
+			if (!_debugger.Start())
 			{
-				_procCommand = Process.GetProcessById(pid);
-			}
-			catch (ArgumentException)
-			{
-				// Program ran to completion
-				_procCommand = null;
+				_Close();
+				throw new PeachException("LinuxDebugger was unable to start '" + Executable + "'.");
 			}
+
+			strPid = _debugger.Pid.ToString();
 		}
 
 		void _Stop()
 		{
-			if (_procHandler == null)
+			if (_debugger == null || !_IsRunning())
 				return;
 
-			// Stopping procCommand will cause procHandler to exit
-			if (_procCommand != null)
-			{
-				if (!_procCommand.HasExited)
-				{
-					logger.Debug("_Stop(): Stopping process");
-					_procCommand.CloseMainWindow();
-					_procCommand.WaitForExit(500);
-
-					if (!_procCommand.HasExited)
-					{
-						try
-						{
-							logger.Debug("_Stop(): Killing process");
-							_procCommand.Kill();
-						}
-						catch (InvalidOperationException)
-						{
-							// Already exited between HasExited and Kill()
-						}
-						_procCommand.WaitForExit();
-					}
-				}
-
-				logger.Debug("_Stop(): Closing process");
-				_procCommand.Close();
-				_procCommand = null;
-			}
+			logger.Debug("_Stop(): Stopping process");
+			_debugger.Stop(500);
+		}
 
-			if (!_procHandler.HasExited)
-			{
-				logger.Debug("_Stop(): Waiting for gdb to complete");
-				string output = _procHandler.StandardOutput.ReadToEnd();
-				_procHandler.WaitForExit();
-			}
+		void _Close()
+		{
+			if (_debugger == null)
+				return;
 
-			logger.Debug("_Stop(): Closing gdb");
-			_procHandler.Close();
-			_procHandler = null;
+			logger.Debug("_Close(): Closing process");
+			_debugger.Dispose();
+			_debugger = null;
 		}
 
 		void _WaitForExit(bool useCpuKill)
@@ -218,35 +121,12 @@ quit
 
 			if (useCpuKill && !NoCpuKill)
 			{
-				const int pollInterval = 200;
-				ulong lastTime = 0;
-				int i = 0;
-
-				try
-				{
-					for (i = 0; i < WaitForExitTimeout; i += pollInterval)
-					{
-						var pi = ProcessInfo.Instance.Snapshot(_procCommand);
-
-						logger.Trace("CpuKill: OldTicks={0} NewTicks={1}", lastTime, pi.TotalProcessorTicks);
-
-						if (i != 0 && lastTime == pi.TotalProcessorTicks)
-						{
-							logger.Debug("Cpu is idle, stopping process.");
-							break;
-						}
-
-						lastTime = pi.TotalProcessorTicks;
-						Thread.Sleep(pollInterval);
-					}
+				var ret = _debugger.WaitForIdle(WaitForExitTimeout, 200);
 
-					if (i >= WaitForExitTimeout)
-						logger.Debug("Timed out waiting for cpu idle, stopping process.");
-				}
-				catch (Exception ex)
-				{
-					logger.Debug("Error querying cpu time: {0}", ex.Message);
-				}
+				if (ret == NativeDebugger.IdleResult.Idle)
+					logger.Debug("Cpu is idle, stopping process.");
+				else if (ret == NativeDebugger.IdleResult.Timeout)
+					logger.Debug("Timed out waiting for cpu idle, stopping process.");
 
 				_Stop();
 			}
@@ -254,7 +134,7 @@ quit
 			{
 				logger.Debug("WaitForExit({0})", WaitForExitTimeout == -1 ? "INFINITE" : WaitForExitTimeout.ToString());
 
-				if (!_procCommand.WaitForExit(WaitForExitTimeout))
+				if (!_debugger.WaitForExit(WaitForExitTimeout))
 				{
 					if (!useCpuKill)
 					{
@@ -268,7 +148,12 @@ quit
 
 		bool _IsRunning()
 		{
-			return _procCommand != null && !_procCommand.HasExited;
+			return _debugger != null && _debugger.CurrentState == NativeDebugger.State.Running;
+		}
+
+		bool _IsCrashed()
+		{
+			return _debugger != null && _debugger.CurrentState == NativeDebugger.State.Crashed;
 		}
 
 		Fault MakeFault(string folder, string reason)
@@ -283,19 +168,6 @@ quit
 			};
 		}
 
-		[DllImport("libc", CharSet = CharSet.Ansi, SetLastError = true)]
-		static extern IntPtr mkdtemp(StringBuilder template);
-
-		string MakeTempDir()
-		{
-			StringBuilder dir = new StringBuilder(Path.Combine(Path.GetTempPath(), "gdb.XXXXXX"));
-			IntPtr ptr = mkdtemp(dir);
-			if (ptr == IntPtr.Zero)
-				throw new Win32Exception(Marshal.GetLastWin32Error());
-
-			return dir.ToString();
-		}
-
 		public override void IterationStarting(uint iterationCount, bool isReproduction)
 		{
 			_fault = null;
@@ -310,14 +182,18 @@ quit
 
 		public override bool DetectedFault()
 		{
-			string asan_log_path = Peach.Core.Runtime.SHARE.pathAsanReport + "." + strPid;
-			if (File.Exists(_gdbLog) || File.Exists(asan_log_path))
+			// Sanitizer output has already been streamed into memory by
+			// libpeachDebugger, so this is a copy rather than a file probe
+			if (_debugger != null && _report != null)
+				_report.Append(_debugger.ReadLog());
+
+			if (_IsCrashed() || (_report != null && _report.Complete))
 			{
-				logger.Info("DetectedFault - Caught fault with gdb");
+				logger.Info("DetectedFault - Caught fault with debugger");
 
 				_Stop();
 
-				byte[] bytes = File.ReadAllBytes(_gdbLog);
+				byte[] bytes = _debugger != null ? _debugger.Report() : new byte[0];
 				string output = Encoding.UTF8.GetString(bytes);
 
 				_fault = new Fault();
@@ -344,26 +220,31 @@ quit
 					_fault.title += ", " + other.Groups[1].Value;
 
 				_fault.collectedData["StackTrace.txt"] = bytes;
+				_fault.description = output;
 
-				// collect asan report
-				if(File.Exists(asan_log_path))
+				if (_report != null && _report.Detected)
 				{
-					Console.WriteLine("Fetching Asan Report from " + asan_log_path);
-					bytes = File.ReadAllBytes(asan_log_path);
+					// The signal of a sanitizer abort is raised from inside the
+					// runtime, the report says where the bug actually is
+					_fault.title = _report.Title;
+					_fault.majorHash = _report.MajorHash;
+					_fault.minorHash = _report.MinorHash;
+					_fault.exploitability = _report.Exploitability;
+
+					bytes = _report.ToArray();
 					_fault.collectedData["Asan_Report.txt"] = bytes;
-					if(Peach.Core.Runtime.SHARE.pathAsanReport.Equals(@"/tmp/peachAsanReport"))
-					{
-						System.IO.File.Delete(asan_log_path);
-					}
+					_fault.description = Encoding.UTF8.GetString(bytes) + "\n" + output;
+
+					// -asanLog=dir keeps a copy of every report.  The log path
+					// itself is the FIFO libpeachDebugger is still reading.
+					if (Peach.Core.Runtime.SHARE.keepAsanReports)
+						File.WriteAllBytes(Peach.Core.Runtime.SHARE.pathAsanReport + "." + strPid + ".report", bytes);
 				}
-				_fault.description = output;
 
 				return true;
 			}
 			
 			return _fault != null;
-
-			
 		}
 
 		public override Fault GetMonitorData()
@@ -379,20 +260,11 @@ quit
 		public override void StopMonitor()
 		{
 			_Stop();
+			_Close();
 		}
 
 		public override void SessionStarting()
 		{
-			_tmpPath = MakeTempDir();
-			_gdbCmd = Path.Combine(_tmpPath, "gdb.cmd");
-			_gdbPid = Path.Combine(_tmpPath, "gdb.pid");
-			_gdbLog = Path.Combine(_tmpPath, "gdb.log");
-
-			string cmd = string.Format(template, _gdbLog, Executable, Arguments, _exploitable, _gdbPid);
-			File.WriteAllText(_gdbCmd, cmd);
-
-			logger.Debug("Wrote gdb commands to '{0}'", _gdbCmd);
-
 			if (StartOnCall == null && !RestartOnEachTest)
 				_Start();
 		}
@@ -400,8 +272,7 @@ quit
 		public override void SessionFinished()
 		{
 			_Stop();
-
-			Directory.Delete(_tmpPath, true);
+			_Close();
 		}
 
 		public override bool IterationFinished()
@@ -0,0 +1,212 @@
+using System;
+using System.Collections;
+using System.Collections.Generic;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Text;
+
+namespace Peach.Core.OS.Linux
+{
+	/// <summary>
+	/// Target process traced by libpeachDebugger, see debugger.c.
+	/// </summary>
+	/// <remarks>
+	/// The library runs the target under ptrace from its own thread and
+	/// only stops it to collect registers and a backtrace when a thread
+	/// gets a crash signal.  All calls here only read the state it keeps.
+	/// </remarks>
+	public class NativeDebugger : IDisposable
+	{
+		public enum State
+		{
+			None = 0,
+			Running = 1,
+			Exited = 2,
+			Crashed = 3,
+		}
+
+		public enum IdleResult
+		{
+			Idle = 0,
+			Gone = 1,
+			Timeout = 2,
+		}
+
+		[DllImport("peachDebugger")]
+		static extern IntPtr dbg_create(string file, string[] argv, int argc, string[] envp, int envc);
+
+		[DllImport("peachDebugger")]
+		static extern void dbg_set_log(IntPtr dbg, string prefix);
+
+		[DllImport("peachDebugger")]
+		static extern int dbg_log(IntPtr dbg, byte[] buf, int size, int offset);
+
+		[DllImport("peachDebugger")]
+		static extern int dbg_start(IntPtr dbg);
+
+		[DllImport("peachDebugger")]
+		static extern int dbg_state(IntPtr dbg);
+
+		[DllImport("peachDebugger")]
+		static extern int dbg_status(IntPtr dbg);
+
+		[DllImport("peachDebugger")]
+		static extern int dbg_report(IntPtr dbg, byte[] buf, int size);
+
+		[DllImport("peachDebugger")]
+		static extern int dbg_wait(IntPtr dbg, int timeout);
+
+		[DllImport("peachDebugger")]
+		static extern int dbg_wait_idle(IntPtr dbg, int timeout, int interval);
+
+		[DllImport("peachDebugger")]
+		static extern void dbg_stop(IntPtr dbg, int grace);
+
+		[DllImport("peachDebugger")]
+		static extern void dbg_destroy(IntPtr dbg);
+
+		const int ReportSize = 16384;
+
+		IntPtr _dbg;
+		int _logOffset = 0;
+		byte[] _logBuf = new byte[ReportSize];
+
+		/// <summary>
+		/// Run 'executable' with 'arguments' split the way a shell would.
+		/// </summary>
+		/// <param name="executable">Program to run</param>
+		/// <param name="arguments">Command line arguments</param>
+		/// <param name="environment">Variables added to the current environment</param>
+		public NativeDebugger(string executable, string arguments, IDictionary<string, string> environment)
+		{
+			// The shell exec()s the target in place, so the pid and the
+			// trace carry over to it
+			var argv = new string[] { "/bin/sh", "-c", "exec \"$0\" " + arguments, executable };
+
+			var env = new Dictionary<string, string>();
+			foreach (DictionaryEntry de in Environment.GetEnvironmentVariables())
+				env[(string)de.Key] = (string)de.Value;
+
+			if (environment != null)
+			{
+				foreach (var kv in environment)
+					env[kv.Key] = kv.Value;
+			}
+
+			var envp = new List<string>();
+			foreach (var kv in env)
+				envp.Add(kv.Key + "=" + kv.Value);
+
+			_dbg = dbg_create(argv[0], argv, argv.Length, envp.ToArray(), envp.Count);
+		}
+
+		/// <summary>
+		/// Pid of the target, 0 until started.
+		/// </summary>
+		public int Pid { get; private set; }
+
+		public State CurrentState
+		{
+			get { return (State)dbg_state(_dbg); }
+		}
+
+		/// <summary>
+		/// Exit code of the target once it is gone, or 256 plus the
+		/// signal number if a signal killed it.
+		/// </summary>
+		public int ExitStatus
+		{
+			get { return dbg_status(_dbg); }
+		}
+
+		/// <summary>
+		/// Stream sanitizer reports written to 'prefix'.&lt;pid&gt; instead
+		/// of leaving them on disk, see ReadLog().  Call before Start().
+		/// </summary>
+		public void SetLog(string prefix)
+		{
+			dbg_set_log(_dbg, prefix);
+		}
+
+		/// <summary>
+		/// Sanitizer output received since the last call.
+		/// </summary>
+		public byte[] ReadLog()
+		{
+			var ret = new MemoryStream();
+
+			for (;;)
+			{
+				int len = dbg_log(_dbg, _logBuf, _logBuf.Length, _logOffset);
+				if (len <= 0)
+					break;
+
+				_logOffset += len;
+				ret.Write(_logBuf, 0, len);
+			}
+
+			return ret.ToArray();
+		}
+
+		/// <summary>
+		/// Start the target, returns false if it could not be started.
+		/// </summary>
+		public bool Start()
+		{
+			int pid = dbg_start(_dbg);
+			if (pid <= 0)
+				return false;
+
+			Pid = pid;
+			return CurrentState != State.Exited || ExitStatus != 127;
+		}
+
+		/// <summary>
+		/// Crash report of the target, empty unless it crashed.
+		/// </summary>
+		public byte[] Report()
+		{
+			var buf = new byte[ReportSize];
+			int len = dbg_report(_dbg, buf, buf.Length);
+
+			var ret = new byte[len];
+			Buffer.BlockCopy(buf, 0, ret, 0, len);
+			return ret;
+		}
+
+		/// <summary>
+		/// Wait up to 'timeout' ms (-1 is infinite) for the target to exit.
+		/// </summary>
+		/// <returns>Returns true if the target is gone.</returns>
+		public bool WaitForExit(int timeout)
+		{
+			return (State)dbg_wait(_dbg, timeout) != State.Running;
+		}
+
+		/// <summary>
+		/// Wait up to 'timeout' ms (-1 is infinite) for the target to exit
+		/// or stop using the cpu, sampled every 'interval' ms.
+		/// </summary>
+		public IdleResult WaitForIdle(int timeout, int interval)
+		{
+			return (IdleResult)dbg_wait_idle(_dbg, timeout, interval);
+		}
+
+		/// <summary>
+		/// Terminate the target, killing it after 'grace' ms.
+		/// </summary>
+		public void Stop(int grace)
+		{
+			dbg_stop(_dbg, grace);
+		}
+
+		public void Dispose()
+		{
+			if (_dbg == IntPtr.Zero)
+				return;
+
+			dbg_destroy(_dbg);
+			_dbg = IntPtr.Zero;
+		}
+	}
+}
@@ -21,6 +21,7 @@ namespace Peach.Core.Publishers
 	[Parameter("Timeout", typeof(int), "How many milliseconds to wait for data/connection (default 3000)", "3000")]
 	[Parameter("MinMTU", typeof(uint), "Minimum allowable MTU property value", SocketPublisher.DefaultMinMTU)]
 	[Parameter("MaxMTU", typeof(uint), "Maximum allowable MTU property value", SocketPublisher.DefaultMaxMTU)]
+	[Parameter("Batch", typeof(bool), "Queue consecutive outputs and send them with one sendmmsg (default false)", "false")]
 	public class RawEtherPublisher : Publisher
 	{
 #region Ethernet Protocols
@@ -151,6 +152,35 @@ namespace Peach.Core.Publishers
 		[DllImport("libc", SetLastError = true)]
 		private static extern int ioctl(int fd, int request, ref ifreq mtu);
 
+		[StructLayout(LayoutKind.Sequential)]
+		struct iovec
+		{
+			public IntPtr iov_base;
+			public UIntPtr iov_len;
+		}
+
+		[StructLayout(LayoutKind.Sequential)]
+		struct msghdr
+		{
+			public IntPtr msg_name;
+			public uint msg_namelen;
+			public IntPtr msg_iov;
+			public UIntPtr msg_iovlen;
+			public IntPtr msg_control;
+			public UIntPtr msg_controllen;
+			public int msg_flags;
+		}
+
+		[StructLayout(LayoutKind.Sequential)]
+		struct mmsghdr
+		{
+			public msghdr msg_hdr;
+			public uint msg_len;
+		}
+
+		[DllImport("libc", SetLastError = true)]
+		private static extern int sendmmsg(int fd, IntPtr msgvec, uint vlen, int flags);
+
 #endregion
 
 		public string Interface { get; set; }
@@ -158,6 +188,7 @@ namespace Peach.Core.Publishers
 		public int Timeout { get; set; }
 		public uint MinMTU { get; set; }
 		public uint MaxMTU { get; set; }
+		public bool Batch { get; set; }
 
 		private static NLog.Logger logger = LogManager.GetCurrentClassLogger();
 		protected override NLog.Logger Logger { get { return logger; } }
@@ -173,6 +204,7 @@ namespace Peach.Core.Publishers
 		private int _bufferSize = 0;
 		private uint _mtu = 0;
 		private uint orig_mtu = 0;
+		private PacketBatch _batch = new PacketBatch();
 
 		public RawEtherPublisher(Dictionary<string, Variant> args)
 			: base(args)
@@ -344,8 +376,22 @@ namespace Peach.Core.Publishers
 			}
 		}
 
+		public override bool IsBatching
+		{
+			get { return Batch; }
+		}
+
 		protected override void OnOutput(byte[] buf, int offset, int count)
 		{
+			if (Batch)
+			{
+				if (Logger.IsDebugEnabled)
+					Logger.Debug("\n\n" + Utilities.HexDump(buf, offset, count));
+
+				_batch.Add(buf, offset, count);
+				return;
+			}
+
 			int size = count;
 
 			Pollfd[] fds = new Pollfd[1];
@@ -394,6 +440,119 @@ namespace Peach.Core.Publishers
 			}
 		}
 
+		protected override void OnFlush()
+		{
+			try
+			{
+				if (_batch.Count > 0)
+					SendBatch();
+			}
+			finally
+			{
+				_batch.Clear();
+			}
+		}
+
+		/// <summary>
+		/// Send every queued frame, as many per sendmmsg call as the
+		/// socket will take.
+		/// </summary>
+		private void SendBatch()
+		{
+			var packets = _batch.Packets;
+			int count = packets.Count;
+
+			var pins = new GCHandle[count + 2];
+			var iov = new iovec[count];
+			var msgs = new mmsghdr[count];
+
+			try
+			{
+				for (int i = 0; i < count; ++i)
+				{
+					pins[i] = GCHandle.Alloc(packets[i].Array, GCHandleType.Pinned);
+					iov[i].iov_base = IntPtr.Add(pins[i].AddrOfPinnedObject(), packets[i].Offset);
+					iov[i].iov_len = new UIntPtr((uint)packets[i].Count);
+				}
+
+				pins[count] = GCHandle.Alloc(iov, GCHandleType.Pinned);
+				pins[count + 1] = GCHandle.Alloc(msgs, GCHandleType.Pinned);
+
+				IntPtr iovPtr = pins[count].AddrOfPinnedObject();
+				IntPtr msgPtr = pins[count + 1].AddrOfPinnedObject();
+				int iovSize = Marshal.SizeOf(typeof(iovec));
+				int msgSize = Marshal.SizeOf(typeof(mmsghdr));
+
+				for (int i = 0; i < count; ++i)
+				{
+					msgs[i].msg_hdr.msg_iov = IntPtr.Add(iovPtr, i * iovSize);
+					msgs[i].msg_hdr.msg_iovlen = new UIntPtr(1);
+				}
+
+				Pollfd[] fds = new Pollfd[1];
+				fds[0].fd = _socket.Handle;
+				fds[0].events = PollEvents.POLLOUT;
+
+				int expires = Environment.TickCount + Timeout;
+				int sent = 0;
+
+				while (sent < count)
+				{
+					fds[0].revents = 0;
+
+					int ret = Syscall.poll(fds, Math.Max(0, expires - Environment.TickCount));
+
+					if (UnixMarshal.ShouldRetrySyscall(ret))
+						continue;
+
+					UnixMarshal.ThrowExceptionForLastErrorIf(ret);
+
+					if (ret == 0)
+						throw new TimeoutException();
+
+					if (ret != 1 || (fds[0].revents & PollEvents.POLLOUT) == 0)
+						continue;
+
+					ret = sendmmsg(_socket.Handle, IntPtr.Add(msgPtr, sent * msgSize), (uint)(count - sent), 0);
+
+					if (ret == -1 && Stdlib.GetLastError() == Errno.ENOSYS)
+					{
+						// Kernel predates sendmmsg, send one frame at a time
+						for (; sent < count; ++sent)
+							_socket.Write(packets[sent].Array, packets[sent].Offset, packets[sent].Count);
+
+						break;
+					}
+
+					if (UnixMarshal.ShouldRetrySyscall(ret))
+						continue;
+
+					UnixMarshal.ThrowExceptionForLastErrorIf(ret);
+
+					sent += ret;
+				}
+
+				Logger.Debug("Sent batch of {0} frames on {1}.", count, Interface);
+			}
+			catch (Exception ex)
+			{
+				if (ex is TimeoutException)
+					Logger.Debug("Ethernet batch not sent to {0} in {1}ms, timing out.", Interface, Timeout);
+				else
+					Logger.Error("Unable to send ethernet batch to {0}. {1}", Interface, ex.Message);
+
+				throw new SoftException(ex);
+			}
+			finally
+			{
+				foreach (var pin in pins)
+				{
+					if (pin.IsAllocated)
+						pin.Free();
+				}
+			}
+		}
+
 #region Read Stream
 
 		public override bool CanRead
@@ -0,0 +1,87 @@
+using System;
+using System.Collections.Generic;
+
+using Peach.Core;
+using Peach.Core.Agent.Channels;
+
+using NUnit;
+using NUnit.Framework;
+
+namespace Peach.Core.Test.Agent
+{
+	[TestFixture]
+	public class AgentZeroMqTests
+	{
+		static AgentMessageZeroMq RoundTrip(AgentMessageZeroMq msg)
+		{
+			var buf = msg.Encode();
+			return AgentMessageZeroMq.Decode(buf, buf.Length);
+		}
+
+		[Test]
+		public void Primitives()
+		{
+			var msg = new AgentMessageZeroMq();
+			msg.Method = "IterationStarting";
+			msg.Arguments = new object[] { 42u, true, -7, "str", new byte[] { 1, 2, 3 }, null };
+
+			var ret = RoundTrip(msg);
+
+			Assert.AreEqual("IterationStarting", ret.Method);
+			Assert.AreEqual(6, ret.Arguments.Length);
+			Assert.AreEqual(typeof(uint), ret.Arguments[0].GetType());
+			Assert.AreEqual(42u, ret.Arguments[0]);
+			Assert.AreEqual(true, ret.Arguments[1]);
+			Assert.AreEqual(-7, ret.Arguments[2]);
+			Assert.AreEqual("str", ret.Arguments[3]);
+			Assert.AreEqual(new byte[] { 1, 2, 3 }, ret.Arguments[4]);
+			Assert.Null(ret.Arguments[5]);
+			Assert.Null(ret.Parameters);
+
+			// Per-iteration calls stay small
+			msg.Arguments = new object[] { 42u, true };
+			Assert.Less(msg.Encode().Length, 40);
+		}
+
+		[Test]
+		public void NoArguments()
+		{
+			var msg = new AgentMessageZeroMq();
+			msg.Method = "ACK";
+
+			var ret = RoundTrip(msg);
+
+			Assert.AreEqual("ACK", ret.Method);
+			Assert.Null(ret.Arguments);
+		}
+
+		[Test]
+		public void Objects()
+		{
+			var fault = new Fault();
+			fault.title = "Title";
+			fault.description = "Description";
+
+			var msg = new AgentMessageZeroMq();
+			msg.Method = "StartMonitor";
+			msg.Arguments = new object[] { new Fault[] { fault }, new Exception("Boom") };
+			msg.Parameters = new SerializableDictionary<string, Variant>();
+			msg.Parameters["Executable"] = new Variant("foo.exe");
+
+			var ret = RoundTrip(msg);
+
+			var faults = ret.Arguments[0] as Fault[];
+			Assert.NotNull(faults);
+			Assert.AreEqual(1, faults.Length);
+			Assert.AreEqual("Title", faults[0].title);
+			Assert.AreEqual("Description", faults[0].description);
+
+			var ex = ret.Arguments[1] as Exception;
+			Assert.NotNull(ex);
+			Assert.AreEqual("Boom", ex.Message);
+
+			Assert.NotNull(ret.Parameters);
+			Assert.AreEqual("foo.exe", (string)ret.Parameters["Executable"]);
+		}
+	}
+}
@@ -0,0 +1,132 @@
+using System;
+using System.Collections.Generic;
+using System.Text;
+
+using Peach.Core;
+using Peach.Core.Agent;
+
+using NUnit;
+using NUnit.Framework;
+
+namespace Peach.Core.Test.Agent
+{
+	[TestFixture]
+	public class SanitizerReportTests
+	{
+		const string HeapOverflowReport = @"=================================================================
+==32021==ERROR: AddressSanitizer: heap-buffer-overflow on address 0x602000000018 at pc 0x55e161a421ea bp 0x7ffd6fbbbc30 sp 0x7ffd6fbbbc28
+READ of size 1 at 0x602000000018 thread T0
+    #0 0x55e161a421e9 in bad /tmp/asan.c:3
+    #1 0x55e161a4225e in main /tmp/asan.c:4
+    #2 0x7fb7e5245249  (/lib/x86_64-linux-gnu/libc.so.6+0x27249)
+
+0x602000000018 is located 0 bytes to the right of 8-byte region [0x602000000010,0x602000000018)
+allocated by thread T0 here:
+    #0 0x7fb7e54b89cf in __interceptor_malloc asan_malloc_linux.cpp:69
+    #1 0x55e161a4220a in main /tmp/asan.c:4
+
+SUMMARY: AddressSanitizer: heap-buffer-overflow /tmp/asan.c:3 in bad
+Shadow bytes around the buggy address:
+";
+
+		const string SegvReport = @"==7==ERROR: AddressSanitizer: SEGV on unknown address 0x000000000010 (pc 0x0000004f1c2a bp 0x7ffc sp 0x7ffc T0)
+==7==The signal is caused by a WRITE memory access.
+    #0 0x4f1c2a in parse src/parse.c:120:9
+    #1 0x4f0001 in main src/main.c:10:3
+
+SUMMARY: AddressSanitizer: SEGV src/parse.c:120:9 in parse
+";
+
+		const string UbsanReport = @"src/mul.c:7:12: runtime error: signed integer overflow: 2147483647 * 2 cannot be represented in type 'int'
+    #0 0x4c5d12 in mul src/mul.c:7:12
+    #1 0x4c5e00 in main src/main.c:4:5
+
+SUMMARY: UndefinedBehaviorSanitizer: undefined-behavior src/mul.c:7:12 in
+";
+
+		static SanitizerReport Parse(string text, int chunk)
+		{
+			var buf = Encoding.UTF8.GetBytes(text);
+			var ret = new SanitizerReport();
+
+			for (int i = 0; i < buf.Length; i += chunk)
+				ret.Append(buf, i, Math.Min(chunk, buf.Length - i));
+
+			return ret;
+		}
+
+		[Test]
+		public void HeapOverflow()
+		{
+			var r = Parse(HeapOverflowReport, 7);
+
+			Assert.True(r.Complete);
+			Assert.AreEqual("AddressSanitizer", r.Tool);
+			Assert.AreEqual("heap-buffer-overflow", r.BugType);
+			Assert.AreEqual("READ", r.Access);
+			Assert.AreEqual(1, r.AccessSize);
+			Assert.AreEqual(0x55e161a421eaUL, r.Pc);
+			Assert.AreEqual(new string[] {
+				"bad /tmp/asan.c:3",
+				"main /tmp/asan.c:4",
+				"(/lib/x86_64-linux-gnu/libc.so.6+0x27249)" }, r.Frames);
+			Assert.AreEqual("AddressSanitizer: heap-buffer-overflow READ of size 1 in bad /tmp/asan.c:3", r.Title);
+			Assert.AreEqual("PROBABLY_EXPLOITABLE", r.Exploitability);
+			Assert.AreEqual(Encoding.UTF8.GetBytes(HeapOverflowReport), r.ToArray());
+
+			// Same bug, different addresses
+			var other = Parse(HeapOverflowReport.Replace("0x55e161a421e9", "0x55aaaaaa21e9"), 1000);
+			Assert.AreEqual(r.MajorHash, other.MajorHash);
+			Assert.AreEqual(r.MinorHash, other.MinorHash);
+		}
+
+		[Test]
+		public void Incremental()
+		{
+			var buf = Encoding.UTF8.GetBytes(HeapOverflowReport);
+			int summary = HeapOverflowReport.IndexOf("SUMMARY");
+
+			var r = new SanitizerReport();
+			Assert.False(r.Detected);
+
+			r.Append(buf, 0, summary);
+			Assert.True(r.Detected);
+			Assert.False(r.Complete);
+			Assert.AreEqual(3, r.Frames.Count);
+
+			// Half a line is not parsed
+			r.Append(buf, summary, 10);
+			Assert.False(r.Complete);
+
+			r.Append(buf, summary + 10, buf.Length - summary - 10);
+			Assert.True(r.Complete);
+		}
+
+		[Test]
+		public void Segv()
+		{
+			var r = Parse(SegvReport, 3);
+
+			Assert.True(r.Complete);
+			Assert.AreEqual("SEGV", r.BugType);
+			Assert.AreEqual("WRITE", r.Access);
+			Assert.AreEqual(0x4f1c2aUL, r.Pc);
+			Assert.AreEqual(2, r.Frames.Count);
+			Assert.AreEqual("PROBABLY_EXPLOITABLE", r.Exploitability);
+		}
+
+		[Test]
+		public void Ubsan()
+		{
+			var r = Parse(UbsanReport, 5);
+
+			Assert.True(r.Complete);
+			Assert.AreEqual("UndefinedBehaviorSanitizer", r.Tool);
+			Assert.AreEqual("src/mul.c:7:12", r.Location);
+			Assert.That(r.BugType.StartsWith("signed integer overflow"));
+			Assert.AreEqual(0x4c5d12UL, r.Pc);
+			Assert.AreEqual("mul src/mul.c:7:12", r.Frames[0]);
+			Assert.AreEqual("PROBABLY_NOT_EXPLOITABLE", r.Exploitability);
+		}
+	}
+}
@@ -0,0 +1,279 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Linq;
+using System.Reflection;
+using System.Text;
+
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+
+using Peach.Core;
+using Peach.Core.Analyzers;
+using Peach.Core.Dom;
+using Peach.Core.Loggers;
+using Peach.Core.Publishers;
+using Peach.Core.Runtime;
+
+namespace Peach.Core.Test.Benchmarks
+{
+	/// <summary>
+	/// Fuzzes the sample pits against an in process target and reports the
+	/// engine throughput, allocations, GC counts and time per phase.
+	/// </summary>
+	/// <remarks>
+	/// Not run with the other tests, select it with
+	/// nunit-console Peach.Core.Test.dll /run=Peach.Core.Test.Benchmarks
+	/// The samples folder is found next to the build output or taken from
+	/// PEACH_SAMPLES.  Needs the peachControl library.
+	/// </remarks>
+	[TestFixture, Explicit("Benchmark"), Category("Benchmark")]
+	class EngineBenchmarks
+	{
+		const uint Iterations = 200;
+		const uint Seed = 31337;
+
+		/// <summary>
+		/// Stands in for an instrumented target.  Every byte of the input
+		/// hits an edge picked by its offset and value, so mutations find
+		/// new paths the way a byte at a time parser would.
+		/// </summary>
+		class FakeTarget : NullPublisher
+		{
+			const int Depth = 256;
+
+			MemoryMappedViewAccessor _map;
+
+			public FakeTarget(MemoryMappedViewAccessor map)
+				: base(new Dictionary<string, Variant>())
+			{
+				_map = map;
+			}
+
+			protected override void OnOutput(byte[] buffer, int offset, int count)
+			{
+				uint prev = 0;
+
+				for (int i = 0; i < Math.Min(count, Depth); ++i)
+				{
+					uint cur = ((uint)i * 257 + buffer[offset + i]) * 2654435761;
+					long edge = ((cur >> 1) ^ prev) % Dom.Action.MapSize;
+					prev = cur;
+
+					_map.Write(edge, (byte)(_map.ReadByte(edge) + 1));
+				}
+			}
+		}
+
+		string samples;
+		string tmp;
+		string mapFile;
+		MemoryMappedFile mmf;
+		MemoryMappedViewAccessor map;
+
+		[TestFixtureSetUp]
+		public void SetUp()
+		{
+			samples = FindSamples();
+			if (samples == null)
+				Assert.Ignore("Unable to find the samples folder, set PEACH_SAMPLES.");
+
+			tmp = Path.Combine(Path.GetTempPath(), "peach-bench-" + Path.GetRandomFileName());
+			Directory.CreateDirectory(tmp);
+
+			mapFile = Path.Combine(tmp, "map");
+			using (var fs = new FileStream(mapFile, FileMode.Create))
+				fs.SetLength(Dom.Action.MapSize);
+
+			mmf = MemoryMappedFile.CreateFromFile(mapFile, FileMode.Open);
+			map = mmf.CreateViewAccessor(0, Dom.Action.MapSize);
+
+			Environment.SetEnvironmentVariable("SHM_ENV_VAR", mapFile);
+
+			SHARE.pathSrc = Path.Combine(tmp, "peachPath");
+			SHARE.pathSSrc = Path.Combine(tmp, "peachBranch");
+			SHARE.pathWather = Path.Combine(tmp, "peachWather");
+
+			// Only measure the engine, not the waits for a real target
+			Dom.Action.OutputSettleTime = 0;
+			Dom.Action.TargetPollInterval = 0;
+		}
+
+		[TestFixtureTearDown]
+		public void TearDown()
+		{
+			Dom.Action.OutputSettleTime = 100;
+			Dom.Action.TargetPollInterval = 10;
+
+			SHARE.pathSrc = @"/tmp/peachPath";
+			SHARE.pathSSrc = @"/tmp/peachBranch";
+			SHARE.pathWather = @"/tmp/peachWather";
+
+			if (map != null)
+				map.Dispose();
+			if (mmf != null)
+				mmf.Dispose();
+			if (tmp != null)
+				Directory.Delete(tmp, true);
+		}
+
+		[TearDown]
+		public void ResetShare()
+		{
+			Profiler.Enabled = false;
+			Profiler.Reset();
+
+			SHARE.ifuse = false;
+			SHARE.dataModelsToMutate.Clear();
+			SHARE.dataModelsToMutateIndex.Clear();
+			SHARE.valuableDataModels.Clear();
+			SHARE.seedPoolIndexQueue.Clear();
+			SHARE.seedPoolIndexQueueCopy.Clear();
+			SHARE.seedPoolIndex = 0;
+			SHARE.queueEntryIndex = 0;
+			SHARE.queueLengthBeforeIteration = 0;
+			SHARE.seed_pool_to_use_cnt = 0;
+			SHARE.cur_path = 0;
+			Engine.total_branch = 0;
+		}
+
+		[Test]
+		public void HelloWorld()
+		{
+			Run("HelloWorld.xml");
+		}
+
+		[Test]
+		public void IEC104()
+		{
+			Run("IEC104.xml");
+		}
+
+		[Test]
+		public void IEC61850()
+		{
+			Run("61850.xml");
+		}
+
+		[Test]
+		public void DNP3()
+		{
+			Run("dnp.xml");
+		}
+
+		void Run(string pit)
+		{
+			string fileName = Path.Combine(samples, pit);
+			if (!File.Exists(fileName))
+				Assert.Ignore("Unable to find '" + fileName + "'.");
+
+			var dom = new PitParser().asParser(null, fileName);
+			var test = dom.tests[0];
+
+			test.agents.Clear();
+
+			var keys = test.publishers.Keys.ToList();
+			test.publishers.Clear();
+			foreach (var key in keys)
+				test.publishers.Add(key, new FakeTarget(map));
+
+			// PeachStar saves seeds through the first logger
+			var args = new Dictionary<string, Variant>();
+			args["Path"] = new Variant(Path.Combine(tmp, "logs"));
+			test.loggers.Clear();
+			test.loggers.Add(new FileLogger(args));
+
+			var config = new RunConfiguration();
+			config.pitFile = fileName;
+			config.range = true;
+			config.rangeStart = 1;
+			config.rangeStop = Iterations;
+			config.randomSeed = Seed;
+
+			// Maps the coverage file and resets the virgin bits
+			Assert.AreEqual(1, Program.init());
+			SHARE.ifuse = true;
+
+			long execs = 0;
+			var e = new Engine(null);
+			e.IterationStarting += delegate(RunContext context, uint currentIteration, uint currentSubIteration, uint? totalIterations)
+			{
+				++execs;
+			};
+
+			bool monitoring = EnableMonitoring();
+			long allocated = monitoring ? AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize : 0;
+			int[] collections = Enumerable.Range(0, GC.MaxGeneration + 1).Select(g => GC.CollectionCount(g)).ToArray();
+
+			Profiler.Reset();
+			Profiler.Enabled = true;
+
+			var sw = Stopwatch.StartNew();
+			e.startFuzzing(dom, config);
+			sw.Stop();
+
+			Profiler.Enabled = false;
+
+			Assert.Greater(execs, 0);
+
+			var sb = new StringBuilder();
+			sb.AppendFormat("{0}: {1} iterations, {2} execs in {3:0.00}s, {4:0.0} iterations/sec, {5:0.0} execs/sec",
+				pit, Iterations, execs, sw.Elapsed.TotalSeconds,
+				Iterations / sw.Elapsed.TotalSeconds, execs / sw.Elapsed.TotalSeconds);
+			sb.AppendLine();
+
+			if (monitoring)
+				sb.AppendFormat("  allocated {0:0.0} KB/exec",
+					(AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize - allocated) / 1024.0 / execs);
+			else
+				sb.Append("  allocated n/a");
+
+			sb.AppendFormat(", GC {0}", string.Join("/",
+				collections.Select((c, g) => (GC.CollectionCount(g) - c).ToString()).ToArray()));
+			sb.AppendLine();
+
+			foreach (ProfilePhase phase in Enum.GetValues(typeof(ProfilePhase)))
+			{
+				var total = Profiler.Total(phase);
+				sb.AppendFormat("  {0,-9} {1,10:0.000} ms {2,10:0.0} us/exec {3,8} times",
+					phase.ToString().ToLower(), total.TotalMilliseconds,
+					total.TotalMilliseconds * 1000 / execs, Profiler.Count(phase));
+				sb.AppendLine();
+			}
+
+			Console.Write(sb.ToString());
+		}
+
+		static bool EnableMonitoring()
+		{
+			try
+			{
+				AppDomain.MonitoringIsEnabled = true;
+				return AppDomain.MonitoringIsEnabled;
+			}
+			catch (NotImplementedException)
+			{
+				return false;
+			}
+		}
+
+		static string FindSamples()
+		{
+			string env = Environment.GetEnvironmentVariable("PEACH_SAMPLES");
+			if (!string.IsNullOrEmpty(env))
+				return env;
+
+			var dir = new DirectoryInfo(Path.GetDirectoryName(Assembly.GetExecutingAssembly().Location));
+			for (; dir != null; dir = dir.Parent)
+			{
+				string candidate = Path.Combine(dir.FullName, "samples");
+				if (File.Exists(Path.Combine(candidate, "HelloWorld.xml")))
+					return candidate;
+			}
+
+			return null;
+		}
+	}
+}
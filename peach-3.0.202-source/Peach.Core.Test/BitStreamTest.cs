@@ -894,5 +894,123 @@ namespace Peach.Core.Test
 			Assert.AreEqual(new byte[] { 0xcc, 0xd1, 0x14 }, in3.Value);
 		}
 
+		[Test]
+		public void AlignedMatchesUnaligned()
+		{
+			byte[] data = new byte[] { 0x01, 0x80, 0xff, 0x7e, 0x42, 0x00, 0xa5 };
+
+			// Aligned block writes mixed with bit writes
+			var aligned = new BitStream();
+			aligned.WriteBytes(data);
+			aligned.WriteBits(0x5, 3);
+			aligned.WriteBits(0x1234, 16);
+			aligned.WriteBits(0x1f, 5);
+			aligned.WriteBits(0xdeadbeef, 32);
+			aligned.WriteBytes(data, 2, 5);
+
+			// Same values, one bit at a time
+			var slow = new BitStream();
+			foreach (byte b in data)
+				for (int i = 7; i >= 0; --i)
+					slow.WriteBit((byte)((b >> i) & 1));
+			slow.WriteBits(0x5, 3);
+			for (int i = 15; i >= 0; --i)
+				slow.WriteBit((byte)((0x1234 >> i) & 1));
+			slow.WriteBits(0x1f, 5);
+			for (int i = 31; i >= 0; --i)
+				slow.WriteBit((byte)((0xdeadbeef >> i) & 1));
+			for (int i = 2; i < 5; ++i)
+				slow.WriteBits(data[i], 8);
+
+			Assert.AreEqual(slow.LengthBits, aligned.LengthBits);
+			Assert.AreEqual(slow.Value, aligned.Value);
+
+			aligned.SeekBits(0, SeekOrigin.Begin);
+			Assert.AreEqual(data, aligned.ReadBytes(data.Length));
+			Assert.AreEqual(0x5, aligned.ReadBits(3));
+			Assert.AreEqual(0x1234, aligned.ReadBits(16));
+			Assert.AreEqual(0x1f, aligned.ReadBits(5));
+			Assert.AreEqual(0xdeadbeef, aligned.ReadBits(32));
+			Assert.AreEqual(new byte[] { 0xff, 0x7e, 0x42 }, aligned.ReadBytes(3));
+			Assert.AreEqual(aligned.LengthBits, aligned.TellBits());
+
+			// Aligned overwrite in the middle keeps the length
+			aligned.SeekBits(8, SeekOrigin.Begin);
+			aligned.WriteBytes(new byte[] { 0xaa, 0xbb });
+			Assert.AreEqual(slow.LengthBits, aligned.LengthBits);
+			aligned.SeekBits(0, SeekOrigin.Begin);
+			Assert.AreEqual(new byte[] { 0x01, 0xaa, 0xbb, 0x7e }, aligned.ReadBytes(4));
+
+			aligned.SeekBits(0, SeekOrigin.Begin);
+			Assert.Throws<ApplicationException>(delegate() { aligned.ReadBytes(100); });
+		}
+
+		[Test]
+		public void AlignedThroughput()
+		{
+			const int iterations = 2000;
+			byte[] block = new byte[1024];
+			for (int i = 0; i < block.Length; ++i)
+				block[i] = (byte)i;
+
+			var sw = System.Diagnostics.Stopwatch.StartNew();
+			for (int i = 0; i < iterations; ++i)
+			{
+				var bs = new BitStream();
+				bs.WriteBytes(block);
+				bs.SeekBits(0, SeekOrigin.Begin);
+				bs.ReadBytes(block.Length);
+			}
+			sw.Stop();
+			Console.WriteLine("Aligned 1KiB write/read: {0:0.000} us/iteration",
+				sw.Elapsed.TotalMilliseconds * 1000 / iterations);
+
+			sw = System.Diagnostics.Stopwatch.StartNew();
+			for (int i = 0; i < iterations; ++i)
+			{
+				var bs = new BitStream();
+				bs.WriteBit(0);
+				bs.WriteBytes(block);
+				bs.SeekBits(1, SeekOrigin.Begin);
+				bs.ReadBytes(block.Length);
+			}
+			sw.Stop();
+			Console.WriteLine("Unaligned 1KiB write/read: {0:0.000} us/iteration",
+				sw.Elapsed.TotalMilliseconds * 1000 / iterations);
+		}
+
+		[Test]
+		public void ElementPositionThroughput()
+		{
+			// Deeply nested element, fullName lookups dominate marking
+			Peach.Core.Dom.DataElement elem = new Peach.Core.Dom.Blob("leaf");
+			for (int i = 0; i < 16; ++i)
+			{
+				var blk = new Peach.Core.Dom.Block("blk" + i);
+				blk.Add(elem);
+				elem = blk;
+			}
+
+			while (elem is Peach.Core.Dom.Block)
+				elem = ((Peach.Core.Dom.Block)elem)[0];
+
+			Assert.AreEqual(17, elem.fullName.Split('.').Length);
+
+			const int iterations = 20000;
+			var bs = new BitStream();
+			var sw = System.Diagnostics.Stopwatch.StartNew();
+			for (int i = 0; i < iterations; ++i)
+			{
+				bs.MarkStartOfElement(elem);
+				bs.WriteByte(0);
+				bs.MarkEndOfElement(elem);
+			}
+			sw.Stop();
+			Console.WriteLine("Mark start/end depth 17: {0:0.000} us/iteration",
+				sw.Elapsed.TotalMilliseconds * 1000 / iterations);
+
+			Assert.AreEqual((iterations - 1) * 8, bs.DataElementPosition(elem));
+			Assert.AreEqual(iterations * 8, bs.DataElementLength(elem));
+		}
 	}
 }
@@ -0,0 +1,78 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+using Peach.Core.IO;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class BufferPoolTests
+	{
+		[Test]
+		public void RentRoundsUp()
+		{
+			Assert.AreEqual(256, BufferPool.Rent(0).Length);
+			Assert.AreEqual(256, BufferPool.Rent(256).Length);
+			Assert.AreEqual(512, BufferPool.Rent(257).Length);
+			Assert.AreEqual(1024 * 1024, BufferPool.Rent(1000 * 1000).Length);
+
+			Assert.Throws<ArgumentOutOfRangeException>(delegate() { BufferPool.Rent(-1); });
+		}
+
+		[Test]
+		public void ReturnReuses()
+		{
+			var buf = BufferPool.Rent(3000);
+			Assert.AreEqual(4096, buf.Length);
+
+			BufferPool.Return(buf);
+			Assert.AreSame(buf, BufferPool.Rent(4000));
+		}
+
+		[Test]
+		public void OversizeNotRetained()
+		{
+			var buf = BufferPool.Rent(2 * 1024 * 1024 + 1);
+			Assert.AreEqual(2 * 1024 * 1024 + 1, buf.Length);
+
+			BufferPool.Return(buf);
+			Assert.AreNotSame(buf, BufferPool.Rent(2 * 1024 * 1024 + 1));
+
+			// Arrays that did not come from the pool are ignored
+			var odd = new byte[300];
+			BufferPool.Return(odd);
+			Assert.AreNotSame(odd, BufferPool.Rent(300));
+		}
+
+		[Test]
+		public void GetBuffer()
+		{
+			var ms = new MemoryStream();
+			ms.Write(new byte[] { 1, 2, 3 }, 0, 3);
+			Assert.AreSame(ms.GetBuffer(), BufferPool.GetBuffer(ms));
+
+			var ro = new MemoryStream(new byte[] { 1, 2, 3 });
+			Assert.Null(BufferPool.GetBuffer(ro));
+		}
+
+		[Test]
+		public void CopyTo()
+		{
+			var src = new MemoryStream(new byte[] { 1, 2, 3, 4 }, 0, 4, false, true);
+			src.Position = 1;
+			var dst = new MemoryStream();
+			BitStream.CopyTo(src, dst);
+			Assert.AreEqual(new byte[] { 2, 3, 4 }, dst.ToArray());
+			Assert.AreEqual(4, src.Position);
+
+			src = new MemoryStream(new byte[] { 5, 6 });
+			dst = new MemoryStream();
+			BitStream.CopyTo(src, dst);
+			Assert.AreEqual(new byte[] { 5, 6 }, dst.ToArray());
+		}
+	}
+}
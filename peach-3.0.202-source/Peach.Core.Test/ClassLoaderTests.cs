@@ -0,0 +1,87 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+using Peach.Core;
+using Peach.Core.Agent;
+using Peach.Core.Publishers;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class ClassLoaderTests
+	{
+		[Test]
+		public void FindTypeByAttribute()
+		{
+			var type = ClassLoader.FindTypeByAttribute<PublisherAttribute>((t, a) => a.Name == "Udp");
+			Assert.AreEqual(typeof(UdpPublisher), type);
+
+			// Second lookup is answered from the cached table
+			type = ClassLoader.FindTypeByAttribute<PublisherAttribute>((t, a) => a.Name == "Udp");
+			Assert.AreEqual(typeof(UdpPublisher), type);
+
+			Assert.Null(ClassLoader.FindTypeByAttribute<PublisherAttribute>((t, a) => a.Name == "NoSuchPublisher"));
+		}
+
+		[Test]
+		public void GetAllByAttribute()
+		{
+			var all = ClassLoader.GetAllByAttribute<PublisherAttribute>(null).ToList();
+			var udp = ClassLoader.GetAllByAttribute<PublisherAttribute>((t, a) => t == typeof(UdpPublisher)).ToList();
+
+			Assert.Greater(all.Count, udp.Count);
+			Assert.AreEqual(all.Count, ClassLoader.GetAllByAttribute<PublisherAttribute>(null).Count());
+
+			Assert.AreEqual(1, udp.Count);
+			Assert.AreEqual("Udp", udp[0].Key.Name);
+			Assert.AreEqual(typeof(UdpPublisher), udp[0].Value);
+
+			// Attribute types are cached independently
+			Assert.True(ClassLoader.GetAllByAttribute<MonitorAttribute>(null).All(kv => kv.Key is MonitorAttribute));
+		}
+
+		[Test]
+		public void TypeIndex()
+		{
+			string oldFolder = ClassLoader.TypeIndexFolder;
+			string tmp = Path.Combine(Path.GetTempPath(), Path.GetRandomFileName());
+
+			try
+			{
+				ClassLoader.TypeIndexFolder = tmp;
+				var all = ClassLoader.GetAllByAttribute<PublisherAttribute>(null).Select(kv => kv.Value).ToList();
+				Assert.Contains(typeof(UdpPublisher), all);
+
+				string file = Path.Combine(tmp, typeof(UdpPublisher).Assembly.ManifestModule.ModuleVersionId.ToString("N") + ".types");
+				Assert.True(File.Exists(file));
+
+				// Edit the saved index, a new run must use it and skip names that are gone
+				string prefix = typeof(PublisherAttribute).FullName + "\t";
+				var lines = File.ReadAllLines(file).Select(line => !line.StartsWith(prefix) ? line :
+					line.Replace("\t" + typeof(UdpPublisher).FullName, "") + "\tPeach.Core.Publishers.NoSuchPublisher").ToArray();
+				File.WriteAllLines(file, lines);
+
+				ClassLoader.TypeIndexFolder = tmp;
+				var saved = ClassLoader.GetAllByAttribute<PublisherAttribute>(null).Select(kv => kv.Value).ToList();
+				Assert.AreEqual(all.Where(t => t != typeof(UdpPublisher)).ToList(), saved);
+
+				// An index in another format is rebuilt
+				lines[0] = "PeachTypeIndex 0";
+				File.WriteAllLines(file, lines);
+
+				ClassLoader.TypeIndexFolder = tmp;
+				Assert.AreEqual(all, ClassLoader.GetAllByAttribute<PublisherAttribute>(null).Select(kv => kv.Value).ToList());
+				Assert.AreEqual("PeachTypeIndex 1", File.ReadAllLines(file)[0]);
+			}
+			finally
+			{
+				ClassLoader.TypeIndexFolder = oldFolder;
+				Directory.Delete(tmp, true);
+			}
+		}
+	}
+}
@@ -669,6 +669,132 @@ namespace Peach.Core.Test.CrackingTests
 			Assert.AreEqual(1, ((byte[])innerBlock[0].DefaultValue).Length);
 			Assert.AreEqual(3, ((byte[])innerBlock[1].DefaultValue).Length);
 		}
+
+		[Test]
+		public void ChoiceTokenLookahead()
+		{
+			string xml = @"
+<Peach>
+	<DataModel name=""DM"">
+		<Choice name=""c"">
+			<Block name=""A"">
+				<Number name=""start"" size=""8"" value=""0x68"" token=""true""/>
+				<Number name=""len"" size=""8""/>
+				<Number name=""type"" size=""8"" value=""0x01"" token=""true""/>
+				<Blob name=""data""/>
+			</Block>
+			<Block name=""B"">
+				<Number name=""start"" size=""8"" value=""0x68"" token=""true""/>
+				<Number name=""len"" size=""8""/>
+				<Number name=""type"" size=""8"" value=""0x03"" token=""true""/>
+				<Blob name=""data""/>
+			</Block>
+		</Choice>
+	</DataModel>
+</Peach>
+";
+			PitParser parser = new PitParser();
+			Dom.Dom dom = parser.asParser(null, new MemoryStream(ASCIIEncoding.ASCII.GetBytes(xml)));
+
+			BitStream data = new BitStream();
+			data.WriteBytes(new byte[] { 0x68, 0x04, 0x03, 0xaa, 0xbb });
+			data.SeekBits(0, SeekOrigin.Begin);
+
+			var failed = new List<string>();
+
+			DataCracker cracker = new DataCracker();
+			cracker.ExceptionHandleNodeEvent += delegate(DataElement element, long position, BitStream bs, Exception e)
+			{
+				failed.Add(element.name);
+			};
+			cracker.CrackData(dom.dataModels[0], data);
+
+			var c = dom.dataModels[0][0] as Dom.Choice;
+			Assert.AreEqual("B", c.SelectedElement.name);
+			Assert.AreEqual(new byte[] { 0xaa, 0xbb }, (byte[])((Dom.Block)c.SelectedElement)[3].DefaultValue);
+
+			// 'A' was ruled out by its 'type' token without being cracked
+			Assert.AreEqual(0, failed.Count);
+		}
+
+		[Test]
+		public void ChoiceTokenLookaheadBenchmark()
+		{
+			// IEC 104 APCI framing: I, S and U formats selected by the
+			// low bits of the first control octet.
+			string xml = @"
+<Peach>
+	<DataModel name=""APDU"">
+		<Choice name=""frame"" minOccurs=""0"" maxOccurs=""-1"">
+			<Block name=""U"">
+				<Number name=""start"" size=""8"" value=""0x68"" token=""true""/>
+				<Number name=""len"" size=""8"" value=""4"" token=""true""/>
+				<Number name=""ctrl"" size=""8"" value=""0x07"" token=""true""/>
+				<Blob name=""rest"" length=""3""/>
+			</Block>
+			<Block name=""S"">
+				<Number name=""start"" size=""8"" value=""0x68"" token=""true""/>
+				<Number name=""len"" size=""8"" value=""4"" token=""true""/>
+				<Number name=""ctrl"" size=""8"" value=""0x01"" token=""true""/>
+				<Blob name=""rest"" length=""3""/>
+			</Block>
+			<Block name=""I"">
+				<Number name=""start"" size=""8"" value=""0x68"" token=""true""/>
+				<Number name=""len"" size=""8"">
+					<Relation type=""size"" of=""asdu""/>
+				</Number>
+				<Blob name=""asdu""/>
+			</Block>
+		</Choice>
+	</DataModel>
+</Peach>
+";
+			PitParser parser = new PitParser();
+			Dom.Dom dom = parser.asParser(null, new MemoryStream(ASCIIEncoding.ASCII.GetBytes(xml)));
+
+			const int frames = 200;
+			var ms = new MemoryStream();
+			for (int i = 0; i < frames; ++i)
+			{
+				if (i % 2 == 0)
+					ms.Write(new byte[] { 0x68, 0x04, 0x01, 0x00, 0x02, 0x00 }, 0, 6);
+				else
+					ms.Write(new byte[] { 0x68, 0x06, 0x00, 0x00, 0x00, 0x00, 0x64, 0x01 }, 0, 8);
+			}
+
+			var pruned = CrackFrames(dom, ms.ToArray(), true);
+			var full = CrackFrames(dom, ms.ToArray(), false);
+
+			Assert.AreEqual(frames, pruned.Count);
+			Assert.AreEqual("S", ((Dom.Choice)pruned[0]).SelectedElement.name);
+			Assert.AreEqual("I", ((Dom.Choice)pruned[1]).SelectedElement.name);
+
+			// Ruling out options by token must not change what is cracked
+			Assert.AreEqual(full.Count, pruned.Count);
+			for (int i = 0; i < full.Count; ++i)
+			{
+				Assert.AreEqual(((Dom.Choice)full[i]).SelectedElement.name, ((Dom.Choice)pruned[i]).SelectedElement.name);
+				Assert.AreEqual(full[i].Value.Value, pruned[i].Value.Value);
+			}
+		}
+
+		static Dom.Array CrackFrames(Dom.Dom dom, byte[] buf, bool lookahead)
+		{
+			var model = dom.dataModels[0].Clone() as DataModel;
+			var sw = System.Diagnostics.Stopwatch.StartNew();
+
+			DataCracker cracker = new DataCracker();
+			cracker.TokenLookahead = lookahead;
+			cracker.CrackData(model, new BitStream(buf));
+
+			sw.Stop();
+			Console.WriteLine("Cracked {0} bytes of IEC 104 frames in {1} ms, lookahead {2}",
+				buf.Length, sw.ElapsedMilliseconds, lookahead ? "on" : "off");
+
+			var array = model[0] as Dom.Array;
+			Assert.NotNull(array);
+			return array;
+		}
 	}
 }
 
@@ -208,5 +208,84 @@ namespace Peach.Core.Test
 				Assert.Null(msg);
 			}
 		}
+
+		[Test]
+		public void IncrementalRender()
+		{
+			var dm = new DataModel("root");
+			var blk = new Block("blk");
+			var str1 = new Dom.String("str1");
+			var str2 = new Dom.String("str2");
+			var blob = new Blob("blob");
+			str1.DefaultValue = new Variant("Hello");
+			str2.DefaultValue = new Variant("World");
+			blob.DefaultValue = new Variant(new byte[] { 1, 2, 3 });
+			blk.Add(str1);
+			blk.Add(str2);
+			dm.Add(blk);
+			dm.Add(blob);
+
+			var first = dm.Value;
+			var expected = Encoding.ASCII.GetBytes("HelloWorld").Concat(new byte[] { 1, 2, 3 }).ToArray();
+			Assert.AreEqual(expected, first.Value);
+
+			// Unchanged children are shared, not copied
+			Assert.True(first.IsShared);
+
+			// Only the changed child is rendered again
+			str2.DefaultValue = new Variant("There");
+			expected = Encoding.ASCII.GetBytes("HelloThere").Concat(new byte[] { 1, 2, 3 }).ToArray();
+			Assert.AreEqual(expected, dm.Value.Value);
+			Assert.AreEqual(40, dm.Value.DataElementPosition(str2));
+			Assert.AreEqual(80, dm.Value.DataElementPosition(blob));
+
+			// Earlier values are not touched
+			Assert.AreEqual(Encoding.ASCII.GetBytes("HelloWorld").Concat(new byte[] { 1, 2, 3 }).ToArray(), first.Value);
+
+			// Length changes move the following children
+			str1.DefaultValue = new Variant("Hi");
+			expected = Encoding.ASCII.GetBytes("HiThere").Concat(new byte[] { 1, 2, 3 }).ToArray();
+			Assert.AreEqual(expected, dm.Value.Value);
+			Assert.AreEqual(16, dm.Value.DataElementPosition(str2));
+			Assert.AreEqual(56, dm.Value.DataElementPosition(blob));
+
+			// Clones share the copied state
+			var copy = dm.Clone() as DataModel;
+			((DataElementContainer)copy[0])[1].DefaultValue = new Variant("Peach");
+			expected = Encoding.ASCII.GetBytes("HiPeach").Concat(new byte[] { 1, 2, 3 }).ToArray();
+			Assert.AreEqual(expected, copy.Value.Value);
+			Assert.AreEqual(Encoding.ASCII.GetBytes("HiThere").Concat(new byte[] { 1, 2, 3 }).ToArray(), dm.Value.Value);
+		}
+
+		[Test]
+		public void UnalignedRender()
+		{
+			var dm = new DataModel("root");
+			var blk = new Block("blk");
+			var num1 = new Number("num1");
+			var num2 = new Number("num2");
+			num1.length = 4;
+			num1.DefaultValue = new Variant(1);
+			num2.length = 4;
+			num2.DefaultValue = new Variant(2);
+			blk.Add(num1);
+			blk.Add(num2);
+			dm.Add(blk);
+			dm.Add(new Blob("blob") { DefaultValue = new Variant(new byte[] { 3 }) });
+
+			// Children that end part way through a byte are copied
+			Assert.False(blk.Value.IsShared);
+			Assert.True(dm.Value.IsShared);
+			Assert.AreEqual(new byte[] { 0x12, 3 }, dm.Value.Value);
+			Assert.AreEqual(4, dm.Value.DataElementPosition(num2));
+			Assert.AreEqual(8, dm.Value.DataElementPosition(dm[1]));
+
+			// Writing to a shared value copies it first
+			var value = dm.Value;
+			value.SeekBits(0, System.IO.SeekOrigin.Begin);
+			value.WriteByte(0xff);
+			Assert.AreEqual(new byte[] { 0xff, 3 }, value.Value);
+			Assert.AreEqual(new byte[] { 0x12 }, blk.Value.Value);
+		}
 	}
 }
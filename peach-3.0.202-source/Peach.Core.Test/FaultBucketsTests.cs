@@ -0,0 +1,108 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+
+using Peach.Core;
+using Peach.Core.Agent;
+using Peach.Core.Loggers;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class FaultBucketsTests
+	{
+		[Test]
+		public void Samples()
+		{
+			var buckets = new FaultBuckets(2);
+
+			Assert.True(buckets.Add("a", 1, 10, "A"));
+			Assert.True(buckets.Add("a", 1, 11, "A"));
+			Assert.False(buckets.IsFull("a", 2));
+			Assert.True(buckets.IsFull("a", 1));
+			Assert.False(buckets.Add("a", 1, 12, "A"));
+			Assert.False(buckets.Add("a", 1, 13, "A"));
+
+			// Same stack, different path
+			Assert.True(buckets.Add("a", 2, 14, "A"));
+
+			var b = buckets.Find("a", 1);
+			Assert.AreEqual(4, b.Count);
+			Assert.AreEqual(2, b.Saved);
+			Assert.AreEqual(10, b.FirstIteration);
+			Assert.AreEqual(13, b.LastIteration);
+			Assert.AreEqual(2, buckets.Buckets.Count());
+		}
+
+		[Test]
+		public void Unlimited()
+		{
+			var buckets = new FaultBuckets(0);
+
+			for (uint i = 0; i < 10; ++i)
+				Assert.True(buckets.Add("a", 1, i, "A"));
+
+			Assert.False(buckets.IsFull("a", 1));
+		}
+
+		[Test]
+		public void StackHash()
+		{
+			var fault = new Fault();
+			fault.folderName = "ProcessExitedEarly";
+			Assert.AreEqual("ProcessExitedEarly", FaultBuckets.StackHash(fault));
+
+			const string report = "==1==ERROR: AddressSanitizer: SEGV on unknown address 0x0 (pc 0x4f1c2a bp 0x1 sp 0x1 T0)\n" +
+				"    #0 0x4f1c2a in parse src/parse.c:120:9\n" +
+				"    #1 0x4f0001 in main src/main.c:10:3\n\n";
+
+			fault.collectedData["Asan_Report.txt"] = Encoding.UTF8.GetBytes(report);
+			string hash = FaultBuckets.StackHash(fault);
+			Assert.AreEqual(8, hash.Length);
+
+			var parsed = new SanitizerReport();
+			parsed.Append(Encoding.UTF8.GetBytes(report));
+			Assert.AreEqual(parsed.MajorHash, hash);
+
+			// Addresses do not matter
+			fault.collectedData["Asan_Report.txt"] = Encoding.UTF8.GetBytes(report.Replace("0x4f", "0x7f"));
+			Assert.AreEqual(hash, FaultBuckets.StackHash(fault));
+
+			// A different crashing function does
+			fault.collectedData["Asan_Report.txt"] = Encoding.UTF8.GetBytes(report.Replace("in parse", "in lex"));
+			Assert.AreNotEqual(hash, FaultBuckets.StackHash(fault));
+
+			fault.majorHash = "12345678";
+			Assert.AreEqual("12345678", FaultBuckets.StackHash(fault));
+		}
+
+		[Test]
+		public void Save()
+		{
+			string tmp = Path.GetTempFileName();
+
+			try
+			{
+				var buckets = new FaultBuckets(1);
+				buckets.Add("a", 1, 1, "A");
+				buckets.Add("b", 0x20, 2, "B");
+				buckets.Add("b", 0x20, 3, "B");
+				buckets.Save(tmp);
+
+				var lines = File.ReadAllLines(tmp);
+				Assert.AreEqual(3, lines.Length);
+				Assert.AreEqual("b\t00000020\t2\t1\t2\t3\tB", lines[1]);
+				Assert.AreEqual("a\t00000001\t1\t1\t1\t1\tA", lines[2]);
+			}
+			finally
+			{
+				File.Delete(tmp);
+			}
+		}
+	}
+}
@@ -0,0 +1,114 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading;
+
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+
+using Peach.Core;
+using Peach.Core.Loggers;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class FaultWriterTests
+	{
+		[Test]
+		public void Order()
+		{
+			var ran = new List<int>();
+
+			using (var writer = new FaultWriter(4, 8))
+			{
+				for (int i = 0; i < 100; ++i)
+				{
+					int n = i;
+					writer.Enqueue(delegate() { ran.Add(n); });
+				}
+
+				writer.Wait();
+				Assert.AreEqual(Enumerable.Range(0, 100).ToList(), ran);
+			}
+		}
+
+		[Test]
+		public void Bounded()
+		{
+			var gate = new ManualResetEvent(false);
+			int queued = 0;
+
+			using (var writer = new FaultWriter(2, 8))
+			{
+				// First job holds the writer, two more fill the queue
+				var t = new Thread(delegate()
+				{
+					for (int i = 0; i < 4; ++i)
+					{
+						writer.Enqueue(delegate() { gate.WaitOne(); });
+						Interlocked.Increment(ref queued);
+					}
+				});
+				t.Start();
+
+				Thread.Sleep(500);
+				Assert.AreEqual(3, queued);
+
+				gate.Set();
+				t.Join();
+				writer.Wait();
+				Assert.AreEqual(4, queued);
+			}
+		}
+
+		[Test]
+		public void Files()
+		{
+			string dir = Path.Combine(Path.GetTempPath(), Path.GetRandomFileName());
+
+			try
+			{
+				using (var writer = new FaultWriter(16, 3))
+				{
+					writer.Enqueue(delegate()
+					{
+						Directory.CreateDirectory(dir);
+						for (int i = 0; i < 4; ++i)
+							writer.WriteFile(Path.Combine(dir, i + ".txt"), "data" + i);
+					});
+
+					writer.Wait();
+
+					// One batch was full, the rest synced once the queue was empty
+					Assert.AreEqual(2, writer.Syncs);
+				}
+
+				for (int i = 0; i < 4; ++i)
+					Assert.AreEqual("data" + i, File.ReadAllText(Path.Combine(dir, i + ".txt")));
+			}
+			finally
+			{
+				if (Directory.Exists(dir))
+					Directory.Delete(dir, true);
+			}
+		}
+
+		[Test]
+		public void Errors()
+		{
+			bool ran = false;
+
+			using (var writer = new FaultWriter(4, 4))
+			{
+				// A failing job does not stop the writer
+				writer.Enqueue(delegate() { throw new IOException("disk full"); });
+				writer.Enqueue(delegate() { ran = true; });
+				writer.Wait();
+			}
+
+			Assert.True(ran);
+		}
+	}
+}
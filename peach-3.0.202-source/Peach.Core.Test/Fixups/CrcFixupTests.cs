@@ -7,6 +7,7 @@ using NUnit.Framework.Constraints;
 using Peach.Core.IO;
 using Peach.Core.Dom;
 using Peach.Core.Analyzers;
+using Peach.Core.Fixups.Libraries;
 
 namespace Peach.Core.Test.Fixups
 {
@@ -248,6 +249,38 @@ namespace Peach.Core.Test.Fixups
 			Assert.AreEqual(precalcChecksum, values[0].Value);
 		}
 
+		[Test]
+		public void TestSliceBy8()
+		{
+			byte[] check = ASCIIEncoding.ASCII.GetBytes("123456789");
+
+			Assert.AreEqual(0xCBF43926, CRCTool.Get(CRCTool.CRCCode.CRC32).crctablefast(check));
+			Assert.AreEqual(0xBB3D, CRCTool.Get(CRCTool.CRCCode.CRC16).crctablefast(check));
+			Assert.AreEqual(0x29B1, CRCTool.Get(CRCTool.CRCCode.CRC_CCITT).crctablefast(check));
+
+			var rng = new System.Random(1234);
+
+			foreach (CRCTool.CRCCode code in Enum.GetValues(typeof(CRCTool.CRCCode)))
+			{
+				var crc = CRCTool.Get(code);
+
+				// Every tail length, against the bit by bit reference
+				for (int len = 0; len < 40; ++len)
+				{
+					byte[] buf = new byte[len];
+					rng.NextBytes(buf);
+
+					Assert.AreEqual(crc.crcbitbybitfast(buf), crc.crctablefast(buf));
+
+					byte[] head = new byte[len / 3];
+					byte[] tail = new byte[len - head.Length];
+					Buffer.BlockCopy(buf, 0, head, 0, head.Length);
+					Buffer.BlockCopy(buf, head.Length, tail, 0, tail.Length);
+
+					Assert.AreEqual(crc.crctablefast(buf), crc.crctablefast(head, tail));
+				}
+			}
+		}
 	}
 }
 
@@ -0,0 +1,71 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class InfluenceMapTests
+	{
+		[Test]
+		public void Record()
+		{
+			var map = new InfluenceMap();
+
+			map.Record("model/payload", new uint[0]);
+			map.Record("model/cmd", new uint[] { 10, 20, 30 });
+			map.Record("model/len", new uint[] { 10 });
+			map.Record("model/len", new uint[] { 10, 40 });
+
+			Assert.AreEqual(3, map.Count);
+			Assert.AreEqual(2, map.Probes("model/len"));
+			Assert.AreEqual(0, map.Probes("model/other"));
+
+			Assert.True(map.IsInert("model/payload"));
+			Assert.False(map.IsInert("model/cmd"));
+			Assert.False(map.IsInert("model/other"));
+
+			Assert.AreEqual(new uint[] { 10, 40 }, map.Edges("model/len").OrderBy(a => a).ToArray());
+			Assert.AreEqual(new string[] { "model/cmd", "model/len" }, map.Influential().ToArray());
+		}
+
+		[Test]
+		public void MaxEdges()
+		{
+			var map = new InfluenceMap();
+			var edges = Enumerable.Range(0, InfluenceMap.MaxEdges * 2).Select(a => (uint)a);
+
+			map.Record("model/blob", edges);
+
+			Assert.AreEqual(InfluenceMap.MaxEdges, map.Edges("model/blob").Count());
+		}
+
+		[Test]
+		public void SaveLoad()
+		{
+			var map = new InfluenceMap();
+			map.Record("model/payload", new uint[0]);
+			map.Record("model/cmd", new uint[] { 7 });
+
+			string tmp = Path.GetTempFileName();
+
+			try
+			{
+				map.Save(tmp);
+				var copy = InfluenceMap.Load(tmp);
+
+				Assert.AreEqual(2, copy.Count);
+				Assert.True(copy.IsInert("model/payload"));
+				Assert.AreEqual(new uint[] { 7 }, copy.Edges("model/cmd").ToArray());
+			}
+			finally
+			{
+				File.Delete(tmp);
+			}
+		}
+	}
+}
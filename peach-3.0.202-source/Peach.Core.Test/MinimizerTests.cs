@@ -0,0 +1,181 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+using Peach.Core;
+using Peach.Core.Analysis;
+using Peach.Core.Analyzers;
+using Peach.Core.Dom;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class MinimizerTests
+	{
+		/// <summary>
+		/// Faults when an output has cmd 7 and an item of 0xff.
+		/// </summary>
+		class FakeReplayer : IReplayer
+		{
+			public ReplayResult Replay(ReplayCase replayCase)
+			{
+				var ret = new ReplayResult();
+
+				foreach (var kv in replayCase.Data)
+				{
+					if (replayCase.Skipped.Contains(kv.Key))
+						continue;
+
+					var dm = kv.Value;
+					var items = dm.EnumerateAllElements().OfType<Dom.Array>().First();
+
+					if ((int)dm["cmd"].DefaultValue == 7 && items.Any(e => (int)e.DefaultValue == 0xff))
+					{
+						var fault = new Fault();
+						fault.type = FaultType.Fault;
+						fault.folderName = "Crash";
+						ret.Faults = new Fault[] { fault };
+					}
+				}
+
+				return ret;
+			}
+		}
+
+		string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n" +
+			"<Peach>" +
+			"   <DataModel name=\"TheDataModel\">" +
+			"       <Number name=\"cmd\" size=\"8\" value=\"1\"/>" +
+			"       <Number name=\"count\" size=\"8\">" +
+			"           <Relation type=\"count\" of=\"item\"/>" +
+			"       </Number>" +
+			"       <Number name=\"item\" size=\"8\" minOccurs=\"0\" maxOccurs=\"100\"/>" +
+			"       <Blob name=\"payload\"/>" +
+			"   </DataModel>" +
+
+			"   <StateModel name=\"TheState\" initialState=\"Initial\">" +
+			"       <State name=\"Initial\">" +
+			"           <Action name=\"A1\" type=\"output\"><DataModel ref=\"TheDataModel\"/></Action>" +
+			"           <Action name=\"R\" type=\"input\"><DataModel ref=\"TheDataModel\"/></Action>" +
+			"           <Action name=\"A2\" type=\"output\"><DataModel ref=\"TheDataModel\"/></Action>" +
+			"           <Action name=\"A3\" type=\"output\"><DataModel ref=\"TheDataModel\"/></Action>" +
+			"       </State>" +
+			"   </StateModel>" +
+			"</Peach>";
+
+		string faultPath;
+		Dom.StateModel stateModel;
+
+		[SetUp]
+		public void SetUp()
+		{
+			PitParser parser = new PitParser();
+			var dom = parser.asParser(null, new MemoryStream(ASCIIEncoding.ASCII.GetBytes(xml)));
+			stateModel = dom.stateModels["TheState"];
+
+			// Laid out the way FileLogger saves a fault
+			faultPath = Path.Combine(Path.GetTempPath(), Path.GetRandomFileName());
+			Directory.CreateDirectory(faultPath);
+			File.WriteAllBytes(Path.Combine(faultPath, "action_1_Output_Initial.A1.txt"), new byte[] { 1, 2, 0xff, 0xff, 0x41 });
+			File.WriteAllBytes(Path.Combine(faultPath, "action_2_Input_Initial.R.txt"), new byte[] { 1, 0 });
+			File.WriteAllBytes(Path.Combine(faultPath, "action_3_Output_Initial.A2.txt"), new byte[] { 7, 4, 1, 2, 0xff, 3, 0x41, 0x42, 0x43, 0x44 });
+			File.WriteAllBytes(Path.Combine(faultPath, "action_4_Output_Initial.A3.txt"), new byte[] { 7, 1, 5 });
+		}
+
+		[TearDown]
+		public void TearDown()
+		{
+			Directory.Delete(faultPath, true);
+		}
+
+		[Test]
+		public void Load()
+		{
+			var rc = ReplayCase.Load(faultPath, stateModel);
+
+			Assert.AreEqual(new int[] { 1, 3, 4 }, rc.Data.Keys.ToArray());
+			Assert.AreEqual("Initial.A2", rc.Names[3]);
+			Assert.AreEqual(3, rc.ActionCount);
+			Assert.AreEqual(18, rc.ByteCount);
+			Assert.AreEqual(4, rc.Data[3].EnumerateAllElements().OfType<Dom.Array>().First().Count);
+		}
+
+		[Test]
+		public void LoadUnqualified()
+		{
+			// Saved before action files were named "state.action"
+			File.Move(Path.Combine(faultPath, "action_3_Output_Initial.A2.txt"), Path.Combine(faultPath, "action_3_Output_A2.txt"));
+
+			var rc = ReplayCase.Load(faultPath, stateModel);
+
+			Assert.AreEqual("A2", rc.Names[3]);
+			Assert.AreEqual(4, rc.Data[3].EnumerateAllElements().OfType<Dom.Array>().First().Count);
+		}
+
+		[Test]
+		public void WriteRead()
+		{
+			var rc = ReplayCase.Load(faultPath, stateModel);
+			rc.Skipped.Add(1);
+
+			var ms = new MemoryStream();
+			rc.Write(new BinaryWriter(ms));
+			rc.Write(new BinaryWriter(ms));
+			ms.Position = 0;
+
+			var reader = new BinaryReader(ms);
+			var copy = ReplayCase.Read(reader);
+
+			Assert.AreEqual(new int[] { 3, 4 }, copy.Data.Keys.ToArray());
+			Assert.AreEqual(new int[] { 1 }, copy.Skipped.ToArray());
+			Assert.AreEqual(rc.Data[3].Value.Value, copy.Data[3].Value.Value);
+			Assert.AreEqual(rc.Data[4].Value.Value, copy.Data[4].Value.Value);
+
+			Assert.NotNull(ReplayCase.Read(reader));
+			Assert.Null(ReplayCase.Read(reader));
+		}
+
+		[Test]
+		public void Minimize()
+		{
+			var minimizer = new Minimizer(new IReplayer[] { new FakeReplayer() });
+			var result = minimizer.Run(ReplayCase.Load(faultPath, stateModel));
+
+			Assert.AreEqual("Crash", minimizer.FaultSignature);
+			Assert.AreEqual(1, result.ActionCount);
+			Assert.False(result.Skipped.Contains(3));
+
+			// cmd, count and the single item that matters
+			Assert.AreEqual(new byte[] { 7, 1, 0xff }, result.Data[3].Value.Value);
+
+			result.Save(Path.Combine(faultPath, "minimized"));
+			var files = Directory.GetFiles(Path.Combine(faultPath, "minimized")).Select(f => Path.GetFileName(f)).ToArray();
+			Assert.AreEqual(new string[] { "action_3_Output_Initial.A2.txt" }, files);
+		}
+
+		[Test]
+		public void MinimizeParallel()
+		{
+			var serial = new Minimizer(new IReplayer[] { new FakeReplayer() });
+			var expected = serial.Run(ReplayCase.Load(faultPath, stateModel));
+
+			var parallel = new Minimizer(new IReplayer[] { new FakeReplayer(), new FakeReplayer(), new FakeReplayer() });
+			var result = parallel.Run(ReplayCase.Load(faultPath, stateModel));
+
+			Assert.AreEqual(expected.ActionCount, result.ActionCount);
+			Assert.AreEqual(expected.Data[3].Value.Value, result.Data[3].Value.Value);
+		}
+
+		[Test]
+		public void NotReproduced()
+		{
+			File.WriteAllBytes(Path.Combine(faultPath, "action_3_Output_Initial.A2.txt"), new byte[] { 1, 0 });
+
+			var minimizer = new Minimizer(new IReplayer[] { new FakeReplayer() });
+			Assert.Throws<PeachException>(delegate() { minimizer.Run(ReplayCase.Load(faultPath, stateModel)); });
+		}
+	}
+}
@@ -0,0 +1,111 @@
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.IO;
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+using Peach.Core;
+using Peach.Core.Analyzers;
+using Peach.Core.MutationStrategies;
+
+namespace Peach.Core.Test.MutationStrategies
+{
+	[TestFixture]
+	class AdaptiveStrategyTests : DataModelCollector
+	{
+		[Test]
+		public void Test1()
+		{
+			// Without any path feedback the strategy still mutates every iteration
+
+			string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n" +
+				"<Peach>" +
+				"   <DataModel name=\"TheDataModel\">" +
+				"       <Number name=\"num1\" size=\"32\" value=\"100\" signed=\"false\"/>" +
+				"       <String name=\"str1\" value=\"Hello\"/>" +
+				"   </DataModel>" +
+
+				"   <StateModel name=\"TheState\" initialState=\"Initial\">" +
+				"       <State name=\"Initial\">" +
+				"           <Action type=\"output\">" +
+				"               <DataModel ref=\"TheDataModel\"/>" +
+				"           </Action>" +
+				"       </State>" +
+				"   </StateModel>" +
+
+				"   <Test name=\"Default\">" +
+				"       <StateModel ref=\"TheState\"/>" +
+				"       <Publisher class=\"Null\"/>" +
+				"       <Strategy class=\"AdaptiveRandom\">" +
+				"           <Param name=\"MaxFieldsToMutate\" value=\"2\"/>" +
+				"       </Strategy>" +
+				"   </Test>" +
+				"</Peach>";
+
+			RunEngine(xml, 1, 500);
+
+			Assert.AreEqual(500, mutations.Count);
+			Assert.GreaterOrEqual(allStrategies.Count, 500);
+			Assert.LessOrEqual(allStrategies.Count, 1000);
+		}
+
+		[Test]
+		public void Rates()
+		{
+			var rates = new HitRates<string>(100);
+
+			Assert.AreEqual(0.5, rates.Rate("a"));
+
+			for (int i = 0; i < 10; ++i)
+			{
+				rates.Record("a", true);
+				rates.Record("b", false);
+			}
+
+			Assert.Greater(rates.Rate("a"), 0.9);
+			Assert.Less(rates.Rate("b"), 0.1);
+			Assert.Greater(rates.Rate("b"), 0.0);
+
+			// Old results age out once the window fills
+			for (int i = 0; i < 200; ++i)
+				rates.Record("a", false);
+
+			Assert.Less(rates.Rate("a"), 0.1);
+		}
+
+		[Test]
+		public void Choose()
+		{
+			var random = new Random(1234);
+			var weights = new double[] { 0.0, 9.0, 1.0 };
+			var counts = new int[3];
+
+			for (int i = 0; i < 1000; ++i)
+				counts[HitRates<int>.Choose(random, weights)] += 1;
+
+			Assert.AreEqual(0, counts[0]);
+			Assert.Greater(counts[1], 850);
+			Assert.Greater(counts[2], 50);
+		}
+
+		private void RunEngine(string xml, uint start, uint stop)
+		{
+			PitParser parser = new PitParser();
+
+			Dom.Dom dom = parser.asParser(null, new MemoryStream(ASCIIEncoding.ASCII.GetBytes(xml)));
+			dom.tests[0].includedMutators = new List<string>();
+			dom.tests[0].includedMutators.Add("NumericalVarianceMutator");
+			dom.tests[0].includedMutators.Add("NumericalEdgeCaseMutator");
+
+			RunConfiguration config = new RunConfiguration();
+			config.rangeStart = start;
+			config.rangeStop = stop;
+			config.range = true;
+			config.randomSeed = 12345;
+
+			Engine e = new Engine(null);
+			e.startFuzzing(dom, config);
+		}
+	}
+}
@@ -0,0 +1,124 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading;
+
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+
+using Peach.Core;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class ProfilerTests
+	{
+		[TearDown]
+		public void TearDown()
+		{
+			Profiler.StopTrace();
+			Profiler.Reset();
+		}
+
+		[Test]
+		public void Disabled()
+		{
+			Profiler.Reset();
+
+			long start = Profiler.Begin(ProfilePhase.Render);
+			Assert.AreEqual(0, start);
+			Profiler.End(ProfilePhase.Render, start);
+
+			Assert.AreEqual(0, Profiler.Count(ProfilePhase.Render));
+			Assert.AreEqual(0, Profiler.Events.Count());
+		}
+
+		[Test]
+		public void Ring()
+		{
+			Profiler.StartTrace(4);
+
+			for (int i = 0; i < 10; ++i)
+				Profiler.End(ProfilePhase.Publish, Profiler.Begin(ProfilePhase.Publish));
+
+			Assert.AreEqual(10, Profiler.Count(ProfilePhase.Publish));
+			Assert.AreEqual(6, Profiler.Dropped);
+
+			var events = Profiler.Events.ToList();
+			Assert.AreEqual(4, events.Count);
+
+			// Oldest first
+			for (int i = 1; i < events.Count; ++i)
+				Assert.LessOrEqual(events[i - 1].End, events[i].Start);
+		}
+
+		[Test]
+		public void Nested()
+		{
+			Profiler.StartTrace(16);
+
+			long render = Profiler.Begin(ProfilePhase.Render);
+			long fixup = Profiler.Begin(ProfilePhase.Fixup);
+
+			// Entered again by a relation, only the outer call counts
+			long again = Profiler.Begin(ProfilePhase.Fixup);
+			Profiler.End(ProfilePhase.Fixup, again);
+
+			Thread.Sleep(2);
+			Profiler.End(ProfilePhase.Fixup, fixup);
+			Thread.Sleep(2);
+			Profiler.End(ProfilePhase.Render, render);
+
+			Assert.AreEqual(1, Profiler.Count(ProfilePhase.Fixup));
+			Assert.AreEqual(2, Profiler.Events.Count());
+
+			var folded = new StringWriter();
+			Profiler.WriteFoldedStacks(folded);
+			var lines = folded.ToString().Split(new char[] { '\r', '\n' }, StringSplitOptions.RemoveEmptyEntries);
+
+			Assert.AreEqual(2, lines.Length);
+			StringAssert.StartsWith("render ", lines[0]);
+			StringAssert.StartsWith("render;fixup ", lines[1]);
+
+			var chrome = new StringWriter();
+			Profiler.WriteChromeTrace(chrome);
+
+			StringAssert.StartsWith("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", chrome.ToString());
+			StringAssert.Contains("\"name\":\"fixup\",\"cat\":\"peach\",\"ph\":\"X\"", chrome.ToString());
+			StringAssert.Contains("\"name\":\"render\",\"cat\":\"peach\",\"ph\":\"X\"", chrome.ToString());
+		}
+
+		[Test]
+		public void StopFromOtherThread()
+		{
+			Profiler.StartTrace(16);
+
+			var running = true;
+			var engine = new Thread(delegate()
+			{
+				while (running)
+					Profiler.End(ProfilePhase.Publish, Profiler.Begin(ProfilePhase.Publish));
+			});
+
+			engine.Start();
+
+			while (Profiler.Count(ProfilePhase.Publish) < 100)
+				Thread.Sleep(1);
+
+			// Like the Ctrl+C handler, the engine keeps running
+			Profiler.Stop();
+
+			long count = Profiler.Count(ProfilePhase.Publish);
+			var events = Profiler.Events.ToList();
+			Thread.Sleep(10);
+
+			Assert.AreEqual(count, Profiler.Count(ProfilePhase.Publish));
+			Assert.AreEqual(events, Profiler.Events.ToList());
+
+			running = false;
+			engine.Join();
+		}
+	}
+}
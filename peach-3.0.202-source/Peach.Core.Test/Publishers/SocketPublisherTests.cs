@@ -6,6 +6,7 @@ using NUnit.Framework;
 using NUnit.Framework.Constraints;
 using Peach.Core;
 using Peach.Core.Analyzers;
+using Peach.Core.Publishers;
 using System.IO;
 using System.Net.Sockets;
 using System.Net;
@@ -326,6 +327,121 @@ namespace Peach.Core.Test.Publishers
 			
 		}
 
+		[Test]
+		public void UdpBatchTest()
+		{
+			SocketEcho echo = new SocketEcho();
+			echo.Start(IPAddress.Loopback, 3);
+			IPEndPoint ep = echo.Socket.LocalEndPoint as IPEndPoint;
+
+			string xml = @"
+<Peach>
+	<DataModel name='TheDataModel'>
+		<String name='str' value='Hello World'/>
+	</DataModel>
+
+	<DataModel name='ResponseModel'>
+		<String name='str' mutable='false'/>
+	</DataModel>
+
+	<StateModel name='TheStateModel' initialState='InitialState'>
+		<State name='InitialState'>
+			<Action name='Send1' type='output'>
+				<DataModel ref='TheDataModel'/>
+			</Action>
+			<Action name='Send2' type='output'>
+				<DataModel ref='TheDataModel'/>
+			</Action>
+			<Action name='Send3' type='output'>
+				<DataModel ref='TheDataModel'/>
+			</Action>
+			<Action name='Recv' type='input'>
+				<DataModel ref='ResponseModel'/>
+			</Action>
+		</State>
+	</StateModel>
+
+	<Test name='Default'>
+		<StateModel ref='TheStateModel'/>
+		<Publisher class='Udp'>
+			<Param name='Host' value='{0}'/>
+			<Param name='Port' value='{1}'/>
+			<Param name='Batch' value='true'/>
+		</Publisher>
+		<Strategy class='RandomDeterministic'/>
+	</Test>
+</Peach>".Fmt(IPAddress.Loopback, ep.Port);
+
+			PitParser parser = new PitParser();
+			Dom.Dom dom = parser.asParser(null, new MemoryStream(ASCIIEncoding.ASCII.GetBytes(xml)));
+
+			RunConfiguration config = new RunConfiguration();
+			config.singleIteration = true;
+
+			Engine e = new Engine(null);
+			e.startFuzzing(dom, config);
+
+			Assert.AreEqual(4, actions.Count);
+			Assert.AreEqual(3, echo.Count);
+
+			var de = actions[3].dataModel.find("ResponseModel.str");
+			Assert.NotNull(de);
+			Assert.AreEqual("Recv 11 bytes!", (string)de.DefaultValue);
+		}
+
+		[Test]
+		public void UdpBatchCloseTest()
+		{
+			// Outputs still queued when a state is cut short go out on close
+			using (var recv = new Socket(AddressFamily.InterNetwork, SocketType.Dgram, ProtocolType.Udp))
+			{
+				recv.Bind(new IPEndPoint(IPAddress.Loopback, 0));
+				recv.ReceiveTimeout = 1000;
+
+				var args = new Dictionary<string, Variant>();
+				args["Host"] = new Variant(IPAddress.Loopback.ToString());
+				args["Port"] = new Variant(((IPEndPoint)recv.LocalEndPoint).Port.ToString());
+				args["Batch"] = new Variant("true");
+
+				var pub = new UdpPublisher(args);
+				pub.start();
+				pub.open();
+				pub.output(Encoding.ASCII.GetBytes("one"), 0, 3);
+				pub.output(Encoding.ASCII.GetBytes("two"), 0, 3);
+				pub.close();
+				pub.stop();
+
+				var buf = new byte[16];
+				Assert.AreEqual("one", Encoding.ASCII.GetString(buf, 0, recv.Receive(buf)));
+				Assert.AreEqual("two", Encoding.ASCII.GetString(buf, 0, recv.Receive(buf)));
+			}
+		}
+
+		[Test]
+		public void UdpNoPortTest()
+		{
+			// Rejected output is a soft error, batched or not
+			foreach (var batch in new string[] { "false", "true" })
+			{
+				var args = new Dictionary<string, Variant>();
+				args["Host"] = new Variant(IPAddress.Loopback.ToString());
+				args["Batch"] = new Variant(batch);
+
+				var pub = new UdpPublisher(args);
+				pub.start();
+				pub.open();
+
+				Assert.Throws<SoftException>(delegate()
+				{
+					pub.output(Encoding.ASCII.GetBytes("one"), 0, 3);
+					pub.flush();
+				});
+
+				pub.close();
+				pub.stop();
+			}
+		}
+
 		[Test]
 		public void MulticastUdpTest()
 		{
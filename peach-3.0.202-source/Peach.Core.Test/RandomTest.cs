@@ -47,6 +47,26 @@ namespace Peach.Core.Test
 			}
 		}
 
+		[Test]
+		public void State()
+		{
+			// Restoring a saved state replays the sequence from that point
+			Random rand = new Random(0);
+			rand.NextUInt32();
+			rand.NextUInt32();
+
+			var state = rand.GetState();
+
+			var other = new Random(42);
+			other.SetState(state);
+
+			for (int i = 2; i < precomp.Length; ++i)
+				Assert.AreEqual(precomp[i], other.NextUInt32());
+
+			rand.SetState(state);
+			Assert.AreEqual(precomp[2], rand.NextUInt32());
+		}
+
 		[Test]
 		public void Test2()
 		{
@@ -0,0 +1,122 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+
+using Peach.Core;
+using Peach.Core.Runtime;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class ReplayJournalTests
+	{
+		[TearDown]
+		public void TearDown()
+		{
+			SHARE.queueLengthBeforeIteration = 0;
+			SHARE.seed_pool_to_use_cnt = 0;
+			SHARE.dataModelsToMutateIndex.Clear();
+			SHARE.seedPoolIndexQueue.Clear();
+		}
+
+		[Test]
+		public void RoundTrip()
+		{
+			string tmp = Path.GetTempFileName();
+
+			try
+			{
+				var state = new Random(7).GetState();
+				long first, second;
+
+				using (var journal = new ReplayJournal(tmp, 1234))
+				{
+					journal.Begin(1, 0);
+					journal.AddMutation("DM", "DM.str", "StringMutator", state);
+					journal.AddMutation("STATE_Initial", null, "StateChangeMutator", state);
+					first = journal.Commit();
+
+					// Splice source is taken from the queues
+					SHARE.queueLengthBeforeIteration = 1;
+					SHARE.dataModelsToMutateIndex.Enqueue(5);
+					journal.Begin(2, 3);
+					second = journal.Commit();
+
+					// Nothing pending, the last record is referenced
+					Assert.AreEqual(second, journal.Commit());
+				}
+
+				Assert.AreEqual(1234, ReplayJournal.ReadSeed(tmp));
+
+				var r = ReplayJournal.Read(tmp, first);
+				Assert.AreEqual(1, r.Iteration);
+				Assert.AreEqual(ReplaySource.None, r.Source);
+				Assert.AreEqual(2, r.Mutations.Count);
+				Assert.AreEqual("StringMutator", r.Find("DM", "DM.str").Mutator);
+				Assert.AreEqual(state, r.Find("DM", "DM.str").State);
+				Assert.AreEqual("StateChangeMutator", r.Find("STATE_Initial", null).Mutator);
+
+				r = ReplayJournal.Read(tmp, second);
+				Assert.AreEqual(2, r.Iteration);
+				Assert.AreEqual(3, r.SubIteration);
+				Assert.AreEqual(ReplaySource.Queue, r.Source);
+				Assert.AreEqual(5, r.Head);
+				Assert.AreEqual(0, r.Mutations.Count);
+			}
+			finally
+			{
+				File.Delete(tmp);
+			}
+		}
+
+		[Test]
+		public void PoolFirst()
+		{
+			string tmp = Path.GetTempFileName();
+
+			try
+			{
+				long offset;
+
+				using (var journal = new ReplayJournal(tmp, 1))
+				{
+					SHARE.queueLengthBeforeIteration = 1;
+					SHARE.dataModelsToMutateIndex.Enqueue(5);
+					SHARE.seed_pool_to_use_cnt = 1;
+					SHARE.seedPoolIndexQueue.Enqueue(9);
+					journal.Begin(4, 1);
+					offset = journal.Commit();
+				}
+
+				var r = ReplayJournal.Read(tmp, offset);
+				Assert.AreEqual(ReplaySource.Pool, r.Source);
+				Assert.AreEqual(9, r.Head);
+			}
+			finally
+			{
+				File.Delete(tmp);
+			}
+		}
+
+		[Test]
+		public void BadFile()
+		{
+			string tmp = Path.GetTempFileName();
+
+			try
+			{
+				File.WriteAllText(tmp, "not a journal");
+				Assert.Throws<PeachException>(delegate() { ReplayJournal.ReadSeed(tmp); });
+			}
+			finally
+			{
+				File.Delete(tmp);
+			}
+		}
+	}
+}
@@ -0,0 +1,106 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+using Peach.Core.IO;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class RingStreamTests
+	{
+		static byte[] Bytes(int start, int count)
+		{
+			return Enumerable.Range(start, count).Select(i => (byte)i).ToArray();
+		}
+
+		static void Append(RingStream rs, byte[] data)
+		{
+			long pos = rs.Position;
+			rs.Seek(0, SeekOrigin.End);
+			rs.Write(data, 0, data.Length);
+			rs.Position = pos;
+		}
+
+		[Test]
+		public void ReadWrite()
+		{
+			var rs = new RingStream(8);
+
+			Append(rs, Bytes(0, 5));
+			Assert.AreEqual(0, rs.Position);
+			Assert.AreEqual(5, rs.Length);
+
+			var buf = new byte[10];
+			Assert.AreEqual(5, rs.Read(buf, 0, buf.Length));
+			Assert.AreEqual(Bytes(0, 5), buf.Take(5).ToArray());
+			Assert.AreEqual(0, rs.Read(buf, 0, buf.Length));
+
+			rs.Seek(-3, SeekOrigin.Current);
+			Assert.AreEqual(2, rs.Position);
+			Assert.AreEqual(3, rs.Read(buf, 0, buf.Length));
+			Assert.AreEqual(Bytes(2, 3), buf.Take(3).ToArray());
+		}
+
+		[Test]
+		public void DiscardAndWrap()
+		{
+			var rs = new RingStream(8);
+			var buf = new byte[8];
+
+			Append(rs, Bytes(0, 6));
+			Assert.AreEqual(4, rs.Read(buf, 0, 4));
+
+			rs.Discard(rs.Position);
+			Assert.AreEqual(4, rs.Start);
+			Assert.AreEqual(6, rs.Length);
+
+			// Wraps around the end of the backing array without growing
+			Append(rs, Bytes(6, 6));
+			Assert.AreEqual(8, rs.Capacity);
+			Assert.AreEqual(12, rs.Length);
+			Assert.AreEqual(4, rs.Position);
+
+			Assert.AreEqual(8, rs.Read(buf, 0, 8));
+			Assert.AreEqual(Bytes(4, 8), buf);
+
+			Assert.Throws<ArgumentOutOfRangeException>(delegate() { rs.Position = 3; });
+		}
+
+		[Test]
+		public void Grow()
+		{
+			var rs = new RingStream(4);
+			var buf = new byte[64];
+
+			Append(rs, Bytes(0, 3));
+			rs.Read(buf, 0, 2);
+			rs.Discard(rs.Position);
+
+			Append(rs, Bytes(3, 30));
+			Assert.AreEqual(32, rs.Capacity);
+			Assert.AreEqual(33, rs.Length);
+
+			Assert.AreEqual(31, rs.Read(buf, 0, buf.Length));
+			Assert.AreEqual(Bytes(2, 31), buf.Take(31).ToArray());
+		}
+
+		[Test]
+		public void SetLength()
+		{
+			var rs = new RingStream(4);
+			var buf = new byte[16];
+
+			Append(rs, Bytes(1, 4));
+			rs.SetLength(2);
+			Assert.AreEqual(2, rs.Length);
+
+			rs.SetLength(6);
+			Assert.AreEqual(6, rs.Read(buf, 0, buf.Length));
+			Assert.AreEqual(new byte[] { 1, 2, 0, 0, 0, 0 }, buf.Take(6).ToArray());
+		}
+	}
+}
@@ -0,0 +1,101 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Runtime.Serialization.Formatters.Binary;
+
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+
+using Peach.Core;
+using Peach.Core.Analysis;
+using Peach.Core.Dom;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class SeedMinsetTests
+	{
+		[Test]
+		public void Cover()
+		{
+			var traces = new Dictionary<int, uint[]>();
+			traces[1] = new uint[] { 1, 2 };
+			traces[2] = new uint[] { 1, 2, 3, 4 };
+			traces[3] = new uint[] { 4, 5 };
+			traces[4] = new uint[] { 2, 3 };
+			traces[5] = new uint[] { 6 };
+			traces[6] = new uint[] { };
+
+			var ms = new SeedMinset();
+			var keep = ms.RunSeedCoverage(traces);
+
+			// 2 covers the most, then 3 adds 5 and 5 adds 6
+			Assert.AreEqual(new int[] { 2, 3, 5 }, keep);
+			Assert.AreEqual(6, ms.Features);
+		}
+
+		[Test]
+		public void CoverWide()
+		{
+			// Features spread over several bitset words
+			var traces = new Dictionary<int, uint[]>();
+			for (int i = 0; i < 10; ++i)
+				traces[i] = Enumerable.Range(i * 50, 100).Select(x => (uint)x * 8).ToArray();
+
+			var ms = new SeedMinset();
+			var keep = ms.RunSeedCoverage(traces);
+
+			Assert.AreEqual(550, ms.Features);
+			Assert.AreEqual(new int[] { 0, 2, 4, 6, 8, 9 }, keep);
+		}
+
+		[Test]
+		public void SeedPool()
+		{
+			string pool = Path.Combine(Path.GetTempPath(), Path.GetRandomFileName());
+			string outPath = pool + ".min";
+
+			try
+			{
+				Directory.CreateDirectory(pool);
+
+				for (int i = 1; i <= 3; ++i)
+				{
+					var dm = new DataModel("DM");
+					dm.Add(new Blob("Data"));
+
+					using (var fs = new FileStream(Path.Combine(pool, i + ".bin"), FileMode.Create))
+						new BinaryFormatter().Serialize(fs, dm);
+				}
+
+				new InfluenceMap().Save(Path.Combine(pool, "influence.bin"));
+
+				var files = SeedMinset.SeedFiles(pool);
+				Assert.AreEqual(new int[] { 1, 2, 3 }, files.Keys.ToArray());
+				Assert.AreEqual("DM", SeedMinset.LoadSeed(files[2]).name);
+
+				string trace = Path.Combine(pool, "2.trace");
+				SeedMinset.SaveTrace(trace, new uint[] { 7, 0xffffffff });
+				Assert.AreEqual(new uint[] { 7, 0xffffffff }, SeedMinset.LoadTrace(trace));
+
+				SeedMinset.SaveSeedPool(pool, new int[] { 1, 3 }, outPath);
+				Assert.AreEqual(new int[] { 1, 3 }, SeedMinset.SeedFiles(outPath).Keys.ToArray());
+
+				using (var fs = new FileStream(Path.Combine(outPath, SeedMinset.IndexFile), FileMode.Open))
+				{
+					var queue = new BinaryFormatter().Deserialize(fs) as Queue<int>;
+					Assert.AreEqual(new int[] { 1, 3 }, queue.ToArray());
+				}
+			}
+			finally
+			{
+				if (Directory.Exists(pool))
+					Directory.Delete(pool, true);
+				if (Directory.Exists(outPath))
+					Directory.Delete(outPath, true);
+			}
+		}
+	}
+}
@@ -0,0 +1,109 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+
+using Peach.Core;
+using Peach.Core.Dom;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class SeedPoolTests
+	{
+		static DataModel Seed(string data)
+		{
+			var dm = new DataModel("DM");
+			dm.Add(new Blob("Data") { DefaultValue = new Variant(Encoding.ASCII.GetBytes(data)) });
+			dm.p = 0.5;
+
+			var unused = dm.Value;
+			return dm;
+		}
+
+		static string Data(DataModel dm)
+		{
+			return Encoding.ASCII.GetString(dm.find("Data").Value.Value);
+		}
+
+		[Test]
+		public void Order()
+		{
+			using (var pool = new SeedPool(0))
+			{
+				pool.Enqueue(1, Seed("one"));
+				pool.Enqueue(2, Seed("two"));
+
+				Assert.AreEqual(2, pool.Count);
+				Assert.AreEqual("one", Data(pool.Peek()));
+
+				// The head is decoded once
+				Assert.AreSame(pool.Peek(), pool.Peek());
+
+				var dm = pool.Peek();
+				dm.use_time = 4;
+				Assert.AreEqual(1, pool.Dequeue());
+				pool.Enqueue(1, dm);
+
+				Assert.AreEqual(new int[] { 2, 1 }, pool.Ids.ToArray());
+				Assert.AreEqual("two", Data(pool.Peek()));
+				pool.Dequeue();
+
+				Assert.AreEqual("one", Data(pool.Peek()));
+				Assert.AreEqual(4, pool.Peek().use_time);
+				Assert.AreEqual(0.5, pool.Peek().p);
+
+				Assert.AreEqual(1, pool.Resident);
+				Assert.AreEqual(0, pool.Loads);
+			}
+		}
+
+		[Test]
+		public void Budget()
+		{
+			using (var pool = new SeedPool(1))
+			{
+				for (int i = 0; i < 10; ++i)
+					pool.Enqueue(i, Seed("seed" + i));
+
+				// Only the head stays in memory
+				Assert.AreEqual(1, pool.Resident);
+				Assert.AreEqual(9, pool.Spills);
+
+				for (int round = 0; round < 2; ++round)
+				{
+					for (int i = 0; i < 10; ++i)
+					{
+						var dm = pool.Peek();
+						Assert.AreEqual("seed" + i, Data(dm));
+						dm.use_time++;
+						pool.Enqueue(pool.Dequeue(), dm);
+					}
+				}
+
+				// Spilled records are not written again
+				Assert.AreEqual(10, pool.Spills);
+				Assert.AreEqual(2, pool.Peek().use_time);
+				Assert.Greater(pool.ReloadRate, 0.9);
+			}
+		}
+
+		[Test]
+		public void Clear()
+		{
+			var pool = new SeedPool(1);
+			pool.Enqueue(1, Seed("one"));
+			pool.Enqueue(2, Seed("two"));
+			Assert.AreEqual(1, pool.Spills);
+
+			pool.Clear();
+			Assert.AreEqual(0, pool.Count);
+			Assert.AreEqual(0, pool.ResidentBytes);
+			Assert.Throws<InvalidOperationException>(delegate() { pool.Peek(); });
+		}
+	}
+}
@@ -0,0 +1,191 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+
+using Peach.Core;
+using Peach.Core.Analyzers;
+using Peach.Core.Dom;
+using Peach.Core.IO;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class SeedStoreTests
+	{
+		string folder;
+
+		[SetUp]
+		public void SetUp()
+		{
+			folder = Path.Combine(Path.GetTempPath(), Path.GetRandomFileName());
+		}
+
+		[TearDown]
+		public void TearDown()
+		{
+			if (Directory.Exists(folder))
+				Directory.Delete(folder, true);
+		}
+
+		static DataModel Seed(string data)
+		{
+			var dm = new DataModel("DM");
+			var block = new Block("Header");
+			block.Add(new Blob("Magic") { DefaultValue = new Variant(Encoding.ASCII.GetBytes("PK")) });
+			dm.Add(block);
+			dm.Add(new Blob("Data") { DefaultValue = new Variant(Encoding.ASCII.GetBytes(data)) });
+			dm.use_time = 2;
+
+			// Seeds are queued after they were sent, so their values are cached
+			var unused = dm.Value;
+			return dm;
+		}
+
+		[Test]
+		public void RoundTrip()
+		{
+			using (var store = new SeedStore(folder, false))
+			{
+				store.Add(1, Seed("one"));
+				store.Add(2, Seed("two"));
+
+				var dm = store.Read(2);
+				Assert.AreEqual("DM", dm.name);
+				Assert.AreEqual(2, dm.use_time);
+				Assert.AreEqual("PKtwo", Encoding.ASCII.GetString(dm.Value.Value));
+				Assert.AreEqual("two", Encoding.ASCII.GetString(dm.find("Data").Value.Value));
+				Assert.NotNull(dm.find("Header.Magic"));
+			}
+
+			// Reopened from the index
+			using (var store = new SeedStore(folder, true))
+			{
+				Assert.AreEqual(new int[] { 1, 2 }, store.Ids.ToArray());
+
+				var all = store.ReadAll(new int[] { 2, 1, 7 });
+				Assert.AreEqual(2, all.Count);
+				Assert.AreEqual("PKone", Encoding.ASCII.GetString(all[1].Value.Value));
+			}
+		}
+
+		[Test]
+		public void Bits()
+		{
+			var dm = new DataModel("DM");
+			var bs = new BitStream();
+			bs.WriteBits(0x5, 3);
+			bs.WriteBits(0xabc, 12);
+			dm.Add(new Blob("Bits") { DefaultValue = new Variant(bs) });
+			var unused = dm.Value;
+
+			var copy = SeedStore.Decode(SeedStore.Encode(1, dm));
+			Assert.AreEqual(15, copy.Value.LengthBits);
+			Assert.AreEqual(dm.Value.Value, copy.Value.Value);
+		}
+
+		[Test]
+		public void ElementTypes()
+		{
+			string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n" +
+				"<Peach>" +
+				"   <DataModel name=\"DM\">" +
+				"       <Choice name=\"C\">" +
+				"           <Number name=\"A\" size=\"8\" value=\"1\"/>" +
+				"           <Number name=\"B\" size=\"16\" value=\"2\"/>" +
+				"       </Choice>" +
+				"       <Flags name=\"F\" size=\"8\">" +
+				"           <Flag name=\"F1\" position=\"0\" size=\"1\" value=\"1\"/>" +
+				"       </Flags>" +
+				"       <Block name=\"T\">" +
+				"           <Transformer class=\"Base64Encode\"/>" +
+				"           <String name=\"Data\" value=\"hello\"/>" +
+				"       </Block>" +
+				"   </DataModel>" +
+				"</Peach>";
+
+			var dom = new PitParser().asParser(null, new MemoryStream(Encoding.ASCII.GetBytes(xml)));
+			var dm = dom.dataModels[0];
+			var choice = (Choice)dm["C"];
+			choice.SelectedElement = choice.choiceElements["B"];
+			var unused = dm.Value;
+
+			var copy = SeedStore.Decode(SeedStore.Encode(1, dm));
+
+			Assert.AreEqual(dm.Value.Value, copy.Value.Value);
+			Assert.IsInstanceOf<Choice>(copy["C"]);
+			Assert.AreEqual("B", ((Choice)copy["C"]).SelectedElement.name);
+			Assert.IsInstanceOf<Dom.Number>(copy.find("C.B"));
+			Assert.IsInstanceOf<Flags>(copy["F"]);
+			Assert.IsInstanceOf<Flag>(copy.find("F.F1"));
+
+			// The transformed block stays a block, not a spliceable leaf
+			Assert.IsInstanceOf<Block>(copy["T"]);
+			Assert.AreEqual(dm["T"].Value.Value, copy["T"].Value.Value);
+			Assert.AreEqual("hello", Encoding.ASCII.GetString(copy.find("T.Data").Value.Value));
+		}
+
+		[Test]
+		public void RetireAndCompact()
+		{
+			using (var store = new SeedStore(folder, false))
+			{
+				for (int i = 1; i <= 4; ++i)
+					store.Add(i, Seed("seed" + i));
+
+				store.Retire(2);
+				store.Retire(3);
+
+				// Retired seeds are readable until compacted
+				Assert.AreEqual(new int[] { 1, 4 }, store.Ids.ToArray());
+				Assert.True(store.Contains(2));
+
+				long before = new FileInfo(Path.Combine(folder, SeedStore.DataFile)).Length;
+				store.Compact();
+				long after = new FileInfo(Path.Combine(folder, SeedStore.DataFile)).Length;
+
+				Assert.Less(after, before);
+				Assert.False(store.Contains(2));
+				Assert.AreEqual("PKseed4", Encoding.ASCII.GetString(store.Read(4).Value.Value));
+
+				store.Add(5, Seed("seed5"));
+			}
+
+			using (var store = new SeedStore(folder, true))
+				Assert.AreEqual(new int[] { 1, 4, 5 }, store.Ids.ToArray());
+		}
+
+		[Test]
+		public void Recover()
+		{
+			using (var store = new SeedStore(folder, false))
+			{
+				store.Add(1, Seed("one"));
+				store.Add(2, Seed("two"));
+			}
+
+			// A lost index is rebuilt from the records
+			File.Delete(Path.Combine(folder, SeedStore.IndexFile));
+
+			// A torn record at the end is ignored
+			using (var fs = new FileStream(Path.Combine(folder, SeedStore.DataFile), FileMode.Append))
+				fs.Write(new byte[] { 0x40, 0, 0, 0, 3 }, 0, 5);
+
+			using (var store = new SeedStore(folder, false))
+			{
+				Assert.AreEqual(new int[] { 1, 2 }, store.Ids.ToArray());
+				Assert.AreEqual("PKtwo", Encoding.ASCII.GetString(store.Read(2).Value.Value));
+				store.Add(3, Seed("three"));
+			}
+
+			File.Delete(Path.Combine(folder, SeedStore.IndexFile));
+
+			using (var store = new SeedStore(folder, true))
+				Assert.AreEqual(new int[] { 1, 2, 3 }, store.Ids.ToArray());
+		}
+	}
+}
@@ -0,0 +1,107 @@
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+using Peach.Core;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class WaitTimeCalibratorTests
+	{
+		[Test]
+		public void DefaultUntilCalibrated()
+		{
+			var cal = new WaitTimeCalibrator();
+
+			Assert.False(cal.IsCalibrated("State.Action"));
+			Assert.AreEqual(cal.DefaultWait, cal.GetWait("State.Action"));
+
+			cal.Record("State.Action", 20);
+			cal.Record("State.Action", 20);
+
+			Assert.False(cal.IsCalibrated("State.Action"));
+			Assert.AreEqual(cal.DefaultWait, cal.GetWait("State.Action"));
+
+			cal.Record("State.Action", 20);
+
+			Assert.True(cal.IsCalibrated("State.Action"));
+			Assert.AreEqual(30, cal.GetWait("State.Action"));
+		}
+
+		[Test]
+		public void PercentileAndMargin()
+		{
+			var cal = new WaitTimeCalibrator();
+			cal.Percentile = 0.9;
+			cal.Margin = 1.0;
+
+			for (int i = 1; i <= 10; ++i)
+				cal.Record("key", i * 10);
+
+			Assert.AreEqual(90, cal.GetWait("key"));
+
+			cal.Percentile = 1.0;
+			cal.Record("key", 10);
+
+			Assert.AreEqual(100, cal.GetWait("key"));
+		}
+
+		[Test]
+		public void Bounds()
+		{
+			var cal = new WaitTimeCalibrator();
+
+			for (int i = 0; i < 3; ++i)
+			{
+				cal.Record("fast", 0);
+				cal.Record("slow", 60000);
+			}
+
+			Assert.AreEqual(cal.MinimumWait, cal.GetWait("fast"));
+			Assert.AreEqual(cal.MaximumWait, cal.GetWait("slow"));
+			Assert.AreEqual(cal.MaximumWait, cal.MaxWait);
+		}
+
+		[Test]
+		public void RecalibratesOnline()
+		{
+			var cal = new WaitTimeCalibrator();
+			cal.WindowSize = 4;
+			cal.Margin = 1.0;
+
+			for (int i = 0; i < 4; ++i)
+				cal.Record("key", 500);
+
+			Assert.AreEqual(500, cal.GetWait("key"));
+
+			// Target got faster, old samples age out of the window
+			for (int i = 0; i < 4; ++i)
+				cal.Record("key", 50);
+
+			Assert.AreEqual(50, cal.GetWait("key"));
+		}
+
+		[Test]
+		public void ClampWaitTime()
+		{
+			var cal = new WaitTimeCalibrator();
+			cal.Margin = 1.0;
+
+			Assert.AreEqual(2m, cal.Clamp(2m));
+
+			for (int i = 0; i < 3; ++i)
+				cal.Record("a", 250);
+
+			Assert.AreEqual(0.25m, cal.Clamp(2m));
+			Assert.AreEqual(0.1m, cal.Clamp(0.1m));
+			Assert.AreEqual(0m, cal.Clamp(0m));
+
+			// Not every action calibrated yet, keep the pit value
+			cal.Record("b", 10);
+			Assert.AreEqual(2m, cal.Clamp(2m));
+		}
+	}
+}
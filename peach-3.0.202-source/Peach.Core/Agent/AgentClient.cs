@@ -245,6 +245,19 @@ namespace Peach.Core.Agent
 		/// <returns>True if a fault was detected, else false.</returns>
 		public abstract bool DetectedFault();
 
+		/// <summary>
+		/// Combined DetectedFault() and MustStop() so remote agents can
+		/// answer both in a single round trip.  The default implementation
+		/// leaves mustStop null and MustStop() is called later as usual.
+		/// </summary>
+		/// <param name="mustStop">True if session must stop, false if not, null if not known yet.</param>
+		/// <returns>True if a fault was detected, else false.</returns>
+		public virtual bool DetectedFault(out bool? mustStop)
+		{
+			mustStop = null;
+			return DetectedFault();
+		}
+
         /// <summary>
         /// Get the fault information
         /// </summary>
@@ -50,6 +50,8 @@ namespace Peach.Core.Agent
 		OrderedDictionary<string, AgentClient> _agents = new OrderedDictionary<string, AgentClient>();
 		[NonSerialized]
 		Dictionary<string, Dom.Agent> _agentDefinitions = new Dictionary<string, Dom.Agent>();
+		[NonSerialized]
+		Dictionary<AgentClient, bool> _mustStop = new Dictionary<AgentClient, bool>();
 
 		public AgentManager(RunContext context)
 		{
@@ -200,6 +202,10 @@ namespace Peach.Core.Agent
 		public virtual void IterationStarting(uint iterationCount, bool isReproduction)
 		{
 			logger.Trace("IterationStarting");
+			_mustStop.Clear();
+
+			long profile = Profiler.Begin(ProfilePhase.Agent);
+
 			foreach (AgentClient agent in _agents.Values)
 			{
 				try
@@ -211,12 +217,15 @@ namespace Peach.Core.Agent
 					logger.Warn("Ignoring exception calling IterationStarting: " + ex.Message);
 				}
 			}
+
+			Profiler.End(ProfilePhase.Agent, profile);
 		}
 
 		public virtual bool IterationFinished()
 		{
 			logger.Trace("IterationFinished");
 			bool ret = false;
+			long profile = Profiler.Begin(ProfilePhase.Agent);
 
 			foreach (AgentClient agent in _agents.Values.Reverse())
 			{
@@ -231,19 +240,28 @@ namespace Peach.Core.Agent
 				}
 			}
 
+			Profiler.End(ProfilePhase.Agent, profile);
 			return ret;
 		}
 
 		public virtual bool DetectedFault()
 		{
 			bool ret = false;
+			long profile = Profiler.Begin(ProfilePhase.Agent);
 
 			foreach (AgentClient agent in _agents.Values)
 			{
 				try
 				{
-					if (agent.DetectedFault())
+					bool? stop;
+
+					if (agent.DetectedFault(out stop))
 						ret = true;
+
+					// Agents that answered MustStop in the same round trip
+					// are not asked again this iteration
+					if (stop.HasValue)
+						_mustStop[agent] = stop.Value;
 				}
 				catch (Exception ex)
 				{
@@ -251,6 +269,7 @@ namespace Peach.Core.Agent
 				}
 			}
 
+			Profiler.End(ProfilePhase.Agent, profile);
 			logger.Trace("DetectedFault: {0}", ret);
 			return ret;
 		}
@@ -259,6 +278,7 @@ namespace Peach.Core.Agent
 		{
 			logger.Trace("GetMonitorData");
 			Dictionary<AgentClient, Fault[]> faults = new Dictionary<AgentClient, Fault[]>();
+			long profile = Profiler.Begin(ProfilePhase.Agent);
 
 			foreach (AgentClient agent in _agents.Values)
 			{
@@ -272,18 +292,27 @@ namespace Peach.Core.Agent
 				}
 			}
 
+			Profiler.End(ProfilePhase.Agent, profile);
 			return faults;
 		}
 
 		public virtual bool MustStop()
 		{
 			bool ret = false;
+			long profile = Profiler.Begin(ProfilePhase.Agent);
 
 			foreach (AgentClient agent in _agents.Values)
 			{
 				try
 				{
-					if (agent.MustStop())
+					bool stop;
+
+					if (_mustStop.TryGetValue(agent, out stop))
+					{
+						if (stop)
+							ret = true;
+					}
+					else if (agent.MustStop())
 						ret = true;
 				}
 				catch (Exception ex)
@@ -292,6 +321,7 @@ namespace Peach.Core.Agent
 				}
 			}
 
+			Profiler.End(ProfilePhase.Agent, profile);
 			logger.Trace("MustStop: {0}", ret.ToString());
 			return ret;
 		}
@@ -301,6 +331,7 @@ namespace Peach.Core.Agent
 			logger.Trace("Message: {0}", name);
 			Variant ret = null;
 			Variant tmp = null;
+			long profile = Profiler.Begin(ProfilePhase.Agent);
 
 			foreach (AgentClient agent in _agents.Values)
 			{
@@ -322,6 +353,7 @@ namespace Peach.Core.Agent
 				}
 			}
 
+			Profiler.End(ProfilePhase.Agent, profile);
 			return ret;
 		}
 
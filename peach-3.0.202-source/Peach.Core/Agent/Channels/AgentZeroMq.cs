@@ -36,7 +36,7 @@ using System.Runtime.Remoting;
 using System.Runtime.Remoting.Channels;
 using System.Runtime.Remoting.Channels.Tcp;
 using System.Threading;
-using System.Xml.Serialization;
+using System.Runtime.Serialization.Formatters.Binary;
 using Peach.Core;
 using Peach.Core.Dom;
 using NLog;
@@ -51,6 +51,152 @@ namespace Peach.Core.Agent.Channels
 		public string Method = null;
 		public object[] Arguments = null;
 		public SerializableDictionary<string, Variant> Parameters = null;
+
+		#region Wire Format
+
+		// Messages are a version byte, the method name, the argument count
+		// (-1 for null) followed by tagged arguments, and the parameters.
+		// The per-iteration calls only carry primitives so they encode to a
+		// few bytes; anything else falls back to the BinaryFormatter.
+
+		const byte Version = 1;
+
+		const byte TagNull = 0;
+		const byte TagBool = 1;
+		const byte TagInt = 2;
+		const byte TagUInt = 3;
+		const byte TagString = 4;
+		const byte TagBytes = 5;
+		const byte TagObject = 6;
+
+		public byte[] Encode()
+		{
+			using (var ms = new MemoryStream())
+			using (var wr = new BinaryWriter(ms, System.Text.Encoding.UTF8))
+			{
+				wr.Write(Version);
+				wr.Write(Method ?? "");
+
+				if (Arguments == null)
+				{
+					wr.Write(-1);
+				}
+				else
+				{
+					wr.Write(Arguments.Length);
+					foreach (var arg in Arguments)
+						WriteValue(wr, arg);
+				}
+
+				WriteValue(wr, Parameters);
+
+				wr.Flush();
+				return ms.ToArray();
+			}
+		}
+
+		public static AgentMessageZeroMq Decode(byte[] buffer, int count)
+		{
+			using (var ms = new MemoryStream(buffer, 0, count, false))
+			using (var rd = new BinaryReader(ms, System.Text.Encoding.UTF8))
+			{
+				if (rd.ReadByte() != Version)
+					throw new AgentException("Unsupported agent message version.");
+
+				var msg = new AgentMessageZeroMq();
+				msg.Method = rd.ReadString();
+
+				int argc = rd.ReadInt32();
+				if (argc >= 0)
+				{
+					msg.Arguments = new object[argc];
+					for (int i = 0; i < argc; ++i)
+						msg.Arguments[i] = ReadValue(rd);
+				}
+
+				msg.Parameters = (SerializableDictionary<string, Variant>)ReadValue(rd);
+
+				return msg;
+			}
+		}
+
+		static void WriteValue(BinaryWriter wr, object value)
+		{
+			if (value == null)
+			{
+				wr.Write(TagNull);
+			}
+			else if (value is bool)
+			{
+				wr.Write(TagBool);
+				wr.Write((bool)value);
+			}
+			else if (value is int)
+			{
+				wr.Write(TagInt);
+				wr.Write((int)value);
+			}
+			else if (value is uint)
+			{
+				wr.Write(TagUInt);
+				wr.Write((uint)value);
+			}
+			else if (value is string)
+			{
+				wr.Write(TagString);
+				wr.Write((string)value);
+			}
+			else if (value is byte[])
+			{
+				var buf = (byte[])value;
+				wr.Write(TagBytes);
+				wr.Write(buf.Length);
+				wr.Write(buf);
+			}
+			else
+			{
+				wr.Write(TagObject);
+				wr.Flush();
+
+				var pos = wr.BaseStream.Position;
+				wr.Write(0);
+				new BinaryFormatter().Serialize(wr.BaseStream, value);
+
+				var end = wr.BaseStream.Position;
+				wr.BaseStream.Position = pos;
+				wr.Write((int)(end - pos - 4));
+				wr.BaseStream.Position = end;
+			}
+		}
+
+		static object ReadValue(BinaryReader rd)
+		{
+			byte tag = rd.ReadByte();
+
+			switch (tag)
+			{
+				case TagNull:
+					return null;
+				case TagBool:
+					return rd.ReadBoolean();
+				case TagInt:
+					return rd.ReadInt32();
+				case TagUInt:
+					return rd.ReadUInt32();
+				case TagString:
+					return rd.ReadString();
+				case TagBytes:
+					return rd.ReadBytes(rd.ReadInt32());
+				case TagObject:
+					var len = rd.ReadInt32();
+					using (var ms = new MemoryStream(rd.ReadBytes(len)))
+						return new BinaryFormatter().Deserialize(ms);
+				default:
+					throw new AgentException("Unknown agent message value tag " + tag + ".");
+			}
+		}
+
+		#endregion
 	}
 
 	[Agent("zmq", true)]
@@ -89,6 +235,7 @@ namespace Peach.Core.Agent.Channels
 			if (context != null)
 				context.Dispose();
 
+			pending = null;
 			context = ZmqContext.Create();
 			client = context.CreateSocket(SocketType.REQ);
 			client.Connect(url);
@@ -110,6 +257,7 @@ namespace Peach.Core.Agent.Channels
 
 			client = null;
 			context = null;
+			pending = null;
 		}
 
 		public override Publisher CreatePublisher(string cls, SerializableDictionary<string, Variant> args)
@@ -158,14 +306,20 @@ namespace Peach.Core.Agent.Channels
 		{
 			logger.Trace("IterationStarting: {0}, {1}", iterationCount, isReproduction);
 			OnIterationStartingEvent(iterationCount, isReproduction);
-			Send("IterationStarting", iterationCount, isReproduction);
+			Post("IterationStarting", iterationCount, isReproduction);
 		}
 
+		/// <remarks>
+		/// The engine does not use the result, so the reply is collected
+		/// with the next request and the agent finishes the iteration
+		/// while the engine sleeps or collects faults.  Always returns false.
+		/// </remarks>
 		public override bool IterationFinished()
 		{
 			logger.Trace("IterationFinished");
 			OnIterationFinishedEvent();
-			return (bool)Send("IterationFinished").Arguments[0];
+			Post("IterationFinished");
+			return false;
 		}
 
 		public override bool DetectedFault()
@@ -175,6 +329,17 @@ namespace Peach.Core.Agent.Channels
 			return (bool)Send("DetectedFault").Arguments[0];
 		}
 
+		public override bool DetectedFault(out bool? mustStop)
+		{
+			logger.Trace("DetectedFault");
+			OnDetectedFaultEvent();
+			OnMustStopEvent();
+
+			var ret = Send("DetectedFaultAndMustStop");
+			mustStop = (bool)ret.Arguments[1];
+			return (bool)ret.Arguments[0];
+		}
+
 		public override Fault[] GetMonitorData()
 		{
 			logger.Trace("GetMonitorData");
@@ -196,57 +361,76 @@ namespace Peach.Core.Agent.Channels
 			return (Variant)Send("Message", name, data).Arguments[0];
 		}
 
-		XmlSerializer serializer = new XmlSerializer(typeof(AgentMessageZeroMq));
+		/// <summary>
+		/// Name of a request whose reply has not been read yet.
+		/// </summary>
+		string pending = null;
 
 		public AgentMessageZeroMq Send(string method, SerializableDictionary<string, Variant> args, params object[] arguments)
 		{
-			AgentMessageZeroMq msg = new AgentMessageZeroMq();
-			msg.Method = method;
-			msg.Arguments = arguments;
-			msg.Parameters = args;
-
-			var outWriter = new StringWriter();
-			serializer.Serialize(outWriter, msg);
-			byte[] buff = Encoding.UTF8.GetBytes(outWriter.ToString());
-			List<byte[]> frames = new List<byte[]>();
-			frames.Add(buff);
-
-			client.SendMessage(new ZmqMessage(frames));
-
+			Post(method, args, arguments);
 			return Receive();
 		}
 
 		public AgentMessageZeroMq Send(string method, params object[] arguments)
 		{
+			return Send(method, (SerializableDictionary<string, Variant>)null, arguments);
+		}
+
+		/// <summary>
+		/// Send a request without waiting for the reply.  The reply is read
+		/// before the next request goes out, so a REQ socket still sees
+		/// strictly alternating send/receive.
+		/// </summary>
+		public void Post(string method, params object[] arguments)
+		{
+			Post(method, (SerializableDictionary<string, Variant>)null, arguments);
+		}
+
+		public void Post(string method, SerializableDictionary<string, Variant> args, params object[] arguments)
+		{
+			Drain();
+
 			AgentMessageZeroMq msg = new AgentMessageZeroMq();
 			msg.Method = method;
 			msg.Arguments = arguments;
+			msg.Parameters = args;
 
-			var outWriter = new StringWriter();
-			serializer.Serialize(outWriter, msg);
-			byte[] buff = Encoding.UTF8.GetBytes(outWriter.ToString());
-			List<byte[]> frames = new List<byte[]>();
-			frames.Add(buff);
+			client.Send(msg.Encode());
+			pending = method;
+		}
 
-			client.SendMessage(new ZmqMessage(frames));
+		void Drain()
+		{
+			if (pending == null)
+				return;
 
-			return Receive();
+			try
+			{
+				Receive();
+			}
+			catch (AgentException ex)
+			{
+				logger.Warn("Ignoring exception from agent calling {0}: {1}", pending, ex.Message);
+			}
 		}
 
 		public AgentMessageZeroMq Receive()
 		{
-			using(MemoryStream sin = new MemoryStream())
+			pending = null;
+
+			var msg = AgentServerZeroMq.Receive(client);
+
+			if (msg.Method == "Exception")
 			{
-				var msg = client.ReceiveMessage();
-				foreach (Frame frame in msg)
-					sin.Write(frame.Buffer, 0, frame.BufferSize);
+				var ex = msg.Arguments != null && msg.Arguments.Length > 0 ? msg.Arguments[0] as Exception : null;
+				if (ex != null)
+					throw new AgentException(ex);
 
-				sin.Position = 0;
-				using(StreamReader reader = new StreamReader(sin, System.Text.Encoding.UTF8))
-				{
-					return (AgentMessageZeroMq)serializer.Deserialize(reader);
-				}
+				throw new AgentException("Agent reported an unknown exception.");
 			}
+
+			return msg;
 		}
 	}
 
@@ -357,7 +541,6 @@ namespace Peach.Core.Agent.Channels
 	public class AgentServerZeroMq : IAgentServer
 	{
 		#region IAgentServer Members
-		XmlSerializer serializer = new XmlSerializer(typeof(AgentMessageZeroMq));
 
 		public void Run(Dictionary<string, string> args)
 		{
@@ -373,13 +556,7 @@ namespace Peach.Core.Agent.Channels
 				AgentMessageZeroMq ack = new AgentMessageZeroMq();
 				ack.Method = "ACK";
 				ack.Arguments = null;
-				string ackMessage;
-
-				{
-					var outStr = new StringWriter();
-					serializer.Serialize(outStr, ack);
-					ackMessage = outStr.ToString();
-				}
+				byte[] ackMessage = ack.Encode();
 
 				using (ZmqContext context = ZmqContext.Create())
 				using (ZmqSocket server = context.CreateSocket(SocketType.REP))
@@ -399,29 +576,33 @@ namespace Peach.Core.Agent.Channels
 
 							agent = new AgentServiceZeroMq();
 							agent.AgentConnect(null);
-							Send(server, ackMessage);
+							server.Send(ackMessage);
 						}
 						else if (msg.Method == "StartMonitor")
 						{
 							try
 							{
 								agent.StartMonitor((string)msg.Arguments[0], (string)msg.Arguments[1], msg.Parameters);
-								Send(server, ackMessage);
+								server.Send(ackMessage);
 							}
 							catch (Exception ex)
 							{
 								Console.WriteLine(ex.ToString());
-
-								AgentMessageZeroMq rep = new AgentMessageZeroMq();
-								rep.Method = "Exception";
-								rep.Arguments = new object[1];
-								rep.Arguments[0] = ex;
-
-								var outStr = new StringWriter();
-								serializer.Serialize(outStr, rep);
-								var reply = outStr.ToString();
-
-								Send(server, reply);
+								Send(server, "Exception", ex);
+							}
+						}
+						else if (msg.Method == "DetectedFaultAndMustStop")
+						{
+							try
+							{
+								bool fault = agent.DetectedFault();
+								bool mustStop = agent.MustStop();
+								Send(server, "ACK", fault, mustStop);
+							}
+							catch (Exception ex)
+							{
+								Console.WriteLine(ex.ToString());
+								Send(server, "Exception", ex);
 							}
 						}
 						else
@@ -448,35 +629,14 @@ namespace Peach.Core.Agent.Channels
 									ret = method.Invoke(agent, msg.Arguments);
 
 								if (ret == null)
-									Send(server, ackMessage);
+									server.Send(ackMessage);
 								else
-								{
-									AgentMessageZeroMq rep = new AgentMessageZeroMq();
-									rep.Method = "ACK";
-									rep.Arguments = new object[1];
-									rep.Arguments[0] = ret;
-
-									var outStr = new StringWriter();
-									serializer.Serialize(outStr, rep);
-									var reply = outStr.ToString();
-
-									Send(server, reply);
-								}
+									Send(server, "ACK", ret);
 							}
 							catch (Exception ex)
 							{
 								Console.WriteLine(ex.ToString());
-
-								AgentMessageZeroMq rep = new AgentMessageZeroMq();
-								rep.Method = "Exception";
-								rep.Arguments = new object[1];
-								rep.Arguments[0] = ex;
-
-								var outStr = new StringWriter();
-								serializer.Serialize(outStr, rep);
-								var reply = outStr.ToString();
-
-								Send(server, reply);
+								Send(server, "Exception", ex);
 							}
 						}
 					}
@@ -488,65 +648,34 @@ namespace Peach.Core.Agent.Channels
 			}
 		}
 
-		public void Send(ZmqSocket socket, string message)
+		static void Send(ZmqSocket socket, string method, params object[] arguments)
 		{
-			byte[] msg = Encoding.UTF8.GetBytes(message);
-			List<byte[]> frames = new List<byte[]>();
-			int parts = msg.Length / (1024 * 32);
-
-			if (parts > 0)
-			{
-				byte[] frame = new byte[1024 * 32];
-				int start;
-
-				for (int cnt = 0; cnt < parts; cnt++)
-				{
-					start = cnt * (1024 * 32);
-
-					for (int i = 0; i < (1024 * 32); i++)
-						frame[i] = msg[start + i];
+			AgentMessageZeroMq rep = new AgentMessageZeroMq();
+			rep.Method = method;
+			rep.Arguments = arguments;
 
-					frames.Add(frame);
-				}
-
-				if (msg.Length % (1024 * 32) > 0)
-				{
-					start = (parts + 1) * (1024 * 32);
-					byte[] last = new byte[msg.Length - start];
-
-					for (int cnt = 0; (start + cnt) < msg.Length; cnt++)
-					{
-						last[cnt] = msg[start + cnt];
-					}
+			socket.Send(rep.Encode());
+		}
 
-					frames.Add(last);
-				}
+		public static AgentMessageZeroMq Receive(ZmqSocket socket)
+		{
+			var msg = socket.ReceiveMessage();
 
+			if (msg.FrameCount == 1)
+			{
+				var frame = msg.First();
+				return AgentMessageZeroMq.Decode(frame.Buffer, frame.BufferSize);
 			}
-			else
-				frames.Add(msg);
-
-			ZmqMessage zmessage = new ZmqMessage(frames);
-			socket.SendMessage(zmessage);
-		}
 
-		public AgentMessageZeroMq Receive(ZmqSocket socket)
-		{
 			using (MemoryStream sin = new MemoryStream())
 			{
-				var msg = socket.ReceiveMessage();
 				foreach (Frame frame in msg)
 					sin.Write(frame.Buffer, 0, frame.BufferSize);
 
-				sin.Position = 0;
-				using (StreamReader reader = new StreamReader(sin, System.Text.Encoding.UTF8))
-				{
-					return (AgentMessageZeroMq) serializer.Deserialize(reader);
-				}
+				return AgentMessageZeroMq.Decode(sin.GetBuffer(), (int)sin.Length);
 			}
 		}
 
-
 		#endregion
 	}
 }
@@ -279,8 +279,9 @@ namespace Peach.Core.Agent.Monitors
 
 		public override bool IterationFinished()
 		{
-			Console.WriteLine("feilong: iterationFinished status: " + iterationCount + isReproduction +  "_messageExit: " + _messageExit + 
-			" FaultOnEarlyExit:" + FaultOnEarlyExit + " _IsRunning:" + _IsRunning());
+			if (logger.IsTraceEnabled)
+				logger.Trace("feilong: iterationFinished status: " + iterationCount + isReproduction +  "_messageExit: " + _messageExit + 
+				" FaultOnEarlyExit:" + FaultOnEarlyExit + " _IsRunning:" + _IsRunning());
 
 			
 			if (!_messageExit && FaultOnEarlyExit && !_IsRunning())
@@ -0,0 +1,332 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Text;
+using System.Text.RegularExpressions;
+
+namespace Peach.Core.Agent
+{
+	/// <summary>
+	/// ASAN/MSAN/UBSAN report parsed as it is received.
+	/// </summary>
+	/// <remarks>
+	/// Data is fed with Append() in whatever chunks the target wrote, only
+	/// complete lines are parsed.  The report is Complete once the
+	/// sanitizer printed its SUMMARY line.
+	/// </remarks>
+	public class SanitizerReport
+	{
+		const int MajorFrames = 5;
+
+		static readonly Regex reError = new Regex(@"^==\d+==(?:ERROR|WARNING): (\w+): ([\w-]+)");
+		static readonly Regex rePc = new Regex(@"\bpc (0x[0-9a-fA-F]+)");
+		static readonly Regex reAccess = new Regex(@"^(READ|WRITE) of size (\d+)");
+		static readonly Regex reSignalAccess = new Regex(@"caused by a (READ|WRITE) memory access");
+		static readonly Regex reFrame = new Regex(@"^\s*#(\d+)\s+(0x[0-9a-fA-F]+)\s+(?:in\s+)?(.*)$");
+		static readonly Regex reRuntimeError = new Regex(@"^(.+?:\d+(?::\d+)?): runtime error: (.*)$");
+		static readonly Regex reSummary = new Regex(@"^SUMMARY: (\w+): (.*)$");
+
+		MemoryStream _data = new MemoryStream();
+		Decoder _decoder = System.Text.Encoding.UTF8.GetDecoder();
+		StringBuilder _line = new StringBuilder();
+		List<string> _frames = new List<string>();
+		bool _framesDone = false;
+
+		/// <summary>
+		/// Sanitizer that reported, e.g. AddressSanitizer.
+		/// </summary>
+		public string Tool { get; private set; }
+
+		/// <summary>
+		/// Kind of bug, e.g. heap-buffer-overflow, or the runtime error
+		/// message for UBSAN.
+		/// </summary>
+		public string BugType { get; private set; }
+
+		/// <summary>
+		/// READ or WRITE when the report says so.
+		/// </summary>
+		public string Access { get; private set; }
+
+		public int AccessSize { get; private set; }
+
+		/// <summary>
+		/// Faulting pc, 0 if not reported.
+		/// </summary>
+		public ulong Pc { get; private set; }
+
+		/// <summary>
+		/// Source location of a UBSAN runtime error.
+		/// </summary>
+		public string Location { get; private set; }
+
+		/// <summary>
+		/// Frames of the first stack in the report, without addresses.
+		/// </summary>
+		public IList<string> Frames
+		{
+			get { return _frames; }
+		}
+
+		public string Summary { get; private set; }
+
+		/// <summary>
+		/// A report has started.
+		/// </summary>
+		public bool Detected
+		{
+			get { return Tool != null; }
+		}
+
+		/// <summary>
+		/// The SUMMARY line of the report was received.
+		/// </summary>
+		public bool Complete
+		{
+			get { return Summary != null; }
+		}
+
+		/// <summary>
+		/// Everything received so far.
+		/// </summary>
+		public byte[] ToArray()
+		{
+			return _data.ToArray();
+		}
+
+		public void Append(byte[] buf)
+		{
+			Append(buf, 0, buf.Length);
+		}
+
+		public void Append(byte[] buf, int offset, int count)
+		{
+			if (count == 0)
+				return;
+
+			_data.Write(buf, offset, count);
+
+			var chars = new char[_decoder.GetCharCount(buf, offset, count)];
+			_decoder.GetChars(buf, offset, count, chars, 0);
+
+			foreach (var ch in chars)
+			{
+				if (ch == '\n')
+				{
+					ParseLine(_line.ToString().TrimEnd('\r'));
+					_line.Length = 0;
+				}
+				else
+				{
+					_line.Append(ch);
+				}
+			}
+		}
+
+		void ParseLine(string line)
+		{
+			if (line.Length == 0)
+			{
+				if (_frames.Count > 0)
+					_framesDone = true;
+				return;
+			}
+
+			var m = reSummary.Match(line);
+			if (m.Success)
+			{
+				if (Tool == null)
+					Tool = m.Groups[1].Value;
+				Summary = m.Groups[2].Value;
+				return;
+			}
+
+			// Only the first report is described, later ones are kept as text
+			if (Complete)
+				return;
+
+			m = reFrame.Match(line);
+			if (m.Success)
+			{
+				if (m.Groups[1].Value == "0" && _frames.Count > 0)
+					_framesDone = true;
+
+				if (!_framesDone)
+				{
+					if (_frames.Count == 0 && Pc == 0)
+						Pc = ParseHex(m.Groups[2].Value);
+					_frames.Add(m.Groups[3].Value.Trim());
+				}
+				return;
+			}
+
+			m = reError.Match(line);
+			if (m.Success)
+			{
+				if (Tool == null)
+				{
+					Tool = m.Groups[1].Value;
+					BugType = m.Groups[2].Value;
+
+					var pc = rePc.Match(line);
+					if (pc.Success)
+						Pc = ParseHex(pc.Groups[1].Value);
+				}
+				return;
+			}
+
+			m = reRuntimeError.Match(line);
+			if (m.Success)
+			{
+				if (Tool == null)
+				{
+					Tool = "UndefinedBehaviorSanitizer";
+					Location = m.Groups[1].Value;
+					BugType = m.Groups[2].Value;
+				}
+				return;
+			}
+
+			if (Access == null)
+			{
+				m = reAccess.Match(line);
+				if (m.Success)
+				{
+					Access = m.Groups[1].Value;
+					AccessSize = int.Parse(m.Groups[2].Value);
+					return;
+				}
+
+				m = reSignalAccess.Match(line);
+				if (m.Success)
+					Access = m.Groups[1].Value;
+			}
+		}
+
+		static ulong ParseHex(string str)
+		{
+			return ulong.Parse(str.Substring(2), NumberStyles.HexNumber);
+		}
+
+		/// <summary>
+		/// Short title for the fault, e.g.
+		/// "AddressSanitizer: heap-buffer-overflow READ of size 4".
+		/// </summary>
+		public string Title
+		{
+			get
+			{
+				var sb = new StringBuilder();
+				sb.AppendFormat("{0}: {1}", Tool, BugType);
+				if (Access != null)
+				{
+					sb.Append(" " + Access);
+					if (AccessSize != 0)
+						sb.AppendFormat(" of size {0}", AccessSize);
+				}
+				if (Location != null)
+					sb.Append(" at " + Location);
+				else if (_frames.Count > 0)
+					sb.Append(" in " + _frames[0]);
+				return sb.ToString();
+			}
+		}
+
+		/// <summary>
+		/// Hash of the bug type and the top frames.  Frames are hashed
+		/// without addresses so the hash survives ASLR.
+		/// </summary>
+		public string MajorHash
+		{
+			get { return Hash(Math.Min(MajorFrames, _frames.Count)); }
+		}
+
+		/// <summary>
+		/// Hash of the bug type and all frames.
+		/// </summary>
+		public string MinorHash
+		{
+			get { return Hash(_frames.Count); }
+		}
+
+		string Hash(int frames)
+		{
+			uint h = Fnv(2166136261u, BugType ?? "");
+			if (Location != null)
+				h = Fnv(h, Location);
+			for (int i = 0; i < frames; ++i)
+				h = Fnv(h, _frames[i]);
+			return h.ToString("x8");
+		}
+
+		static uint Fnv(uint h, string str)
+		{
+			foreach (var b in System.Text.Encoding.UTF8.GetBytes(str))
+			{
+				h ^= b;
+				h *= 16777619u;
+			}
+			return h;
+		}
+
+		/// <summary>
+		/// Rough classification in the terms used by the debugger monitors.
+		/// </summary>
+		public string Exploitability
+		{
+			get
+			{
+				switch (BugType)
+				{
+					case "heap-use-after-free":
+					case "attempting": // double-free or bad free
+						return "EXPLOITABLE";
+					case "heap-buffer-overflow":
+					case "stack-buffer-overflow":
+					case "global-buffer-overflow":
+					case "stack-use-after-return":
+					case "stack-use-after-scope":
+					case "container-overflow":
+						return Access == "WRITE" ? "EXPLOITABLE" : "PROBABLY_EXPLOITABLE";
+					case "SEGV":
+						return Access == "WRITE" ? "PROBABLY_EXPLOITABLE" : "PROBABLY_NOT_EXPLOITABLE";
+					case null:
+						return "UNKNOWN";
+					default:
+						return Tool == "UndefinedBehaviorSanitizer" ? "PROBABLY_NOT_EXPLOITABLE" : "UNKNOWN";
+				}
+			}
+		}
+	}
+}
+
+// end
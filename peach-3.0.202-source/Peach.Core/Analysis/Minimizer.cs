@@ -0,0 +1,630 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Text.RegularExpressions;
+using System.Threading;
+
+using Peach.Core;
+using Peach.Core.Dom;
+using Peach.Core.Cracker;
+using Peach.Core.IO;
+
+using NLog;
+
+namespace Peach.Core.Analysis
+{
+	public delegate void MinimizeStepEventHandler(Minimizer sender, string step, int actions, long bytes);
+
+	/// <summary>
+	/// The data actions of a saved fault, as cracked data models.
+	/// </summary>
+	/// <remarks>
+	/// Actions are numbered the same way as the action_N files written by
+	/// FileLogger, and named "state.action".  Only Output actions carry
+	/// data; every other data action is performed as described by the pit.
+	/// </remarks>
+	public class ReplayCase
+	{
+		/// <summary>
+		/// Data to send for each Output action.
+		/// </summary>
+		public SortedDictionary<int, DataModel> Data = new SortedDictionary<int, DataModel>();
+
+		/// <summary>
+		/// Data actions that are left out of the replay.
+		/// </summary>
+		public HashSet<int> Skipped = new HashSet<int>();
+
+		/// <summary>
+		/// Qualified action name ("state.action") for each entry in Data.
+		/// </summary>
+		public Dictionary<int, string> Names = new Dictionary<int, string>();
+
+		/// <summary>
+		/// Unmodified pit data model for each entry in Data.  Shared between clones.
+		/// </summary>
+		public Dictionary<int, DataModel> Defaults = new Dictionary<int, DataModel>();
+
+		/// <summary>
+		/// Data to send for every other Output action, keyed by data model name.
+		/// </summary>
+		public Dictionary<string, DataModel> Models = new Dictionary<string, DataModel>();
+
+		static readonly Regex fileName = new Regex(@"^action_(\d+)_Output_(.*)\.txt$");
+
+		public ReplayCase Clone()
+		{
+			var ret = new ReplayCase();
+			ret.Names = Names;
+			ret.Defaults = Defaults;
+			ret.Skipped = new HashSet<int>(Skipped);
+
+			foreach (var kv in Data)
+				ret.Data.Add(kv.Key, kv.Value.Clone() as DataModel);
+
+			foreach (var kv in Models)
+				ret.Models.Add(kv.Key, kv.Value.Clone() as DataModel);
+
+			return ret;
+		}
+
+		/// <summary>
+		/// Number of Output actions that are still sent.
+		/// </summary>
+		public int ActionCount
+		{
+			get { return Data.Keys.Count(k => !Skipped.Contains(k)); }
+		}
+
+		/// <summary>
+		/// Total size of the Output actions that are still sent.
+		/// </summary>
+		public long ByteCount
+		{
+			get { return Data.Where(kv => !Skipped.Contains(kv.Key)).Sum(kv => kv.Value.Value.LengthBytes); }
+		}
+
+		/// <summary>
+		/// Load the Output actions saved in a fault folder, cracking each
+		/// one into the data model of the matching action in 'stateModel'.
+		/// Data that no longer cracks is kept as a single Blob.
+		/// </summary>
+		public static ReplayCase Load(string faultPath, StateModel stateModel)
+		{
+			var ret = new ReplayCase();
+
+			foreach (var file in Directory.GetFiles(faultPath, "action_*.txt"))
+			{
+				var m = fileName.Match(Path.GetFileName(file));
+				if (!m.Success)
+					continue;
+
+				int index = int.Parse(m.Groups[1].Value);
+				string name = m.Groups[2].Value;
+
+				var action = FindAction(stateModel, name, file);
+				var bytes = File.ReadAllBytes(file);
+				var dataModel = action.dataModel.Clone() as DataModel;
+
+				try
+				{
+					new DataCracker().CrackData(dataModel, new BitStream(bytes));
+				}
+				catch (CrackingFailure)
+				{
+					dataModel = BlobModel(action.dataModel.name, bytes);
+				}
+
+				ret.Data.Add(index, dataModel);
+				ret.Names.Add(index, name);
+				ret.Defaults.Add(index, action.dataModel.Clone() as DataModel);
+			}
+
+			if (ret.Data.Count == 0)
+				throw new PeachException("Error, no output actions found in \"" + faultPath + "\".");
+
+			return ret;
+		}
+
+		static Dom.Action FindAction(StateModel stateModel, string name, string file)
+		{
+			var actions = stateModel.states.Values.SelectMany(s => s.actions).Where(a => a.dataModel != null).ToList();
+			var action = actions.FirstOrDefault(a => a.parent.name + "." + a.name == name);
+			if (action != null)
+				return action;
+
+			// Faults saved before action files were qualified with the state
+			var matches = actions.Where(a => a.name == name).ToList();
+			if (matches.Count > 1)
+				throw new PeachException("Error, output action name \"" + name + "\" for \"" + file + "\" is used by more than one state.");
+			if (matches.Count == 0)
+				throw new PeachException("Error, unable to locate output action named \"" + name + "\" for \"" + file + "\".");
+
+			return matches[0];
+		}
+
+		static DataModel BlobModel(string name, byte[] bytes)
+		{
+			var dataModel = new DataModel(name);
+			var blob = new Blob("Data");
+			blob.DefaultValue = new Variant(bytes);
+			dataModel.Add(blob);
+			return dataModel;
+		}
+
+		/// <summary>
+		/// Replay a seed pool entry.  Seeds are the data model of the output
+		/// that found a new path, so the seed is sent by every Output action
+		/// that uses a data model of the same name.
+		/// </summary>
+		public static ReplayCase FromSeed(DataModel seed)
+		{
+			var ret = new ReplayCase();
+			ret.Models.Add(seed.name, seed);
+			return ret;
+		}
+
+		/// <summary>
+		/// Write the Output actions that are still sent to 'path'.
+		/// </summary>
+		public void Save(string path)
+		{
+			if (!Directory.Exists(path))
+				Directory.CreateDirectory(path);
+
+			foreach (var kv in Data)
+			{
+				if (Skipped.Contains(kv.Key))
+					continue;
+
+				string file = Path.Combine(path, string.Format("action_{0}_Output_{1}.txt", kv.Key, Names[kv.Key]));
+				File.WriteAllBytes(file, kv.Value.Value.Value);
+			}
+		}
+
+		/// <summary>
+		/// Write the data that is still sent to 'writer' as rendered bytes,
+		/// for a replay in another process.  See Read().
+		/// </summary>
+		public void Write(BinaryWriter writer)
+		{
+			var sent = Data.Where(kv => !Skipped.Contains(kv.Key)).ToList();
+
+			writer.Write(sent.Count);
+			foreach (var kv in sent)
+			{
+				writer.Write(kv.Key);
+				WriteModel(writer, kv.Value);
+			}
+
+			writer.Write(Skipped.Count);
+			foreach (var index in Skipped)
+				writer.Write(index);
+
+			writer.Write(Models.Count);
+			foreach (var dataModel in Models.Values)
+				WriteModel(writer, dataModel);
+		}
+
+		static void WriteModel(BinaryWriter writer, DataModel dataModel)
+		{
+			var bytes = dataModel.Value.Value;
+
+			writer.Write(dataModel.name);
+			writer.Write(bytes.Length);
+			writer.Write(bytes);
+		}
+
+		/// <summary>
+		/// Read a case written by Write(), or null if 'reader' is at its end.
+		/// Every data model is read back as a single Blob holding the bytes
+		/// the writer rendered, so it is sent unchanged.
+		/// </summary>
+		public static ReplayCase Read(BinaryReader reader)
+		{
+			int count;
+
+			try
+			{
+				count = reader.ReadInt32();
+			}
+			catch (EndOfStreamException)
+			{
+				return null;
+			}
+
+			var ret = new ReplayCase();
+
+			for (int i = 0; i < count; ++i)
+			{
+				int index = reader.ReadInt32();
+				ret.Data.Add(index, ReadModel(reader));
+			}
+
+			count = reader.ReadInt32();
+			for (int i = 0; i < count; ++i)
+				ret.Skipped.Add(reader.ReadInt32());
+
+			count = reader.ReadInt32();
+			for (int i = 0; i < count; ++i)
+			{
+				var dataModel = ReadModel(reader);
+				ret.Models.Add(dataModel.name, dataModel);
+			}
+
+			return ret;
+		}
+
+		static DataModel ReadModel(BinaryReader reader)
+		{
+			string name = reader.ReadString();
+			int length = reader.ReadInt32();
+			var bytes = reader.ReadBytes(length);
+			if (bytes.Length != length)
+				throw new EndOfStreamException();
+
+			return BlobModel(name, bytes);
+		}
+	}
+
+	/// <summary>
+	/// Shrink a fault reproducer while it keeps producing the same fault.
+	/// </summary>
+	/// <remarks>
+	/// Each pass tries, in order: leaving out whole Output actions,
+	/// dropping the second half and then single items of every array,
+	/// reverting leaf elements to the pit default, and halving blobs.
+	/// A change is kept when the replay reports the same fault bucket
+	/// (and, with CheckCoverage, the same coverage hash).  Passes repeat
+	/// until one keeps nothing.
+	///
+	/// With several replayers the candidates are replayed in batches, one
+	/// per replayer.  The first candidate of a batch that reproduces wins,
+	/// so the result is the same as replaying them one at a time.  An
+	/// EngineReplayer uses state shared by the whole process (the coverage
+	/// map, PeachStar queues, Action.Starting), so parallel jobs must each
+	/// be a WorkerReplayer running its own Peach process.
+	/// </remarks>
+	public class Minimizer
+	{
+		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
+
+		public event MinimizeStepEventHandler StepKept;
+
+		protected void OnStepKept(string step, ReplayCase current)
+		{
+			if (StepKept != null)
+				StepKept(this, step, current.ActionCount, current.ByteCount);
+		}
+
+		class Step
+		{
+			public string Name;
+			public Func<ReplayCase, bool> Apply;
+
+			public Step(string name, Func<ReplayCase, bool> apply)
+			{
+				Name = name;
+				Apply = apply;
+			}
+		}
+
+		IReplayer[] _replayers;
+		string _signature;
+		int? _coverage;
+
+		public Minimizer(IEnumerable<IReplayer> replayers)
+		{
+			_replayers = replayers.ToArray();
+
+			if (_replayers.Length == 0)
+				throw new ArgumentException("At least one replayer is required.", "replayers");
+
+			if (_replayers.Length > 1 && _replayers.Any(r => r is EngineReplayer))
+				throw new ArgumentException("Parallel replays need a WorkerReplayer per job, EngineReplayer uses process wide state.", "replayers");
+		}
+
+		/// <summary>
+		/// Also require the coverage hash of the original replay.
+		/// </summary>
+		public bool CheckCoverage { get; set; }
+
+		/// <summary>
+		/// Number of replays performed by the last Run().
+		/// </summary>
+		public int Replays { get; private set; }
+
+		/// <summary>
+		/// Fault bucket reproduced by the last Run().
+		/// </summary>
+		public string FaultSignature
+		{
+			get { return _signature; }
+		}
+
+		/// <summary>
+		/// Fault bucket name, matching the folder FileLogger saves the fault under.
+		/// </summary>
+		public static string Signature(Fault fault)
+		{
+			if (fault.folderName != null)
+				return fault.folderName;
+
+			if (fault.majorHash == null && fault.minorHash == null && fault.exploitability == null)
+				return "Unknown";
+
+			return string.Format("{0}_{1}_{2}", fault.exploitability, fault.majorHash, fault.minorHash);
+		}
+
+		public ReplayCase Run(ReplayCase original)
+		{
+			Replays = 0;
+
+			var first = Replay(new ReplayCase[] { original.Clone() })[0];
+			if (first == null || first.Signature == null)
+				throw new PeachException("Error, the fault did not reproduce.");
+
+			_signature = first.Signature;
+			_coverage = first.Coverage;
+
+			logger.Debug("Run: reproduced fault '{0}'", _signature);
+
+			var current = original;
+			bool progress = true;
+
+			while (progress)
+			{
+				progress = false;
+
+				var steps = Steps(current);
+				int i = 0;
+
+				while (i < steps.Count)
+				{
+					var batch = new List<ReplayCase>();
+					var batchSteps = new List<int>();
+
+					while (batch.Count < _replayers.Length && i < steps.Count)
+					{
+						var candidate = current.Clone();
+						if (steps[i].Apply(candidate))
+						{
+							batch.Add(candidate);
+							batchSteps.Add(i);
+						}
+
+						++i;
+					}
+
+					if (batch.Count == 0)
+						continue;
+
+					var results = Replay(batch);
+
+					for (int j = 0; j < results.Length; ++j)
+					{
+						if (!Matches(results[j]))
+							continue;
+
+						current = batch[j];
+						progress = true;
+						OnStepKept(steps[batchSteps[j]].Name, current);
+
+						// Later candidates in the batch were built from the old case
+						i = batchSteps[j] + 1;
+						break;
+					}
+				}
+			}
+
+			return current;
+		}
+
+		bool Matches(ReplayResult result)
+		{
+			if (result == null || result.Signature != _signature)
+				return false;
+
+			return !CheckCoverage || result.Coverage == _coverage;
+		}
+
+		ReplayResult[] Replay(IList<ReplayCase> batch)
+		{
+			var results = new ReplayResult[batch.Count];
+			Replays += batch.Count;
+
+			if (batch.Count == 1)
+			{
+				results[0] = SafeReplay(_replayers[0], batch[0]);
+				return results;
+			}
+
+			var threads = new Thread[batch.Count];
+			for (int i = 0; i < batch.Count; ++i)
+			{
+				int n = i;
+				threads[n] = new Thread(delegate()
+				{
+					results[n] = SafeReplay(_replayers[n], batch[n]);
+				});
+				threads[n].Start();
+			}
+
+			foreach (var t in threads)
+				t.Join();
+
+			return results;
+		}
+
+		static ReplayResult SafeReplay(IReplayer replayer, ReplayCase replayCase)
+		{
+			try
+			{
+				return replayer.Replay(replayCase);
+			}
+			catch (Exception ex)
+			{
+				logger.Debug("Replay failed: {0}", ex.Message);
+				return null;
+			}
+		}
+
+		List<Step> Steps(ReplayCase current)
+		{
+			var ret = new List<Step>();
+
+			foreach (var kv in current.Data.Reverse())
+			{
+				int index = kv.Key;
+				if (current.Skipped.Contains(index))
+					continue;
+
+				ret.Add(new Step("remove action " + index, c => c.Skipped.Add(index)));
+			}
+
+			foreach (var kv in current.Data)
+			{
+				int index = kv.Key;
+				if (current.Skipped.Contains(index))
+					continue;
+
+				foreach (var array in kv.Value.EnumerateAllElements().OfType<Dom.Array>().ToList())
+				{
+					string name = array.fullName;
+
+					if (array.Count > 1)
+						ret.Add(new Step("halve " + name, c => HalveArray(c, index, name)));
+
+					for (int item = array.Count - 1; item >= 0; --item)
+					{
+						string itemName = array[item].name;
+						ret.Add(new Step("remove " + name + "." + itemName, c => RemoveItem(c, index, name, itemName)));
+					}
+				}
+			}
+
+			foreach (var kv in current.Data)
+			{
+				int index = kv.Key;
+				if (current.Skipped.Contains(index))
+					continue;
+
+				DataModel defaults;
+				current.Defaults.TryGetValue(index, out defaults);
+
+				foreach (var elem in kv.Value.EnumerateAllElements().Where(e => e.isLeafNode).ToList())
+				{
+					string name = elem.fullName;
+
+					if (defaults != null && CanRevert(elem, defaults.find(name)))
+						ret.Add(new Step("revert " + name, c => Revert(c, index, name)));
+
+					if (elem is Blob && elem.Value.LengthBytes > 1)
+						ret.Add(new Step("halve " + name, c => HalveBlob(c, index, name)));
+				}
+			}
+
+			return ret;
+		}
+
+		static bool CanRevert(DataElement elem, DataElement orig)
+		{
+			if (elem == null || orig == null || orig.GetType() != elem.GetType())
+				return false;
+
+			// Values computed from a relation or fixup follow the rest of the model
+			if (elem.fixup != null || elem.relations.Any(r => r.From == elem))
+				return false;
+
+			return !elem.Value.Value.SequenceEqual(orig.Value.Value);
+		}
+
+		static DataElement Find(ReplayCase c, int index, string name)
+		{
+			// Changes to an action that is no longer sent prove nothing
+			if (c.Skipped.Contains(index))
+				return null;
+
+			return c.Data[index].find(name);
+		}
+
+		static bool HalveArray(ReplayCase c, int index, string name)
+		{
+			var array = Find(c, index, name) as Dom.Array;
+			if (array == null || array.Count < 2)
+				return false;
+
+			for (int i = array.Count - 1; i >= array.Count / 2; --i)
+				array.RemoveAt(i);
+
+			return true;
+		}
+
+		static bool RemoveItem(ReplayCase c, int index, string name, string itemName)
+		{
+			var array = Find(c, index, name) as Dom.Array;
+			if (array == null || !array.ContainsKey(itemName))
+				return false;
+
+			array.RemoveAt(array.IndexOf(array[itemName]));
+			return true;
+		}
+
+		static bool Revert(ReplayCase c, int index, string name)
+		{
+			var elem = Find(c, index, name);
+			var orig = c.Defaults[index].find(name);
+			if (!CanRevert(elem, orig))
+				return false;
+
+			elem.DefaultValue = orig.DefaultValue;
+			return true;
+		}
+
+		static bool HalveBlob(ReplayCase c, int index, string name)
+		{
+			var elem = Find(c, index, name) as Blob;
+			if (elem == null)
+				return false;
+
+			var bytes = elem.Value.Value;
+			if (bytes.Length < 2)
+				return false;
+
+			elem.DefaultValue = new Variant(bytes.Take(bytes.Length / 2).ToArray());
+			return true;
+		}
+	}
+}
+
+// end
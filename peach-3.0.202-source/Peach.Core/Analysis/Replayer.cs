@@ -0,0 +1,390 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using Peach.Core;
+using Peach.Core.Dom;
+
+using NLog;
+
+namespace Peach.Core.Analysis
+{
+	/// <summary>
+	/// Outcome of replaying a ReplayCase.
+	/// </summary>
+	public class ReplayResult
+	{
+		/// <summary>
+		/// Faults reported by the agents, or null if the replay did not fault.
+		/// </summary>
+		public Fault[] Faults = null;
+
+		/// <summary>
+		/// Hash of the classified coverage map after the last output.
+		/// Only set when the replayer was asked to collect coverage.
+		/// </summary>
+		public int? Coverage = null;
+
+		/// <summary>
+		/// Features of the classified coverage of every output, see
+		/// InfluenceMap.TraceFeatures().  Only set when the replayer was
+		/// asked to collect the trace.
+		/// </summary>
+		public uint[] Trace = null;
+
+		/// <summary>
+		/// Bucket of the core fault, as used for the folder name by FileLogger.
+		/// </summary>
+		public string Signature
+		{
+			get
+			{
+				if (Faults == null)
+					return null;
+
+				var core = Faults.FirstOrDefault(f => f.type == FaultType.Fault);
+				if (core == null)
+					return null;
+
+				return Minimizer.Signature(core);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Runs a ReplayCase against a target.
+	/// </summary>
+	/// <remarks>
+	/// Replay() is called from a separate thread for each replayer when the
+	/// minimizer runs several at once, so each instance must own its target.
+	/// </remarks>
+	public interface IReplayer
+	{
+		ReplayResult Replay(ReplayCase replayCase);
+	}
+
+	/// <summary>
+	/// Replays a case by running a single iteration of a pit test.
+	/// </summary>
+	public class EngineReplayer : IReplayer
+	{
+		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
+
+		Dom.Dom _dom;
+		Test _test;
+		bool _coverage;
+
+		/// <param name="dom">Parsed pit owned by this replayer</param>
+		/// <param name="testName">Test to run</param>
+		/// <param name="coverage">Collect the coverage hash after each replay</param>
+		public EngineReplayer(Dom.Dom dom, string testName, bool coverage)
+		{
+			if (!dom.tests.TryGetValue(testName, out _test))
+				throw new PeachException("Error, unable to locate test named \"" + testName + "\".");
+
+			_dom = dom;
+			_coverage = coverage;
+
+			// Replays must not be logged as new faults or retried by the engine
+			_test.loggers = new List<Logger>();
+			_test.replayEnabled = false;
+		}
+
+		/// <summary>
+		/// Collect the coverage of every output into ReplayResult.Trace.
+		/// </summary>
+		public bool CollectTrace { get; set; }
+
+		public ReplayResult Replay(ReplayCase replayCase)
+		{
+			var result = new ReplayResult();
+			var engine = new Engine(null);
+
+			engine.Fault += delegate(RunContext context, uint currentIteration, StateModel stateModel, Fault[] faults)
+			{
+				result.Faults = faults;
+			};
+
+			var config = new RunConfiguration();
+			config.runName = _test.name;
+			config.singleIteration = true;
+
+			_test.strategy = new ReplayStrategy(replayCase);
+
+			// Nothing left over from the last replay may be spliced into
+			// this one, and nothing this replay finds is queued
+			bool ifuse = Peach.Core.Runtime.SHARE.ifuse;
+			Peach.Core.Runtime.SHARE.ifuse = false;
+			Peach.Core.Runtime.SHARE.ResetSplicing();
+
+			if (CollectTrace)
+			{
+				InfluenceMap.Tracing = true;
+				InfluenceMap.ResetTrace();
+			}
+
+			try
+			{
+				engine.startFuzzing(_dom, _test, config);
+			}
+			catch (PeachException ex)
+			{
+				// A fault on the replayed iteration ends the run with
+				// "Fault detected on control iteration."
+				if (result.Faults == null)
+					throw;
+
+				logger.Debug("Replay: {0}", ex.Message);
+			}
+			finally
+			{
+				InfluenceMap.Tracing = false;
+				Peach.Core.Runtime.SHARE.ifuse = ifuse;
+			}
+
+			if (_coverage)
+				result.Coverage = Dom.Action.hash_after_classify();
+
+			if (CollectTrace)
+				result.Trace = InfluenceMap.TraceFeatures();
+
+			return result;
+		}
+	}
+
+	/// <summary>
+	/// Replays cases in a separate Peach process.
+	/// </summary>
+	/// <remarks>
+	/// The process is started from 'startInfo' and is expected to run an
+	/// EngineReplayer over the cases it reads from stdin (see
+	/// ReplayCase.Write()), answering each one with a line on stdout made
+	/// by FormatResult().  Every other line it prints is logged.  Closing
+	/// stdin tells the worker to exit.
+	/// </remarks>
+	public class WorkerReplayer : IReplayer, IDisposable
+	{
+		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
+
+		const string ResultPrefix = "peach-replay-result\t";
+
+		Process _process;
+		BinaryWriter _writer;
+
+		public WorkerReplayer(ProcessStartInfo startInfo)
+		{
+			startInfo.UseShellExecute = false;
+			startInfo.RedirectStandardInput = true;
+			startInfo.RedirectStandardOutput = true;
+
+			_process = Process.Start(startInfo);
+			_writer = new BinaryWriter(_process.StandardInput.BaseStream);
+		}
+
+		public ReplayResult Replay(ReplayCase replayCase)
+		{
+			replayCase.Write(_writer);
+			_writer.Flush();
+
+			while (true)
+			{
+				string line = _process.StandardOutput.ReadLine();
+				if (line == null)
+					throw new PeachException("Error, replay worker " + _process.Id + " exited.");
+
+				if (line.StartsWith(ResultPrefix))
+					return ParseResult(line.Substring(ResultPrefix.Length));
+
+				logger.Debug("Worker {0}: {1}", _process.Id, line);
+			}
+		}
+
+		/// <summary>
+		/// Line a worker prints for the result of a replay, or for the
+		/// error 'ex' if the replay failed.
+		/// </summary>
+		public static string FormatResult(ReplayResult result, Exception ex)
+		{
+			if (ex != null)
+				return ResultPrefix + "error\t" + ex.Message.Replace('\n', ' ');
+
+			return ResultPrefix + "ok\t" + (result.Signature ?? "") + "\t" +
+				(result.Coverage.HasValue ? result.Coverage.Value.ToString() : "");
+		}
+
+		static ReplayResult ParseResult(string line)
+		{
+			var parts = line.Split('\t');
+			if (parts[0] != "ok")
+				throw new PeachException("Error, replay worker failed: " + (parts.Length > 1 ? parts[1] : line));
+
+			var result = new ReplayResult();
+
+			// Only the bucket crosses the process, which is all Minimizer compares
+			if (parts[1].Length > 0)
+			{
+				var fault = new Fault();
+				fault.type = FaultType.Fault;
+				fault.folderName = parts[1];
+				result.Faults = new Fault[] { fault };
+			}
+
+			if (parts[2].Length > 0)
+				result.Coverage = int.Parse(parts[2]);
+
+			return result;
+		}
+
+		public void Dispose()
+		{
+			if (_process == null)
+				return;
+
+			try
+			{
+				_process.StandardInput.Close();
+
+				if (!_process.WaitForExit(10000))
+					_process.Kill();
+			}
+			catch (InvalidOperationException)
+			{
+				// Already exited
+			}
+			catch (IOException)
+			{
+				// Pipe closed by a worker that exited
+			}
+
+			_process.Dispose();
+			_process = null;
+		}
+	}
+
+	/// <summary>
+	/// Strategy used by EngineReplayer to send the data of a ReplayCase.
+	/// </summary>
+	/// <remarks>
+	/// Data actions are numbered in the order they run, starting at 1,
+	/// which matches the numbering of the action files saved by FileLogger.
+	/// </remarks>
+	class ReplayStrategy : MutationStrategy
+	{
+		ReplayCase _case;
+		uint _iteration = 0;
+		int _index = 0;
+
+		public ReplayStrategy(ReplayCase replayCase)
+			: base(new Dictionary<string, Variant>())
+		{
+			_case = replayCase;
+		}
+
+		public override void Initialize(RunContext context, Engine engine)
+		{
+			base.Initialize(context, engine);
+
+			Dom.Action.Starting += new ActionStartingEventHandler(Action_Starting);
+		}
+
+		public override void Finalize(RunContext context, Engine engine)
+		{
+			base.Finalize(context, engine);
+
+			Dom.Action.Starting -= Action_Starting;
+		}
+
+		static bool IsDataAction(Dom.Action action)
+		{
+			switch (action.type)
+			{
+				case ActionType.Input:
+				case ActionType.Output:
+				case ActionType.Call:
+				case ActionType.GetProperty:
+				case ActionType.SetProperty:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		bool IsOurs(Dom.Action action)
+		{
+			// Action.Starting is static, skip actions of any other engine
+			return _context != null && action.parent != null && action.parent.parent == _context.test.stateModel;
+		}
+
+		public override bool SkipAction(Dom.Action action)
+		{
+			if (!IsDataAction(action))
+				return false;
+
+			++_index;
+			return _case.Skipped.Contains(_index);
+		}
+
+		void Action_Starting(Dom.Action action)
+		{
+			if (action.type != ActionType.Output || !IsOurs(action))
+				return;
+
+			DataModel dataModel;
+			if (_case.Data.TryGetValue(_index, out dataModel) || _case.Models.TryGetValue(action.dataModel.name, out dataModel))
+				action.dataModel = dataModel.Clone() as DataModel;
+		}
+
+		public override bool IsDeterministic
+		{
+			get { return true; }
+		}
+
+		public override uint Count
+		{
+			get { return 1; }
+		}
+
+		public override uint Iteration
+		{
+			get { return _iteration; }
+			set
+			{
+				_iteration = value;
+				_index = 0;
+			}
+		}
+	}
+}
+
+// end
@@ -0,0 +1,320 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Runtime.Serialization.Formatters.Binary;
+
+using Peach.Core;
+using Peach.Core.Dom;
+
+using NLog;
+
+namespace Peach.Core.Analysis
+{
+	/// <summary>
+	/// Minset for PeachStar seed pools.
+	/// </summary>
+	/// <remarks>
+	/// Instead of tracing an executable under Pin, every seed in the pool
+	/// is replayed through the pit against the instrumented target and the
+	/// classified coverage map of the replay is collected from
+	/// libpeachControl.  Each bucket bit of the map is a feature, the same
+	/// tuples afl-cmin works with.  Seeds are then picked greedily, each
+	/// time taking the seed that adds the most features not yet covered,
+	/// until every feature seen is covered.
+	/// </remarks>
+	public class SeedMinset : Minset
+	{
+		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
+
+		/// <summary>
+		/// Seed queue saved next to the seeds, see SHARE.readSeedPoolFromFile.
+		/// </summary>
+		public const string IndexFile = "seedPoolIndex.bin";
+
+		/// <summary>
+		/// Number of distinct features seen by the last RunSeedCoverage().
+		/// </summary>
+		public int Features { get; private set; }
+
+		/// <summary>
+		/// Seed indexes of a seed pool, from its SeedStore or its seed files.
+		/// </summary>
+		public static int[] SeedIds(string seedPool)
+		{
+			if (!SeedStore.Exists(seedPool))
+				return SeedFiles(seedPool).Keys.ToArray();
+
+			using (var store = new SeedStore(seedPool, true))
+				return store.Ids.OrderBy(i => i).ToArray();
+		}
+
+		/// <summary>
+		/// Seed files of a seed pool written before SeedStore, by seed index.
+		/// </summary>
+		public static SortedDictionary<int, string> SeedFiles(string seedPool)
+		{
+			var ret = new SortedDictionary<int, string>();
+
+			foreach (var file in Directory.GetFiles(seedPool, "*.bin"))
+			{
+				int index;
+				if (int.TryParse(Path.GetFileNameWithoutExtension(file), out index))
+					ret.Add(index, file);
+			}
+
+			return ret;
+		}
+
+		public static DataModel LoadSeed(string fileName)
+		{
+			using (var fs = new FileStream(fileName, FileMode.Open, FileAccess.Read))
+			{
+				return (DataModel)new BinaryFormatter().Deserialize(fs);
+			}
+		}
+
+		public static void SaveTrace(string fileName, uint[] features)
+		{
+			using (var writer = new BinaryWriter(File.Create(fileName)))
+			{
+				writer.Write(features.Length);
+				foreach (var f in features)
+					writer.Write(f);
+			}
+		}
+
+		public static uint[] LoadTrace(string fileName)
+		{
+			using (var reader = new BinaryReader(File.OpenRead(fileName)))
+			{
+				var ret = new uint[reader.ReadInt32()];
+				for (int i = 0; i < ret.Length; ++i)
+					ret[i] = reader.ReadUInt32();
+				return ret;
+			}
+		}
+
+		/// <summary>
+		/// Replay each seed and write its features to
+		/// 'tracesFolder'/&lt;seed index&gt;.trace.
+		/// </summary>
+		/// <remarks>
+		/// Seeds whose replay fails are reported and get no trace, so they
+		/// are left out of the reduced pool.
+		/// </remarks>
+		/// <returns>Returns a collection of trace files</returns>
+		public string[] RunSeedTraces(EngineReplayer replayer, string tracesFolder, string seedPool, IList<int> seeds)
+		{
+			if (!Directory.Exists(tracesFolder))
+				Directory.CreateDirectory(tracesFolder);
+
+			replayer.CollectTrace = true;
+
+			var traces = new List<string>();
+			var store = SeedStore.Exists(seedPool) ? new SeedStore(seedPool, true) : null;
+
+			try
+			{
+				RunSeedTraces(replayer, tracesFolder, seedPool, store, seeds, traces);
+			}
+			finally
+			{
+				if (store != null)
+					store.Dispose();
+			}
+
+			return traces.ToArray();
+		}
+
+		void RunSeedTraces(EngineReplayer replayer, string tracesFolder, string seedPool, SeedStore store, IList<int> seeds, List<string> traces)
+		{
+			int count = 0;
+
+			foreach (var index in seeds)
+			{
+				string fileName = Path.Combine(seedPool, index.ToString());
+
+				count++;
+				OnTraceStarting(fileName, count, seeds.Count);
+
+				try
+				{
+					var seed = store != null ? store.Read(index) : LoadSeed(fileName + ".bin");
+					var result = replayer.Replay(ReplayCase.FromSeed(seed));
+					var traceFile = Path.Combine(tracesFolder, index.ToString() + ".trace");
+
+					SaveTrace(traceFile, result.Trace);
+					traces.Add(traceFile);
+				}
+				catch (PeachException ex)
+				{
+					logger.Warn("Unable to replay seed '{0}': {1}", fileName, ex.Message);
+				}
+
+				OnTraceCompleted(fileName, count, seeds.Count);
+			}
+		}
+
+		/// <summary>
+		/// Pick the seeds to keep from the features of each seed.
+		/// </summary>
+		/// <param name="traces">Features of each seed, by seed index</param>
+		/// <returns>Returns the seed indexes to keep, in pool order.</returns>
+		public int[] RunSeedCoverage(IDictionary<int, uint[]> traces)
+		{
+			// Number the features that occur so every trace becomes a
+			// dense bitset over the features seen in this pool
+			var ids = new Dictionary<uint, int>();
+			foreach (var trace in traces.Values)
+			{
+				foreach (var f in trace)
+				{
+					if (!ids.ContainsKey(f))
+						ids.Add(f, ids.Count);
+				}
+			}
+
+			Features = ids.Count;
+
+			int words = (ids.Count + 63) / 64;
+			var sets = new Dictionary<int, ulong[]>();
+			var bound = new Dictionary<int, int>();
+
+			foreach (var kv in traces)
+			{
+				var bits = new ulong[words];
+				foreach (var f in kv.Value)
+				{
+					int id = ids[f];
+					bits[id >> 6] |= 1UL << (id & 63);
+				}
+
+				sets.Add(kv.Key, bits);
+				bound.Add(kv.Key, Uncovered(bits, new ulong[words]));
+			}
+
+			var covered = new ulong[words];
+			var remaining = new List<int>(traces.Keys.OrderBy(k => k));
+			var ret = new List<int>();
+
+			while (remaining.Count > 0)
+			{
+				// The gain of a seed only drops as coverage grows, so the
+				// last gain computed is an upper bound.  Visit the seeds by
+				// bound and stop once no bound can beat the best gain.
+				remaining = remaining.OrderByDescending(k => bound[k]).ThenBy(k => k).ToList();
+
+				int best = -1;
+				int bestGain = 0;
+
+				foreach (var key in remaining)
+				{
+					if (bound[key] <= bestGain)
+						break;
+
+					int gain = Uncovered(sets[key], covered);
+					bound[key] = gain;
+
+					if (gain > bestGain)
+					{
+						best = key;
+						bestGain = gain;
+					}
+				}
+
+				if (best == -1)
+					break;
+
+				var bits = sets[best];
+				for (int i = 0; i < words; ++i)
+					covered[i] |= bits[i];
+
+				ret.Add(best);
+				remaining.Remove(best);
+			}
+
+			ret.Sort();
+			return ret.ToArray();
+		}
+
+		static int Uncovered(ulong[] bits, ulong[] covered)
+		{
+			int ret = 0;
+			for (int i = 0; i < bits.Length; ++i)
+				ret += PopCount(bits[i] & ~covered[i]);
+			return ret;
+		}
+
+		static int PopCount(ulong x)
+		{
+			x = x - ((x >> 1) & 0x5555555555555555UL);
+			x = (x & 0x3333333333333333UL) + ((x >> 2) & 0x3333333333333333UL);
+			x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fUL;
+			return (int)((x * 0x0101010101010101UL) >> 56);
+		}
+
+		/// <summary>
+		/// Copy the seeds to keep into 'outPath' along with a seed queue, so
+		/// the reduced pool can be loaded with -seedpool.
+		/// </summary>
+		public static void SaveSeedPool(string seedPool, IEnumerable<int> seeds, string outPath)
+		{
+			if (!Directory.Exists(outPath))
+				Directory.CreateDirectory(outPath);
+
+			var queue = new Queue<int>(seeds);
+
+			if (SeedStore.Exists(seedPool))
+			{
+				// Only the kept records are copied, the reduced store is compact
+				using (var store = new SeedStore(seedPool, true))
+					store.CopyTo(outPath, queue);
+			}
+			else
+			{
+				foreach (var index in queue)
+				{
+					string name = index.ToString() + ".bin";
+					File.Copy(Path.Combine(seedPool, name), Path.Combine(outPath, name), true);
+				}
+			}
+
+			using (var fs = new FileStream(Path.Combine(outPath, IndexFile), FileMode.Create))
+			{
+				new BinaryFormatter().Serialize(fs, queue);
+			}
+		}
+	}
+}
+
+// end
@@ -59,6 +59,13 @@ namespace Peach.Core.Analyzers
 
 		static readonly string PEACH_NAMESPACE_URI = "http://peachfuzzer.com/2012/Peach";
 
+		/// <summary>
+		/// Compiled peach.xsd, shared by every parser (includes are parsed
+		/// by their own PitParser instance).
+		/// </summary>
+		static XmlSchemaSet schemaSet = null;
+		static readonly object schemaLock = new object();
+
 		Dom.Dom _dom = null;
 		bool isScriptingLanguageSet = false;
 
@@ -169,12 +176,17 @@ namespace Peach.Core.Analyzers
 		public virtual Dom.Dom asParser(Dictionary<string, object> args, Stream data, bool doValidatePit)
 		{
 			string xml = readWithDefines(args, data);
+			XmlDocument xmldoc = null;
 
+			// Reuse the document validatePit already loaded when possible
 			if (doValidatePit)
-				validatePit(xml);
+				xmldoc = validatePit(xml);
 
-			XmlDocument xmldoc = new XmlDocument();
-			xmldoc.LoadXml(xml);
+			if (xmldoc == null)
+			{
+				xmldoc = new XmlDocument();
+				xmldoc.LoadXml(xml);
+			}
 
 			_dom = new Dom.Dom();
 
@@ -227,21 +239,35 @@ namespace Peach.Core.Analyzers
 			}
 		}
 
+		static XmlSchemaSet getSchemaSet()
+		{
+			lock (schemaLock)
+			{
+				if (schemaSet == null)
+				{
+					var set = new XmlSchemaSet();
+					var xsd = Assembly.GetExecutingAssembly().GetManifestResourceStream("Peach.Core.peach.xsd");
+					using (var tr = XmlReader.Create(xsd))
+					{
+						set.Add(null, tr);
+					}
+
+					set.Compile();
+					schemaSet = set;
+				}
+
+				return schemaSet;
+			}
+		}
+
 		/// <summary>
 		/// Validate PIT XML using Schema file.
 		/// </summary>
 		/// <param name="xmlData">Pit file to validate</param>
-		private void validatePit(string xmlData)
+		/// <returns>The loaded document if it is unmodified and can be parsed as is, otherwise null.</returns>
+		private XmlDocument validatePit(string xmlData)
 		{
-			XmlSchemaSet set = new XmlSchemaSet();
-			var xsd = Assembly.GetExecutingAssembly().GetManifestResourceStream("Peach.Core.peach.xsd");
-			using (var tr = XmlReader.Create(xsd))
-			{
-				set.Add(null, tr);
-			}
-
 			var doc = new XmlDocument();
-			doc.Schemas = set;
 			// Mono has issues reading utf-32 BOM when just calling doc.Load(data)
 
 			try
@@ -257,7 +283,9 @@ namespace Peach.Core.Analyzers
 			// Still load the doc to verify well formed xml
 			Type t = Type.GetType("Mono.Runtime");
 			if (t != null)
-				return;
+				return doc;
+
+			doc.Schemas = getSchemaSet();
 
 			foreach (XmlNode root in doc.ChildNodes)
 			{
@@ -285,6 +313,8 @@ namespace Peach.Core.Analyzers
 
 			if (!string.IsNullOrEmpty(errors))
 				throw new PeachException("Error, Pit file failed to validate: " + errors);
+
+			return null;
 		}
 
 		/// <summary>
@@ -1713,13 +1743,16 @@ namespace Peach.Core.Analyzers
 			if (node.hasAttr("faultWaitTime"))
 				test.faultWaitTime = decimal.Parse(node.getAttrString("faultWaitTime"));
 
+			if (node.hasAttr("adaptiveWaitTime"))
+				test.adaptiveWaitTime = node.getAttrBool("adaptiveWaitTime");
+
 			if (node.hasAttr("controlIteration"))
 				test.controlIterationEvery = int.Parse(node.getAttrString("controlIteration"));
 
 			if (node.hasAttr("replayEnabled")){
 
 				test.replayEnabled = node.getAttrBool("replayEnabled");
-				Console.WriteLine("feilong:runTest set {0}",test.replayEnabled);
+				logger.Debug("feilong:runTest set {0}", test.replayEnabled);
 			}
 				
 
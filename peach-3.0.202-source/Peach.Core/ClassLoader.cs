@@ -44,6 +44,10 @@ namespace Peach.Core
 	{
 		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
 		public static Dictionary<string, Assembly> AssemblyCache = new Dictionary<string, Assembly>();
+		static Dictionary<Type, KeyValuePair<Attribute, Type>[]> attributeCache = new Dictionary<Type, KeyValuePair<Attribute, Type>[]>();
+		static int attributeCacheAssemblies = -1;
+		static Dictionary<Assembly, Dictionary<string, List<string>>> typeIndex = new Dictionary<Assembly, Dictionary<string, List<string>>>();
+		static string typeIndexFolder = Path.Combine(Path.GetTempPath(), "peach-types");
 		static string[] searchPath = GetSearchPath();
 
 		static string[] GetSearchPath()
@@ -197,21 +201,221 @@ namespace Peach.Core
 		public static IEnumerable<KeyValuePair<A, Type>> GetAllByAttribute<A>(Func<Type, A, bool> predicate)
 			where A : Attribute
 		{
-			foreach (var asm in ClassLoader.AssemblyCache.Values)
+			foreach (var kv in GetAttributeTable(typeof(A)))
 			{
-				if (asm.IsDynamic)
-					continue;
+				var attr = (A)kv.Key;
+
+				if (predicate == null || predicate(kv.Value, attr))
+					yield return new KeyValuePair<A, Type>(attr, kv.Value);
+			}
+		}
+
+		/// <summary>
+		/// Folder holding the on disk index of attributed types, one file per
+		/// assembly named after its module version id.  Set to null to keep
+		/// the index in memory only.
+		/// </summary>
+		public static string TypeIndexFolder
+		{
+			get { return typeIndexFolder; }
+			set
+			{
+				lock (attributeCache)
+				{
+					typeIndexFolder = value;
+					typeIndex.Clear();
+					attributeCache.Clear();
+				}
+			}
+		}
+
+		/// <summary>
+		/// Every exported class decorated with an attribute of type 'attrType',
+		/// in assembly load order.  Built the first time an attribute type is
+		/// queried and rebuilt whenever a new assembly is loaded, so the pit
+		/// parser does not reflect over every type for each element, fixup
+		/// and transformer it resolves.
+		/// </summary>
+		static KeyValuePair<Attribute, Type>[] GetAttributeTable(Type attrType)
+		{
+			lock (attributeCache)
+			{
+				if (attributeCacheAssemblies != AssemblyCache.Count)
+				{
+					attributeCache.Clear();
+					attributeCacheAssemblies = AssemblyCache.Count;
+				}
+
+				KeyValuePair<Attribute, Type>[] ret;
+				if (attributeCache.TryGetValue(attrType, out ret))
+					return ret;
+
+				var list = new List<KeyValuePair<Attribute, Type>>();
+
+				foreach (var asm in ClassLoader.AssemblyCache.Values)
+				{
+					if (asm.IsDynamic)
+						continue;
+
+					List<string> names;
+					if (!GetTypeIndex(asm).TryGetValue(attrType.FullName, out names))
+						continue;
+
+					foreach (var name in names)
+					{
+						// A stale index can name a type that is gone
+						var type = asm.GetType(name);
+						if (type == null || !type.IsClass || !type.IsVisible)
+							continue;
+
+						foreach (var attr in type.GetCustomAttributes(true))
+						{
+							if (attrType.IsInstanceOfType(attr))
+								list.Add(new KeyValuePair<Attribute, Type>((Attribute)attr, type));
+						}
+					}
+				}
+
+				ret = list.ToArray();
+				attributeCache.Add(attrType, ret);
+				return ret;
+			}
+		}
+
+		/// <summary>
+		/// Names of the exported classes of 'asm' by the attribute types they
+		/// carry, including the base types of each attribute.  Saved in
+		/// TypeIndexFolder so later runs skip reflecting over every type of an
+		/// assembly that has not been rebuilt.
+		/// </summary>
+		static Dictionary<string, List<string>> GetTypeIndex(Assembly asm)
+		{
+			Dictionary<string, List<string>> ret;
+			if (typeIndex.TryGetValue(asm, out ret))
+				return ret;
+
+			string file = null;
+			if (typeIndexFolder != null)
+				file = Path.Combine(typeIndexFolder, asm.ManifestModule.ModuleVersionId.ToString("N") + ".types");
+
+			if (file != null)
+				ret = ReadTypeIndex(file);
+
+			if (ret == null)
+			{
+				ret = new Dictionary<string, List<string>>();
 
 				foreach (var type in asm.GetExportedTypes())
 				{
 					if (!type.IsClass)
 						continue;
 
-					foreach (var x in type.GetAttributes<A>(predicate))
+					foreach (var attr in type.GetCustomAttributes(true))
 					{
-						yield return new KeyValuePair<A, Type>(x, type);
+						for (var t = attr.GetType(); t != null && t != typeof(Attribute); t = t.BaseType)
+						{
+							List<string> names;
+							if (!ret.TryGetValue(t.FullName, out names))
+							{
+								names = new List<string>();
+								ret.Add(t.FullName, names);
+							}
+
+							if (names.Count == 0 || names[names.Count - 1] != type.FullName)
+								names.Add(type.FullName);
+						}
 					}
 				}
+
+				if (file != null)
+					WriteTypeIndex(file, ret);
+			}
+
+			typeIndex.Add(asm, ret);
+			return ret;
+		}
+
+		const string TypeIndexHeader = "PeachTypeIndex 1";
+
+		static Dictionary<string, List<string>> ReadTypeIndex(string file)
+		{
+			if (!File.Exists(file))
+				return null;
+
+			try
+			{
+				var lines = File.ReadAllLines(file);
+				if (lines.Length == 0 || lines[0] != TypeIndexHeader)
+					return null;
+
+				var ret = new Dictionary<string, List<string>>();
+
+				for (int i = 1; i < lines.Length; ++i)
+				{
+					var parts = lines[i].Split('\t');
+					if (parts.Length < 2)
+						return null;
+
+					ret[parts[0]] = parts.Skip(1).ToList();
+				}
+
+				return ret;
+			}
+			catch (IOException ex)
+			{
+				logger.Debug("ClassLoader unable to read type index \"{0}\", {1}", file, ex.Message);
+			}
+			catch (UnauthorizedAccessException ex)
+			{
+				logger.Debug("ClassLoader unable to read type index \"{0}\", {1}", file, ex.Message);
+			}
+
+			return null;
+		}
+
+		static void WriteTypeIndex(string file, Dictionary<string, List<string>> index)
+		{
+			var lines = new List<string>();
+			lines.Add(TypeIndexHeader);
+
+			foreach (var kv in index)
+				lines.Add(kv.Key + "\t" + string.Join("\t", kv.Value.ToArray()));
+
+			// Write aside and move, another instance may be reading the index
+			string tmp = file + "." + Path.GetRandomFileName();
+
+			try
+			{
+				Directory.CreateDirectory(Path.GetDirectoryName(file));
+				File.WriteAllLines(tmp, lines.ToArray());
+
+				// Only written when the index is missing or unreadable
+				if (File.Exists(file))
+					File.Delete(file);
+
+				File.Move(tmp, file);
+			}
+			catch (IOException ex)
+			{
+				logger.Debug("ClassLoader unable to save type index \"{0}\", {1}", file, ex.Message);
+			}
+			catch (UnauthorizedAccessException ex)
+			{
+				logger.Debug("ClassLoader unable to save type index \"{0}\", {1}", file, ex.Message);
+			}
+			finally
+			{
+				try
+				{
+					if (File.Exists(tmp))
+						File.Delete(tmp);
+				}
+				catch (IOException)
+				{
+				}
+				catch (UnauthorizedAccessException)
+				{
+				}
 			}
 		}
 
@@ -101,6 +101,29 @@ namespace Peach.Core.Cracker
 		/// </summary>
 		List<DataElement> _elementsWithAnalyzer;
 
+		/// <summary>
+		/// Tokens at a fixed offset from the start of each element passed
+		/// to CanCrack().  An empty list means nothing is known.
+		/// </summary>
+		Dictionary<DataElement, List<Lookahead>> _leadingTokens = new Dictionary<DataElement, List<Lookahead>>();
+
+		bool _tokenLookahead = true;
+
+		#endregion
+
+		#region Public Properties
+
+		/// <summary>
+		/// Rule out Choice options and Array items by their leading tokens
+		/// before cracking them.  The result of a crack is the same either
+		/// way, turning it off only makes every candidate crack.
+		/// </summary>
+		public bool TokenLookahead
+		{
+			get { return _tokenLookahead; }
+			set { _tokenLookahead = value; }
+		}
+
 		#endregion
 
 		#region Events
@@ -194,6 +217,70 @@ namespace Peach.Core.Cracker
 			return _sizedElements.ContainsKey(rel.From);
 		}
 
+		/// <summary>
+		/// Quick check if an element can crack at the current position of
+		/// data without running the cracker.  Used by Choice and Array to
+		/// rule out options before trying them.
+		/// </summary>
+		/// <remarks>
+		/// Only tokens at a fixed offset from the start of the element are
+		/// compared, so returning true does not mean cracking will succeed.
+		/// The position of data is not changed.
+		/// </remarks>
+		/// <param name="element">Element that is about to be cracked</param>
+		/// <param name="data">Data stream positioned where element would start</param>
+		/// <returns>False if the element can not crack, true otherwise.</returns>
+		public bool CanCrack(DataElement element, BitStream data)
+		{
+			if (!_tokenLookahead)
+				return true;
+
+			List<Lookahead> tokens;
+			if (!_leadingTokens.TryGetValue(element, out tokens))
+			{
+				long pos = 0;
+				tokens = new List<Lookahead>();
+				findLeadingTokens(element, ref pos, tokens);
+				_leadingTokens.Add(element, tokens);
+			}
+
+			if (tokens.Count == 0)
+				return true;
+
+			long start = data.TellBits();
+
+			try
+			{
+				foreach (var token in tokens)
+				{
+					long at = start + token.Position;
+
+					// Not buffered yet, let the cracker decide
+					if (at + token.Value.Length * 8 > data.LengthBits)
+						break;
+
+					data.SeekBits(at, System.IO.SeekOrigin.Begin);
+					var bytes = data.ReadBytes(token.Value.Length);
+
+					for (int i = 0; i < bytes.Length; ++i)
+					{
+						if (bytes[i] != token.Value[i])
+						{
+							logger.Debug("CanCrack: {0} token {1} does not match at {2}",
+								element.debugName, token.Element.debugName, at);
+							return false;
+						}
+					}
+				}
+			}
+			finally
+			{
+				data.SeekBits(start, System.IO.SeekOrigin.Begin);
+			}
+
+			return true;
+		}
+
 		/// <summary>
 		/// Perform optimizations of data model for cracking
 		/// </summary>
@@ -260,6 +347,7 @@ namespace Peach.Core.Cracker
 			_sizedElements = new OrderedDictionary<DataElement, Position>();
 			_sizeRelations = new List<SizeRelation>();
 			_elementsWithAnalyzer = new List<DataElement>();
+			_leadingTokens = new Dictionary<DataElement, List<Lookahead>>();
 
 			// Crack the model
 			handleNode(element, data);
@@ -739,6 +827,71 @@ namespace Peach.Core.Cracker
 			public bool Optional { get; set; }
 		}
 
+		class Lookahead
+		{
+			public DataElement Element { get; set; }
+			public long Position { get; set; }
+			public byte[] Value { get; set; }
+		}
+
+		/// <summary>
+		/// Walk elem in order collecting byte sized Number and Blob tokens
+		/// while every element before them has a fixed size.
+		/// </summary>
+		/// <returns>True if elem has a fixed size and scanning can continue.</returns>
+		bool findLeadingTokens(DataElement elem, ref long pos, List<Lookahead> tokens)
+		{
+			if (elem.transformer != null || elem.placement != null || elem.relations.Count > 0 || elem is Padding)
+				return false;
+
+			var cont = elem as DataElementContainer;
+			if (cont != null)
+			{
+				if (elem.isToken || !(cont is Block) || cont is Dom.Array)
+					return false;
+
+				foreach (var child in cont)
+				{
+					if (!findLeadingTokens(child, ref pos, tokens))
+						return false;
+				}
+
+				// The block length can differ from the sum of its children
+				return !cont.hasLength;
+			}
+
+			if (!elem.hasLength)
+				return false;
+
+			long len = elem.lengthAsBits;
+
+			if (elem.isToken && elem.fixup == null && len % 8 == 0 && (elem is Number || elem is Blob))
+			{
+				var value = tokenValue(elem);
+				if (value.Length * 8 == len)
+					tokens.Add(new Lookahead() { Element = elem, Position = pos, Value = value });
+			}
+
+			pos += len;
+			return true;
+		}
+
+		static byte[] tokenValue(DataElement elem)
+		{
+			// Keep Value from substituting seed data
+			var oldIn = Peach.Core.Runtime.SHARE.if_in;
+			Peach.Core.Runtime.SHARE.if_in = true;
+
+			try
+			{
+				return elem.Value.Value;
+			}
+			finally
+			{
+				Peach.Core.Runtime.SHARE.if_in = oldIn;
+			}
+		}
+
 		enum Until { FirstSized, FirstUnsized };
 
 		/// <summary>
@@ -93,6 +93,25 @@ namespace Peach.Core.Dom
 		[DllImport(@"peachControl", EntryPoint="count_branch")]   
         public static unsafe extern int count_branch();   
 
+		[DllImport(@"peachControl", EntryPoint="count_edges")]
+		public static extern int count_edges();
+
+		/// <summary>
+		/// MAP_SIZE of control.c
+		/// </summary>
+		public const int MapSize = 1 << 21;
+
+		/// <summary>
+		/// Milliseconds to sleep after an output before polling the coverage
+		/// map, when no WaitTimeCalibrator is used.
+		/// </summary>
+		public static int OutputSettleTime = 100;
+
+		/// <summary>
+		/// Milliseconds between two polls of the coverage map.
+		/// </summary>
+		public static int TargetPollInterval = 10;
+
 		[DllImport(@"peachControl", EntryPoint="hash_after_classify")]   
         public static unsafe extern int hash_after_classify(); 
 
@@ -472,6 +491,14 @@ namespace Peach.Core.Dom
 				}
 			}
 
+			if (context.test.strategy != null && context.test.strategy.SkipAction(this))
+			{
+				logger.Debug("Run: action '{0}' skipped by mutation strategy", name);
+				return;
+			}
+
+			bool batched = false;
+
 			try
 			{
 				Publisher publisher = null;
@@ -505,7 +532,10 @@ namespace Peach.Core.Dom
 				finished = false;
 				error = false;
 
+				// The strategy mutates the data model from the Starting event
+				long mutate = Profiler.Begin(ProfilePhase.Mutate);
 				OnStarting();
+				Profiler.End(ProfilePhase.Mutate, mutate);
 
 				//从发现第一条路径起开始算	
 				if(Peach.Core.Runtime.SHARE.cur_path == 0){
@@ -560,6 +590,9 @@ unsafe{
 						publisher.start();
 						publisher.open();
 						handleOutput(publisher);
+						batched = isBatchedOutput(publisher);
+						if (publisher.IsBatching && !batched)
+							publisher.flush();
 						parent.parent.dataActions.Add(this);
 						break;
 
@@ -605,29 +638,50 @@ unsafe{
 			{ 
 unsafe{
 				//只有当action是output才执行内存相关动作
-				if(type == ActionType.Output){
-					Thread.Sleep(100);
-					//判断待测程序是否执行完
-					Console.WriteLine("Checking whether the program has completed its tasks ......");
-					// int cur_cksum = hash_after_classify();
-					// int last_cksum = cur_cksum + 1;
-					int cnt = 0;
-					termination_detection_init();
-					while(termination_detection() != 0)
+				//批量发送时只在flush之后等待目标
+				long feedback = Profiler.Begin(ProfilePhase.Feedback);
+				if(type == ActionType.Output && !batched){
+					if (context.waitTimeCalibrator != null)
 					{
-						Thread.Sleep(10);
-						// last_cksum = cur_cksum;
-						// cur_cksum = hash_after_classify();
-						cnt++;
-						Console.WriteLine("Checking iteration {0} ...", cnt);
+						long poll = Profiler.Begin(ProfilePhase.Poll);
+						waitForTarget(context);
+						Profiler.End(ProfilePhase.Poll, poll);
+					}
+					else
+					{
+						long settle = Profiler.Begin(ProfilePhase.Settle);
+						Thread.Sleep(OutputSettleTime);
+						Profiler.End(ProfilePhase.Settle, settle);
+						//判断待测程序是否执行完
+						logger.Trace("Checking whether the program has completed its tasks ......");
+						// int cur_cksum = hash_after_classify();
+						// int last_cksum = cur_cksum + 1;
+						int cnt = 0;
+						long poll = Profiler.Begin(ProfilePhase.Poll);
+						termination_detection_init();
+						while(termination_detection() != 0)
+						{
+							Thread.Sleep(TargetPollInterval);
+							// last_cksum = cur_cksum;
+							// cur_cksum = hash_after_classify();
+							cnt++;
+							if (logger.IsTraceEnabled)
+								logger.Trace("Checking iteration {0} ...", cnt);
+						}
+						Profiler.End(ProfilePhase.Poll, poll);
+						if (logger.IsTraceEnabled)
+							logger.Trace("Program has finished its tasks after {0} times of check......", cnt + 1);
 					}
-					Console.WriteLine("Program has finished its tasks after {0} times of check......", cnt + 1);
 
+					long coverage = Profiler.Begin(ProfilePhase.NewPath);
 					int hnb = newPath();
+					Profiler.End(ProfilePhase.NewPath, coverage);
+					if (InfluenceMap.Tracing)
+						InfluenceMap.AddTrace();
 					if(hnb != 0)
 					{
 						//update path_info
-						Console.WriteLine("feilong:LLVM find new path.");
+						logger.Trace("feilong:LLVM find new path.");
 						Peach.Core.Runtime.SHARE.has_new_path = true;
 						Peach.Core.Runtime.SHARE.cur_path++; 
 						if(hnb == 2)
@@ -638,6 +692,7 @@ unsafe{
 						string time = GetTimeStamp();
 						string info =  Convert.ToString(Peach.Core.Runtime.SHARE.cur_path);
 						// string[] names = new string[] {time, info};
+						long log = Profiler.Begin(ProfilePhase.Log);
 						string sPath = Peach.Core.Runtime.SHARE.pathSrc; 
 						if (!File.Exists(sPath))  
 						{ 
@@ -654,18 +709,22 @@ unsafe{
 						var newLine = string.Format("{0},{1}", time, info);
 						csv.AppendLine(newLine);   
 						File.AppendAllText(sPath, csv.ToString()); 
+						Profiler.End(ProfilePhase.Log, log);
 					}
 					else{
-						Console.WriteLine("feilong:LLVM find no new path.");
+						logger.Trace("feilong:LLVM find no new path.");
 						Peach.Core.Runtime.SHARE.has_new_path = false;
 					}
 					//update branch_info
+					coverage = Profiler.Begin(ProfilePhase.NewPath);
 					int branch = count_branch();
+					Profiler.End(ProfilePhase.NewPath, coverage);
 					if (branch > Peach.Core.Engine.total_branch)
 					{
-						Console.WriteLine("New Branch hit!");
+						logger.Trace("New Branch hit!");
 						Peach.Core.Engine.total_branch = branch;
 						//  string bPath = Peach.Core.Runtime.SHARE.pathSrc; 
+						long log = Profiler.Begin(ProfilePhase.Log);
 						string bPath = Peach.Core.Runtime.SHARE.pathSSrc; 	//"/tmp/peachBranch.csv";
 						if (!File.Exists(bPath))  
 						{ 
@@ -684,11 +743,13 @@ unsafe{
 						var newLine = string.Format("{0},{1}", time, info);
 						csv.AppendLine(newLine);   
 						File.AppendAllText(bPath, csv.ToString());
+						Profiler.End(ProfilePhase.Log, log);
 					}
 					else{
-						Console.WriteLine("Opps!! No New Branch found!");
+						logger.Trace("Opps!! No New Branch found!");
 					}
 				}
+				Profiler.End(ProfilePhase.Feedback, feedback);
 }
 				//只有当action是output才执行进队列的操作 并且需要当前非repo的叠加模式 
 				if(type == ActionType.Output && (!(Peach.Core.Runtime.SHARE.if_PeachStarRepo && (context.test.strategy.Iteration < Peach.Core.Runtime.SHARE.peachStarRepoStartIteration)))){
@@ -713,18 +774,23 @@ unsafe{
 						//进队列
 						Peach.Core.Runtime.SHARE.dataModelsToMutate.Enqueue(this.dataModel.Clone() as DataModel);
 						// Peach.Core.Runtime.SHARE.dataModelsToMutate.Enqueue(this.dataModel);
+						Peach.Core.Runtime.SHARE.dataModelsToMutateIndex.Enqueue(++Peach.Core.Runtime.SHARE.queueEntryIndex);
+
+						//重放记录只保存id, DataModel本身落盘
+						if(Peach.Core.Runtime.SHARE.replayJournal != null)
+							Peach.Core.Runtime.SHARE.saveQueueEntryToFile(this.dataModel.Clone() as DataModel, Peach.Core.Runtime.SHARE.queueEntryIndex, (Peach.Core.Loggers.FileLogger)context.test.loggers[0]);
 
 						//进种子池
 						if(Peach.Core.Runtime.SHARE.has_new_path_branch)
 						{
-							Peach.Core.Runtime.SHARE.valuableDataModels.Enqueue(this.dataModel.Clone() as DataModel);
 							Peach.Core.Runtime.SHARE.seedPoolIndexQueue.Enqueue(++Peach.Core.Runtime.SHARE.seedPoolIndex);
+							Peach.Core.Runtime.SHARE.valuableDataModels.Enqueue(Peach.Core.Runtime.SHARE.seedPoolIndex, this.dataModel);
 
 							Peach.Core.Runtime.SHARE.saveNewSeedToFile(this.dataModel.Clone() as DataModel,(Peach.Core.Loggers.FileLogger)context.test.loggers[0]);
 
 						}
 
-						Console.WriteLine("feilong: Find new path, add DataModel to queue. queue length before {0} queue length now {1} use time: {2}. average time {3} and the p is {4}  {5} ",
+						logger.Debug("feilong: Find new path, add DataModel to queue. queue length before {0} queue length now {1} use time: {2}. average time {3} and the p is {4}  {5} ",
 							Peach.Core.Runtime.SHARE.queueLengthBeforeIteration,Peach.Core.Runtime.SHARE.dataModelsToMutate.Count,
 							time_bridge, Peach.Core.Runtime.SHARE.average_path_time, this.dataModel.p,
 							Peach.Core.Runtime.SHARE.if_replace_just_now == true? "by replace" : ""
@@ -737,6 +803,41 @@ unsafe{
 			}
 		}
 
+		/// <summary>
+		/// Poll the coverage map until the target stops reaching new edges and
+		/// at least the calibrated wait for this action has elapsed.  The time
+		/// of the last observed change is fed back into the calibrator.
+		/// </summary>
+		/// <remarks>
+		/// Control iterations always use the calibrator's default wait so the
+		/// samples they record are not biased by an earlier estimate.
+		/// </remarks>
+		protected void waitForTarget(RunContext context)
+		{
+			var calibrator = context.waitTimeCalibrator;
+			string key = parent.name + "." + name;
+			int wait = context.controlIteration ? calibrator.DefaultWait : calibrator.GetWait(key);
+			long lastChange = 0;
+
+			var sw = System.Diagnostics.Stopwatch.StartNew();
+			termination_detection_init();
+
+			while (true)
+			{
+				Thread.Sleep(TargetPollInterval);
+
+				if (termination_detection() != 0)
+					lastChange = sw.ElapsedMilliseconds;
+				else if (sw.ElapsedMilliseconds >= wait)
+					break;
+			}
+
+			calibrator.Record(key, (int)lastChange);
+
+			logger.Debug("waitForTarget: '{0}' quiet after {1}ms, waited {2}ms, next wait {3}ms",
+				key, lastChange, sw.ElapsedMilliseconds, calibrator.GetWait(key));
+		}
+
 		protected void handleInput(Publisher publisher)
 		{
 			try
@@ -750,22 +851,70 @@ unsafe{
 			}
 		}
 
+		/// <summary>
+		/// A batching publisher only sends at the end of a run of
+		/// consecutive Output actions to it, so every output but the
+		/// last one in the run is left queued.
+		/// </summary>
+		protected bool isBatchedOutput(Publisher publisher)
+		{
+			if (!publisher.IsBatching)
+				return false;
+
+			int idx = parent.actions.IndexOf(this);
+			if (idx < 0 || idx + 1 >= parent.actions.Count)
+				return false;
+
+			Action next = parent.actions[idx + 1];
+			return next.type == ActionType.Output && next.publisher == this.publisher && next.when == null;
+		}
+
 		protected void handleOutput(Publisher publisher)
 		{
-			Stream strm = dataModel.Value.Stream;
+			long render = Profiler.Begin(ProfilePhase.Render);
+			Stream strm = dataModel.Value.SharedStream;
+			Profiler.End(ProfilePhase.Render, render);
 			strm.Seek(0, SeekOrigin.Begin);
 
+			logger.Trace("feilong: Publisher output!!!");
+
+			// Send straight from the rendered buffer when we can get at it
 			MemoryStream ms = strm as MemoryStream;
-			if (ms == null)
+			byte[] buf = ms != null ? BufferPool.GetBuffer(ms) : null;
+			if (buf != null)
 			{
-				ms = new MemoryStream();
-				strm.CopyTo(ms);
-				ms.Seek(0, SeekOrigin.Begin);
-				strm.Seek(0, SeekOrigin.Begin);
+				long publish = Profiler.Begin(ProfilePhase.Publish);
+				publisher.output(buf, 0, (int)ms.Length);
+				Profiler.End(ProfilePhase.Publish, publish);
+				return;
 			}
 
-			Console.WriteLine("feilong: Publisher output!!!");
-			publisher.output(ms.GetBuffer(), (int)ms.Position, (int)ms.Length);
+			// Otherwise stage the data in a pooled buffer instead of
+			// allocating a new MemoryStream for every output.
+			int len = (int)strm.Length;
+			buf = BufferPool.Rent(len);
+
+			try
+			{
+				int offset = 0;
+				while (offset < len)
+				{
+					int read = strm.Read(buf, offset, len - offset);
+					if (read == 0)
+						break;
+					offset += read;
+				}
+
+				strm.Seek(0, SeekOrigin.Begin);
+
+				long publish = Profiler.Begin(ProfilePhase.Publish);
+				publisher.output(buf, 0, offset);
+				Profiler.End(ProfilePhase.Publish, publish);
+			}
+			finally
+			{
+				BufferPool.Return(buf);
+			}
 		}
 
 		protected void handleCall(Publisher publisher, RunContext context)
@@ -135,6 +135,13 @@ namespace Peach.Core.Dom
 					break;
 				}
 
+				// Stop without cracking when a leading token rules out another item
+				if (i >= min && !context.CanCrack(origionalElement, sizedData))
+				{
+					logger.Debug("Crack: {0} Token mismatch on #{1}", debugName, i+1);
+					break;
+				}
+
 				var clone = makeElement(i);
 				Add(clone);
 
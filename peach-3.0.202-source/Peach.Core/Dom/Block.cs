@@ -62,6 +62,8 @@ namespace Peach.Core.Dom
 	[Serializable]
 	public class Block : DataElementContainer
 	{
+		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
+
 		public Block()
 		{
 		}
@@ -114,15 +116,13 @@ namespace Peach.Core.Dom
 
 		protected override Variant GenerateInternalValue()
 		{
-			Console.WriteLine("feilong:Block Generate value!!!");
+			logger.Trace("feilong:Block Generate value!!!");
 			Variant value;
 
 			// 1. Default value
 			if (_mutatedValue == null)
 			{
-				BitStream stream = new BitStream();
-				foreach (DataElement child in this)
-					stream.Write(child.Value, child);
+				BitStream stream = RenderChildren();
 
 				// TODO - Remove this debugging code!
 				//if (stream.TellBytes() != stream.Value.Length)
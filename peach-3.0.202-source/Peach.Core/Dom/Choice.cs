@@ -88,6 +88,14 @@ namespace Peach.Core.Dom
 
 			foreach (DataElement child in choiceElements.Values)
 			{
+				sizedData.SeekBits(startPosition, System.IO.SeekOrigin.Begin);
+
+				if (!context.CanCrack(child, sizedData))
+				{
+					logger.Debug("handleChoice: Skipping child: " + child.debugName);
+					continue;
+				}
+
 				try
 				{
 					logger.Debug("handleChoice: Trying child: " + child.debugName);
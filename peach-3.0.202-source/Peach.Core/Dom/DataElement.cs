@@ -461,15 +461,16 @@ namespace Peach.Core.Dom
 
 			get
 			{
-				string fullname = name;
-				DataElement obj = _parent;
-				while (obj != null)
-				{
-					fullname = obj.name + "." + fullname;
-					obj = obj.parent;
-				}
+				if (_parent == null)
+					return name;
+
+				// Build in one pass instead of re-concatenating per level
+				var names = new List<string>();
+				for (DataElement obj = this; obj != null; obj = obj.parent)
+					names.Add(obj.name);
 
-				return fullname;
+				names.Reverse();
+				return string.Join(".", names);
 			}
 		}
 
@@ -749,7 +750,8 @@ namespace Peach.Core.Dom
 			{
 				
 				_mutatedValue = value;
-				Console.WriteLine("feilong:mutate value set!!! {0} {1} ",this.name,_mutatedValue);
+				if (logger.IsTraceEnabled)
+					logger.Trace("feilong:mutate value set!!! {0} {1} ", this.name, _mutatedValue);
 				Invalidate();
 			}
 		}
@@ -906,8 +908,7 @@ namespace Peach.Core.Dom
 		protected virtual Variant GenerateInternalValue()
 		{
 
-			
-			Console.WriteLine("feilong:DataElement generate value!!!");
+			logger.Trace("feilong:DataElement generate value!!!");
 			Variant value;
 
 			// 1. Default value
@@ -918,7 +919,8 @@ namespace Peach.Core.Dom
 
 			if (MutatedValue != null && (mutationFlags & MUTATE_OVERRIDE_TYPE_TRANSFORM) != 0)
 			{
-				Console.WriteLine("feilong:DataElement generate value!!! using mutated value 2!" + MutatedValue);
+				if (logger.IsTraceEnabled)
+					logger.Trace("feilong:DataElement generate value!!! using mutated value 2!" + MutatedValue);
 
 				return MutatedValue;
 			}
@@ -927,7 +929,8 @@ namespace Peach.Core.Dom
 
 			if (MutatedValue != null && (mutationFlags & MUTATE_OVERRIDE_RELATIONS) != 0)
 			{
-				Console.WriteLine("feilong:DataElement generate value!!! using mutated value 3 !" + MutatedValue);
+				if (logger.IsTraceEnabled)
+					logger.Trace("feilong:DataElement generate value!!! using mutated value 3 !" + MutatedValue);
 				return MutatedValue;
 			}
 
@@ -939,7 +942,9 @@ namespace Peach.Core.Dom
 					// when mutations mess up the relation.
 					// In that case use the exsiting value for this element.
 
+					long fixup = Profiler.Begin(ProfilePhase.Fixup);
 					var relationValue = r.CalculateFromValue();
+					Profiler.End(ProfilePhase.Fixup, fixup);
 					if (relationValue != null)
 						value = relationValue;
 				}
@@ -949,14 +954,20 @@ namespace Peach.Core.Dom
 
 			if (MutatedValue != null && (mutationFlags & MUTATE_OVERRIDE_FIXUP) != 0)
 			{
-				Console.WriteLine("feilong:DataElement generate value!!! using mutated value 4 !" + MutatedValue);
+				if (logger.IsTraceEnabled)
+					logger.Trace("feilong:DataElement generate value!!! using mutated value 4 !" + MutatedValue);
 				return MutatedValue;
 			}
 
 			if (_fixup != null)
+			{
+				long fixup = Profiler.Begin(ProfilePhase.Fixup);
 				value = _fixup.fixup(this);
+				Profiler.End(ProfilePhase.Fixup, fixup);
+			}
 
-			Console.WriteLine("feilong:DataElement value:" + value);
+			if (logger.IsTraceEnabled)
+				logger.Trace("feilong:DataElement value:" + value);
 			return value;
 		}
 
@@ -968,6 +979,17 @@ namespace Peach.Core.Dom
 			return (BitStream)ret;
 		}
 
+		/// <summary>
+		/// Value cached by the last call to Value, null if there is none.
+		/// This is what FeilongGetMutatedValue() splices from a queued model.
+		/// SeedStore sets it to restore a seed without regenerating it.
+		/// </summary>
+		internal BitStream CachedValue
+		{
+			get { return _value; }
+			set { _value = value; }
+		}
+
 		/// <summary>
 		/// How many times GenerateValue has been called on this element
 		/// </summary>
@@ -978,18 +1000,22 @@ namespace Peach.Core.Dom
 		protected BitStream FeilongGetMutatedValue(){
 			if((this.isMutable == true) && (!Peach.Core.Runtime.SHARE.if_in) && !(this is Block)) {
 								// this._mutatedValue = 1;
-				Queue<DataModel> dataModelsToMutate = null;
+				//feilong:get the first datamodel to mutate.
+				DataModel _dataModelToMutate = null;
 				if(Peach.Core.Runtime.SHARE.queueLengthBeforeIteration != 0)
-					dataModelsToMutate = Peach.Core.Runtime.SHARE.dataModelsToMutate;
+					_dataModelToMutate = Peach.Core.Runtime.SHARE.dataModelsToMutate.Peek();
 				if(Peach.Core.Runtime.SHARE.seed_pool_to_use_cnt != 0)
-					dataModelsToMutate = Peach.Core.Runtime.SHARE.valuableDataModels;
+					_dataModelToMutate = Peach.Core.Runtime.SHARE.valuableDataModels.Peek();
+
+				//按记录重放时使用记录里的DataModel
+				var replayRecord = Peach.Core.Runtime.SHARE.replayRecord;
+				if(replayRecord != null)
+					_dataModelToMutate = Peach.Core.Runtime.SHARE.replayHead == null ? null : Peach.Core.Runtime.SHARE.replayHead.Peek();
 				
-				if(dataModelsToMutate == null){
-					Console.WriteLine("feilong:Queue is empty,use own stratage!");
+				if(_dataModelToMutate == null){
+					logger.Trace("feilong:Queue is empty,use own stratage!");
 				}
 				else{
-					//feilong:get the first datamodel to mutate.
-					DataModel _dataModelToMutate = dataModelsToMutate.Peek();
 					//use the value of similar type of the _dataModelToMutate.
 
 					//添加概率
@@ -997,21 +1023,23 @@ namespace Peach.Core.Dom
 					{
 						_lastIteration = Peach.Core.Runtime.SHARE.CurIteration;
 						_lastSubIteration = Peach.Core.Runtime.SHARE.CurSubIteration;
-						ran = new Peach.Core.Random(_lastIteration * 7 + _lastSubIteration);
+						if(replayRecord != null)
+							ran = new Peach.Core.Random(replayRecord.Iteration * 7 + replayRecord.SubIteration);
+						else
+							ran = new Peach.Core.Random(_lastIteration * 7 + _lastSubIteration);
 					}
 
 					// DataElement dataElement = null;
 
 					foreach(DataElement dataElement in  _dataModelToMutate.EnumerateAllElements() ){
 
-						Console.WriteLine("feilong:see dataElement mutate value {0} internalValue {1} default value {2} name {3}",
-							dataElement._mutatedValue,
-							dataElement._internalValue,
-							dataElement._defaultValue,
-							dataElement.name
-						);
-						Console.WriteLine("\n");
-						Console.WriteLine("\n");
+						if (logger.IsTraceEnabled)
+							logger.Trace("feilong:see dataElement mutate value {0} internalValue {1} default value {2} name {3}",
+								dataElement._mutatedValue,
+								dataElement._internalValue,
+								dataElement._defaultValue,
+								dataElement.name
+							);
 
 
 						// if(dataElement._mutatedValue == null){
@@ -1055,7 +1083,8 @@ namespace Peach.Core.Dom
 							Peach.Core.Runtime.SHARE.if_in = true;
 							Peach.Core.Runtime.SHARE.if_in = false;
 							Peach.Core.Runtime.SHARE.if_replace_just_now = true;
-							Console.WriteLine("feilong:use Value from the queue {0} {1}",_sss,dataElement.fullName);
+							if (logger.IsTraceEnabled)
+								logger.Trace("feilong:use Value from the queue {0} {1}", _sss, dataElement.fullName);
 							
 							return _sss;
 						}
@@ -53,6 +53,9 @@ namespace Peach.Core.Dom
 		protected List<DataElement> _childrenList = new List<DataElement>();
 		protected Dictionary<string, DataElement> _childrenDict = new Dictionary<string, DataElement>();
 
+		// Size of the last copy made by RenderChildren()
+		private long _renderedBytes;
+
 		public DataElementContainer()
 		{
 		}
@@ -166,6 +169,37 @@ namespace Peach.Core.Dom
 			}
 		}
 
+		/// <summary>
+		/// Concatenate the values of all children.
+		/// </summary>
+		/// <remarks>
+		/// Children that have not been invalidated return the same cached
+		/// BitStream every time.  The result shares those streams through a
+		/// ConcatStream, so only the children that changed were rendered
+		/// again and nothing is copied.
+		/// </remarks>
+		protected BitStream RenderChildren()
+		{
+			var values = new BitStream[_childrenList.Count];
+			for (int i = 0; i < values.Length; ++i)
+				values[i] = _childrenList[i].Value;
+
+			var ret = BitStream.Concat(values, _childrenList);
+			if (ret != null)
+				return ret;
+
+			// A child ends part way through a byte, write everything out.
+			// Size the stream like the last copy, it grows once at most.
+			ret = new BitStream(new System.IO.MemoryStream((int)_renderedBytes));
+
+			for (int i = 0; i < values.Length; ++i)
+				ret.Write(values[i], _childrenList[i]);
+
+			_renderedBytes = ret.LengthBytes;
+
+			return ret;
+		}
+
 		/// <summary>
 		/// Recursively execute analyzers
 		/// </summary>
@@ -133,6 +133,13 @@ namespace Peach.Core.Dom
 				foreach (Action action in actions)
 					action.Run(context);
 
+				// Send what a skipped output left queued before the next state
+				foreach (Publisher publisher in context.test.publishers.Values)
+				{
+					if (publisher.IsBatching)
+						publisher.flush();
+				}
+
 				finished = true;
 			}
 			catch
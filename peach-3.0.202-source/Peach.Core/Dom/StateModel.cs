@@ -106,8 +106,8 @@ namespace Peach.Core.Dom
 		}
 
 		//feilong:调用control.o
-		[DllImport(@"peachControl", EntryPoint="feilong_update")]   
-        public static unsafe extern int feilong_update(int iteration);
+		[DllImport(@"peachControl", EntryPoint="ckpt_update")]
+		public static extern int ckpt_update(int iteration);
 
 		/// <summary>
 		/// Start running the State Machine
@@ -296,26 +296,27 @@ namespace Peach.Core.Dom
 			}
 			finally
 			{
-				//当前非repo的叠加模式 
-				if(!(Peach.Core.Runtime.SHARE.if_PeachStarRepo && (context.test.strategy.Iteration < Peach.Core.Runtime.SHARE.peachStarRepoStartIteration))){
+				//当前非repo的叠加模式, 不拼接种子的iteration(if_in, 见AdaptiveStrategy)不消耗队列
+				if(!(Peach.Core.Runtime.SHARE.if_PeachStarRepo && (context.test.strategy.Iteration < Peach.Core.Runtime.SHARE.peachStarRepoStartIteration)) && !Peach.Core.Runtime.SHARE.if_in){
 					
 					//iteration stop, dequeue;
 					if(Peach.Core.Runtime.SHARE.queueLengthBeforeIteration != 0){
-						Console.WriteLine("feilong: Iteration finish! Dequeue!");
+						logger.Trace("feilong: Iteration finish! Dequeue!");
 
 						
 						if(Peach.Core.Runtime.SHARE.has_new_path_iteration)
 						{
 							DataModel _dataModel = Peach.Core.Runtime.SHARE.dataModelsToMutate.Peek();
 							_dataModel.use_time = 0;
-							Peach.Core.Runtime.SHARE.valuableDataModels.Enqueue(_dataModel.Clone() as DataModel);
 							//更新Index列表
 							Peach.Core.Runtime.SHARE.seedPoolIndexQueue.Enqueue(++Peach.Core.Runtime.SHARE.seedPoolIndex);
+							Peach.Core.Runtime.SHARE.valuableDataModels.Enqueue(Peach.Core.Runtime.SHARE.seedPoolIndex, _dataModel);
 							//保存种子到本地
 							Peach.Core.Runtime.SHARE.saveNewSeedToFile(_dataModel.Clone() as DataModel,(Peach.Core.Loggers.FileLogger)context.test.loggers[0]);
 						}
 								
 						Peach.Core.Runtime.SHARE.dataModelsToMutate.Dequeue();
+						Peach.Core.Runtime.SHARE.dataModelsToMutateIndex.Dequeue();
 						Peach.Core.Runtime.SHARE.queueLengthBeforeIteration--;
 					}
 					else if (Peach.Core.Runtime.SHARE.seed_pool_to_use_cnt != 0)
@@ -332,26 +333,28 @@ namespace Peach.Core.Dom
 						if(_dataModel.use_time < Peach.Core.Runtime.SHARE.use_time_limit)
 						{
 							Peach.Core.Runtime.SHARE.seedPoolIndexQueue.Enqueue(seedIndex);
-							Peach.Core.Runtime.SHARE.valuableDataModels.Enqueue(_dataModel.Clone() as DataModel);
+							Peach.Core.Runtime.SHARE.valuableDataModels.Enqueue(seedIndex, _dataModel);
+						}
+						else if(Peach.Core.Runtime.SHARE.seedStore != null)
+						{
+							//种子用完, 在存储中标记退出
+							Peach.Core.Runtime.SHARE.seedStore.Retire(seedIndex);
 						}
 						Peach.Core.Runtime.SHARE.seed_pool_to_use_cnt--;
 					}
 					else{
-						Console.WriteLine("feilong: Iteration finish! No Dequeue!");
+						logger.Trace("feilong: Iteration finish! No Dequeue!");
 					}
 
 					//feilong:iteration stop，更新最近一次队列为空的virgin_bit和iteration信息   在大轮执行结束之后  并且要此时dataModelsToMutate队列为空
 					if(Peach.Core.Runtime.SHARE.queueLengthBeforeIteration == 0 && Peach.Core.Runtime.SHARE.seed_pool_to_use_cnt == 0 && Peach.Core.Runtime.SHARE.dataModelsToMutate.Count==0){
 						//todo：调用control.c
-						Console.WriteLine("feilong:feilong_update start");
-						unsafe{
-							if(0 != feilong_update((int)context.test.strategy.Iteration + 1)){
-								Console.WriteLine("feilong:feilong_update run error!");
-							}
+						//追加一代checkpoint, 只写入变化的virgin_bits
+						if(0 != ckpt_update((int)context.test.strategy.Iteration + 1)){
+							logger.Debug("ckpt_update failed, no run checkpoint is open.");
 						}
 						//还要更新seedIndexQueueCopy,为seedIndexQueue的快照
 						Peach.Core.Runtime.SHARE.seedPoolIndexQueueCopy = new Queue<int>(Peach.Core.Runtime.SHARE.seedPoolIndexQueue);
-						Console.WriteLine("feilong:feilong_update finish");
 					}
 					
 					//change queue length
@@ -375,28 +378,36 @@ namespace Peach.Core.Dom
 
 
 						// add peachWather
+						long log = Profiler.Begin(ProfilePhase.Log);
 						string sPath = Peach.Core.Runtime.SHARE.pathWather;
 						if (!File.Exists(sPath))  
 						{ 
 							FileStream fs = new FileStream(sPath, FileMode.Create, FileAccess.Write); 
 							StreamWriter sw = new StreamWriter(fs); 
 							StringBuilder sb = new StringBuilder(); 
-							sb.Append("Iteration").Append(",").Append("From last iteration").Append(",").Append("From seed pool").Append(",").Append("Seed pool size"); 
+							sb.Append("Iteration").Append(",").Append("From last iteration").Append(",").Append("From seed pool").Append(",").Append("Seed pool size")
+								.Append(",").Append("Seeds in memory").Append(",").Append("Seed reload rate"); 
 							sw.WriteLine(sb); 
 							sw.Flush();
 							sw.Close();
 							fs.Close();
 						} 
 						var csv = new StringBuilder(); 
-						var newLine = string.Format("{0},{1},{2},{3}", Peach.Core.Runtime.SHARE.CurIteration , Peach.Core.Runtime.SHARE.queueLengthBeforeIteration,
-																Peach.Core.Runtime.SHARE.seed_pool_to_use_cnt, Peach.Core.Runtime.SHARE.valuableDataModels.Count);
+						var newLine = string.Format("{0},{1},{2},{3},{4},{5:0.000}", Peach.Core.Runtime.SHARE.CurIteration , Peach.Core.Runtime.SHARE.queueLengthBeforeIteration,
+																Peach.Core.Runtime.SHARE.seed_pool_to_use_cnt, Peach.Core.Runtime.SHARE.valuableDataModels.Count,
+																Peach.Core.Runtime.SHARE.valuableDataModels.Resident, Peach.Core.Runtime.SHARE.valuableDataModels.ReloadRate);
 						csv.AppendLine(newLine);   
 						File.AppendAllText(sPath, csv.ToString()); 
-						Console.WriteLine("Add {0} sub iterations...", Peach.Core.Runtime.SHARE.queueLengthBeforeIteration);
+						Profiler.End(ProfilePhase.Log, log);
+						logger.Debug("Add {0} sub iterations...", Peach.Core.Runtime.SHARE.queueLengthBeforeIteration);
 					}
 
 					Peach.Core.Runtime.SHARE.has_new_path_iteration = false;
 				}
+				else if(Peach.Core.Runtime.SHARE.if_in){
+					//这次找到的新路径不记到队列头的种子上
+					Peach.Core.Runtime.SHARE.has_new_path_iteration = false;
+				}
 
 				
 				
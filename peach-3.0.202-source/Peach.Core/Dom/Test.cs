@@ -100,6 +100,7 @@ namespace Peach.Core.Dom
 			replayEnabled = true;
 			waitTime = 0;
 			faultWaitTime = 2;
+			adaptiveWaitTime = false;
 		}
 
 		#region OrderedDictionary AddEvent Handlers
@@ -138,6 +139,17 @@ namespace Peach.Core.Dom
 		/// </remarks>
 		public decimal faultWaitTime { get; set; }
 
+		/// <summary>
+		/// Derive the wait after each output action from the latency measured
+		/// during control iterations instead of using a fixed delay.  Defaults
+		/// to false.
+		/// </summary>
+		/// <remarks>
+		/// When enabled, waitTime is also capped at the largest calibrated
+		/// action wait once every action has been calibrated.
+		/// </remarks>
+		public bool adaptiveWaitTime { get; set; }
+
 		public void markMutableElements()
 		{
 			Dom dom;
@@ -284,13 +284,14 @@ inital the code coverage
 		{
 			try
 			{
-				Console.WriteLine("feilong:Test run!");
+				logger.Debug("feilong:Test run!");
 				context.test = test;
 				context.test.strategy.Context = context;
 				context.test.strategy.Engine = this;
 				context.agentManager = new AgentManager(context);
 				context.reproducingFault = false;
 				context.reproducingIterationJumpCount = 1;
+				context.waitTimeCalibrator = test.adaptiveWaitTime ? new WaitTimeCalibrator() : null;
 
 				// Get mutation strategy
 				MutationStrategy mutationStrategy = test.strategy;
@@ -355,7 +356,7 @@ inital the code coverage
 
 				while ((firstRun || iterationCount <= iterationStop) && context.continueFuzzing)
 				{
-					Console.WriteLine("feilong:Iteration Start!!!");
+					logger.Trace("feilong:Iteration Start!!!");
 					firstRun = false;
 
 					// Clear out or iteration based state store
@@ -370,8 +371,12 @@ inital the code coverage
 
 					try
 					{
+						Profiler.BeginIteration();
+
 						// Must set iteration 1st as strategy could enable control/record bools
+						long mutate = Profiler.Begin(ProfilePhase.Mutate);
 						mutationStrategy.Iteration = iterationCount;
+						Profiler.End(ProfilePhase.Mutate, mutate);
 
 						if (context.controlIteration && context.controlRecordingIteration)
 						{
@@ -523,8 +528,12 @@ to execute same as initial control.  State " + state.name + "was not performed."
 
 						// User can specify a time to wait between iterations
 						// we can use that time to better detect faults
-						if (context.test.waitTime > 0)
-							Thread.Sleep((int)(context.test.waitTime * 1000));
+						decimal waitTime = context.test.waitTime;
+						if (context.waitTimeCalibrator != null && !context.controlIteration && !context.reproducingFault)
+							waitTime = context.waitTimeCalibrator.Clamp(waitTime);
+
+						if (waitTime > 0)
+							Thread.Sleep((int)(waitTime * 1000));
 
 						if (context.reproducingFault)
 						{
@@ -581,7 +590,7 @@ to execute same as initial control.  State " + state.name + "was not performed."
 							}
 							else if (test.replayEnabled)
 							{
-								Console.WriteLine("feilong:runTest: replay enabled:{0}",test.replayEnabled);
+								logger.Debug("feilong:runTest: replay enabled:{0}", test.replayEnabled);
 								logger.Debug("runTest: Attempting to reproduce fault.");
 
 								context.reproducingFault = true;
@@ -68,14 +68,10 @@ namespace Peach.Core.Fixups
 
 			byte[] data1 = ref1.Value.Value;
 			byte[] data2 = ref2.Value.Value;
-			byte[] data3 = new byte[data1.Length + data2.Length];
-			Buffer.BlockCopy(data1, 0, data3, 0, data1.Length);
-			Buffer.BlockCopy(data2, 0, data3, data1.Length, data2.Length);
 
-			CRCTool crcTool = new CRCTool();
-			crcTool.Init(type);
+			CRCTool crcTool = CRCTool.Get(type);
 
-			return new Variant((uint)crcTool.crctablefast(data3));
+			return new Variant((uint)crcTool.crctablefast(data1, data2));
 		}
 	}
 }
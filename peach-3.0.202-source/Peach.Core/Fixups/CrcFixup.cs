@@ -66,9 +66,8 @@ namespace Peach.Core.Fixups
 			var elem = elements["ref"];
 			byte[] data = elem.Value.Value;
 
-			CRCTool crcTool = new CRCTool();
-			crcTool.Init(type);
-		
+			CRCTool crcTool = CRCTool.Get(type);
+
 			return new Variant((uint)crcTool.crctablefast(data));
 		}
 	}
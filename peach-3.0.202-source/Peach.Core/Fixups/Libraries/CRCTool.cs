@@ -1,5 +1,6 @@
 ﻿using System;
 using System.Collections;
+using System.Collections.Generic;
 using System.Text;
 using System.IO;
 using System.Security.Cryptography;
@@ -48,6 +49,9 @@ namespace Peach.Core.Fixups.Libraries
 		private ulong crcinit_direct;
 		private ulong crcinit_nondirect;
 		private ulong[] crctab = new ulong[256];
+		private ulong[][] slicetab;
+
+		private static readonly Dictionary<CRCCode, CRCTool> shared = new Dictionary<CRCCode, CRCTool>();
 
 		// Enumeration used in the init function to specify which CRC algorithm to use
 		public enum CRCCode { CRC_CCITT, CRC16, CRC32 };
@@ -59,6 +63,26 @@ namespace Peach.Core.Fixups.Libraries
 			//
 		}
 
+		/// <summary>
+		/// Get an initialized CRCTool for CodingType.  The tables are only
+		/// built once per type, the returned instance is shared and must
+		/// not be re-initialized.
+		/// </summary>
+		public static CRCTool Get(CRCCode CodingType)
+		{
+			lock (shared)
+			{
+				CRCTool ret;
+				if (!shared.TryGetValue(CodingType, out ret))
+				{
+					ret = new CRCTool();
+					ret.Init(CodingType);
+					shared.Add(CodingType, ret);
+				}
+				return ret;
+			}
+		}
+
 		public void Init(CRCCode CodingType)
 		{
 			switch (CodingType)
@@ -130,34 +154,7 @@ namespace Peach.Core.Fixups.Libraries
         /// </summary>.
         public ulong crctablefast(byte[] p)
         {
-            // fast lookup table algorithm without augmented zero bytes, e.g. used in pkzip.
-            // only usable with polynom orders of 8, 16, 24 or 32.
-            ulong crc = crcinit_direct;
-            if (refin != 0)
-            {
-                crc = reflect(crc, order);
-            }
-            if (refin == 0)
-            {
-                for (int i = 0; i < p.Length; i++)
-                {
-                    crc = (crc << 8) ^ crctab[((crc >> (order - 8)) & 0xff) ^ p[i]];
-                }
-            }
-            else
-            {
-                for (int i = 0; i < p.Length; i++)
-                {
-                    crc = (crc >> 8) ^ crctab[(crc & 0xff) ^ p[i]];
-                }
-            }
-            if ((refout ^ refin) != 0)
-            {
-                crc = reflect(crc, order);
-            }
-            crc ^= crcxor;
-            crc &= crcmask;
-            return (crc);
+            return crctablefast(p, crcinit_direct);
         }
         /// <summary>
         /// 4 ways to calculate the crc checksum. If you have to do a lot of encoding
@@ -173,29 +170,27 @@ namespace Peach.Core.Fixups.Libraries
             {
                 crc = reflect(crc, order);
             }
-            if (refin == 0)
-            {
-                for (int i = 0; i < p.Length; i++)
-                {
-                    crc = (crc << 8) ^ crctab[((crc >> (order - 8)) & 0xff) ^ p[i]];
-                }
-            }
-            else
-            {
-                for (int i = 0; i < p.Length; i++)
-                {
-                    crc = (crc >> 8) ^ crctab[(crc & 0xff) ^ p[i]];
-                }
-            }
-            if ((refout ^ refin) != 0)
-            {
-                crc = reflect(crc, order);
-            }
-            crc ^= crcxor;
-            crc &= crcmask;
-            return (crc);
+            crc = update(crc, p, 0, p.Length);
+            return finish(crc);
         }
 
+		/// <summary>
+		/// Same as crctablefast(byte[]) over the concatenation of all parts.
+		/// </summary>
+		public ulong crctablefast(params byte[][] parts)
+		{
+			ulong crc = crcinit_direct;
+			if (refin != 0)
+			{
+				crc = reflect(crc, order);
+			}
+			foreach (byte[] p in parts)
+			{
+				crc = update(crc, p, 0, p.Length);
+			}
+			return finish(crc);
+		}
+
 		public ulong crctable(byte[] p)
 		{
 			// normal lookup table algorithm with augmented zero bytes.
@@ -360,6 +355,57 @@ namespace Peach.Core.Fixups.Libraries
 
 
 		#region subroutines
+		private ulong update(ulong crc, byte[] p, int offset, int count)
+		{
+			// table loop of crctablefast, 8 bytes per step using slicetab.
+			// non-reflected values are kept at the top of 32 bits.
+			ulong[] t0 = slicetab[0], t1 = slicetab[1], t2 = slicetab[2], t3 = slicetab[3];
+			ulong[] t4 = slicetab[4], t5 = slicetab[5], t6 = slicetab[6], t7 = slicetab[7];
+			int i = offset;
+			int end = offset + count;
+
+			if (refin != 0)
+			{
+				crc &= crcmask;
+				for (; end - i >= 8; i += 8)
+				{
+					ulong one = crc ^ ((uint)p[i] | (uint)p[i + 1] << 8 | (uint)p[i + 2] << 16 | (uint)p[i + 3] << 24);
+					crc = t7[one & 0xff] ^ t6[(one >> 8) & 0xff] ^ t5[(one >> 16) & 0xff] ^ t4[one >> 24] ^
+						t3[p[i + 4]] ^ t2[p[i + 5]] ^ t1[p[i + 6]] ^ t0[p[i + 7]];
+				}
+				for (; i < end; i++)
+				{
+					crc = (crc >> 8) ^ t0[(crc ^ p[i]) & 0xff];
+				}
+				return crc;
+			}
+
+			int shift = 32 - order;
+			ulong c = (crc << shift) & 0xffffffff;
+			for (; end - i >= 8; i += 8)
+			{
+				ulong one = c ^ ((uint)p[i] << 24 | (uint)p[i + 1] << 16 | (uint)p[i + 2] << 8 | (uint)p[i + 3]);
+				c = t7[one >> 24] ^ t6[(one >> 16) & 0xff] ^ t5[(one >> 8) & 0xff] ^ t4[one & 0xff] ^
+					t3[p[i + 4]] ^ t2[p[i + 5]] ^ t1[p[i + 6]] ^ t0[p[i + 7]];
+			}
+			for (; i < end; i++)
+			{
+				c = ((c << 8) & 0xffffffff) ^ t0[(c >> 24) ^ p[i]];
+			}
+			return c >> shift;
+		}
+
+		private ulong finish(ulong crc)
+		{
+			if ((refout ^ refin) != 0)
+			{
+				crc = reflect(crc, order);
+			}
+			crc ^= crcxor;
+			crc &= crcmask;
+			return (crc);
+		}
+
 		private ulong reflect(ulong crc, int bitnum)
 		{
 
@@ -409,6 +455,27 @@ namespace Peach.Core.Fixups.Libraries
 				crc &= crcmask;
 				crctab[i] = crc;
 			}
+
+			// slice-by-8 tables, slicetab[k] advances a byte followed by k zero bytes.
+			int shift = refin != 0 ? 0 : 32 - order;
+			slicetab = new ulong[8][];
+			slicetab[0] = new ulong[256];
+			for (i = 0; i < 256; i++)
+			{
+				slicetab[0][i] = (crctab[i] << shift) & 0xffffffff;
+			}
+			for (j = 1; j < 8; j++)
+			{
+				slicetab[j] = new ulong[256];
+				for (i = 0; i < 256; i++)
+				{
+					crc = slicetab[j - 1][i];
+					if (refin != 0)
+						slicetab[j][i] = (crc >> 8) ^ slicetab[0][crc & 0xff];
+					else
+						slicetab[j][i] = ((crc << 8) & 0xffffffff) ^ slicetab[0][crc >> 24];
+				}
+			}
 		}
 		#endregion
 	}
@@ -123,7 +123,7 @@ namespace Peach.Core.IO
 			if (isDisposed)
 				throw new ObjectDisposedException("BitStream already disposed");
 
-			if (!(stream is MemoryStream))
+			if (!(stream is MemoryStream) && !(stream is ConcatStream))
 				throw new ApplicationException("Error, unable to reset when stream is not a MemoryStream.");
 
 			stream = new MemoryStream();
@@ -163,9 +163,22 @@ namespace Peach.Core.IO
 
 			if (stream is MemoryStream)
 			{
+				// Keep the copy expandable so it can be written to and
+				// its buffer can be handed out without another copy.
+				var src = (MemoryStream)stream;
+				var buf = BufferPool.GetBuffer(src) ?? src.ToArray();
+				var dst = new MemoryStream((int)src.Length);
+				dst.Write(buf, 0, (int)src.Length);
+
 				Dictionary<string, long[]> copyOfElementPositions = new Dictionary<string, long[]>(_elementPositions);
-				return new BitStream(new MemoryStream(((MemoryStream)stream).ToArray()), pos, len, bitConverter,
-					copyOfElementPositions);
+				return new BitStream(dst, pos, len, bitConverter, copyOfElementPositions);
+			}
+
+			if (stream is ConcatStream)
+			{
+				// The parts are never written to, so they can be shared
+				var dst = ((ConcatStream)stream).Clone();
+				return new BitStream(dst, pos, len, bitConverter, new Dictionary<string, long[]>(_elementPositions));
 			}
 
 			throw new ApplicationException("Error, unable to clone stream.");
@@ -429,10 +442,13 @@ namespace Peach.Core.IO
 			if (e == null)
 				throw new ApplicationException("DataElement 'e' is null");
 
-			if (HasDataElement(e.fullName))
-				_elementPositions[e.fullName][0] = pos;
+			string name = e.fullName;
+			long[] vals;
+
+			if (_elementPositions.TryGetValue(name, out vals))
+				vals[0] = pos;
 			else
-				_elementPositions.Add(e.fullName, new long[] { pos, lengthInBits });
+				_elementPositions.Add(name, new long[] { pos, lengthInBits });
 		}
 
 		/// <summary>
@@ -441,13 +457,7 @@ namespace Peach.Core.IO
 		/// <param name="e">DataElement to mark the position of</param>
 		public void MarkStartOfElement(DataElement e)
 		{
-			if (e == null)
-				throw new ApplicationException("DataElement 'e' is null");
-
-			if (HasDataElement(e.fullName))
-				_elementPositions[e.fullName][0] = pos;
-			else
-				_elementPositions.Add(e.fullName, new long[] { pos, 0 });
+			MarkStartOfElement(e, 0);
 		}
 
 		/// <summary>
@@ -461,11 +471,14 @@ namespace Peach.Core.IO
 			if (e == null)
 				throw new ApplicationException("DataElement 'e' is null");
 
-			if(!HasDataElement(e.fullName))
+			string name = e.fullName;
+			long[] vals;
+
+			if (!_elementPositions.TryGetValue(name, out vals))
 				throw new ApplicationException(
-					string.Format("Element position list does not contain DataElement {0}.", e.fullName));
+					string.Format("Element position list does not contain DataElement {0}.", name));
 
-			_elementPositions[e.fullName][1] = pos;
+			vals[1] = pos;
 		}
 
 		#endregion
@@ -655,14 +668,80 @@ namespace Peach.Core.IO
 			Write(bits);
 		}
 
+		/// <summary>
+		/// Lay 'values' end to end without copying their data.  Element
+		/// positions are recorded as Write(values[i], elements[i]) would.
+		/// Returns null if a value does not end on a byte boundary.
+		/// </summary>
+		public static BitStream Concat(IList<BitStream> values, IList<DataElement> elements)
+		{
+			var parts = new Stream[values.Count];
+			var lengths = new long[values.Count];
+
+			for (int i = 0; i < parts.Length; ++i)
+			{
+				if (values[i].LengthBits % 8 != 0)
+					return null;
+
+				parts[i] = values[i].stream;
+				lengths[i] = values[i].LengthBytes;
+			}
+
+			var ret = new BitStream(new ConcatStream(parts, lengths));
+
+			for (int i = 0; i < parts.Length; ++i)
+			{
+				foreach (var elem in values[i]._elementPositions)
+					ret._elementPositions.Add(elem.Key, new long[] { elem.Value[0] + ret.pos, elem.Value[1] });
+
+				ret.MarkStartOfElement(elements[i], values[i].LengthBits);
+				ret.pos += values[i].LengthBits;
+			}
+
+			ret.stream.Position = ret.pos / 8;
+
+			return ret;
+		}
+
 #endif
 
 		#endregion
 
 		public static void CopyTo(Stream sin, Stream sout)
 		{
-			int len = (int)Math.Min(sin.Length, 1024*1024);
-			sin.CopyTo(sout, len);
+			// Write straight from the backing array of a MemoryStream,
+			// otherwise go through a pooled scratch buffer.
+			var cs = sin as ConcatStream;
+			if (cs != null)
+			{
+				cs.WriteTo(sout);
+				return;
+			}
+
+			var ms = sin as MemoryStream;
+			var src = ms != null ? BufferPool.GetBuffer(ms) : null;
+
+			if (src != null)
+			{
+				long pos = ms.Position;
+				if (pos < ms.Length)
+					sout.Write(src, (int)pos, (int)(ms.Length - pos));
+				ms.Position = ms.Length;
+				return;
+			}
+
+			var buf = BufferPool.Rent((int)Math.Min(sin.Length, 1024*1024));
+
+			try
+			{
+				int read;
+				while ((read = sin.Read(buf, 0, buf.Length)) != 0)
+					sout.Write(buf, 0, read);
+			}
+			finally
+			{
+				BufferPool.Return(buf);
+			}
 		}
 
 		/// <summary>
@@ -725,14 +804,11 @@ namespace Peach.Core.IO
 #if PEACH
 			// Copy over DataElement positions, replace
 			// existing entries if they exist.
-			foreach (string key in bits._elementPositions.Keys)
+			foreach (var item in bits._elementPositions)
 			{
-				if (!HasDataElement(key))
-					_elementPositions.Add(key, bits._elementPositions[key]);
-				else
-					_elementPositions[key] = bits._elementPositions[key];
-
-				_elementPositions[key][0] += origionalPos;
+				// Don't adjust the source entry in place, 'bits' is
+				// usually the cached value of another element.
+				_elementPositions[item.Key] = new long[] { item.Value[0] + origionalPos, item.Value[1] };
 			}
 #endif
 		}
@@ -800,6 +876,21 @@ namespace Peach.Core.IO
 			if(bits == 0 || bits > 64)
 				throw new ApplicationException("bits is invalid value, but be > 0 and < 64");
 
+			// Whole bytes on a byte boundary, skip the read/modify/write per bit
+			if (pos % 8 == 0 && bits % 8 == 0 && stream.CanSeek)
+			{
+				stream.Position = pos / 8;
+
+				for (int shift = bits - 8; shift >= 0; shift -= 8)
+					stream.WriteByte((byte)(value >> shift));
+
+				pos += bits;
+				if (pos > len)
+					len = pos;
+
+				return;
+			}
+
 			for (int cnt = 0; cnt < (int)bits; cnt++ )
 			{
 				WriteBit( (byte) ((value >> ((bits-1) - cnt)) & 1) );
@@ -840,13 +931,35 @@ namespace Peach.Core.IO
 
 		public void WriteBytes(byte[] value)
 		{
-			foreach (byte b in value)
-				WriteBits(b, 8);
+			WriteBytes(value, 0, value.Length);
 		}
 
+		/// <summary>
+		/// Write value[offset] up to (but not including) value[length].
+		/// </summary>
 		public void WriteBytes(byte[] value, int offset, int length)
 		{
-			for (int i = offset; i < length && i < value.Length; i++)
+			int end = Math.Min(length, value.Length);
+			if (offset >= end)
+				return;
+
+			if (isDisposed)
+				throw new ObjectDisposedException("BitStream already disposed");
+
+			// Byte aligned, copy the whole block
+			if (pos % 8 == 0 && stream.CanSeek)
+			{
+				stream.Position = pos / 8;
+				stream.Write(value, offset, end - offset);
+
+				pos += 8L * (end - offset);
+				if (pos > len)
+					len = pos;
+
+				return;
+			}
+
+			for (int i = offset; i < end; i++)
 				WriteBits(value[i], 8);
 		}
 
@@ -951,6 +1064,17 @@ namespace Peach.Core.IO
 
 			ulong ret = 0;
 
+			if (pos % 8 == 0 && bits % 8 == 0 && stream.CanSeek)
+			{
+				stream.Position = pos / 8;
+
+				for (int cnt = 0; cnt < bits; cnt += 8)
+					ret = (ret << 8) | (byte)stream.ReadByte();
+
+				pos += bits;
+				return ret;
+			}
+
 			for (int cnt = 0; cnt < bits; cnt++)
 			{
 				ret |= ((ulong)ReadBit() << (int)((bits - 1) - cnt));
@@ -1129,6 +1253,24 @@ namespace Peach.Core.IO
 
 			byte[] ret = new byte[count];
 
+			// Byte aligned, read the whole block
+			if (pos % 8 == 0 && stream.CanSeek)
+			{
+				stream.Position = pos / 8;
+
+				int offset = 0;
+				while (offset < count)
+				{
+					int read = stream.Read(ret, offset, (int)count - offset);
+					if (read == 0)
+						throw new ApplicationException("Count overruns buffer");
+					offset += read;
+				}
+
+				pos += count * 8;
+				return ret;
+			}
+
 			for (int i = 0; i < count; i++)
 			{
 				ret[i] = ReadByte();
@@ -1157,6 +1299,8 @@ namespace Peach.Core.IO
 			if (sizeInBits > len)
 				throw new ApplicationException("sizeInbits larger then length of data");
 
+			Flatten();
+
 			if (!(stream is MemoryStream))
 				throw new ApplicationException("Error, unable to truncate stream that is not a MemoryStream.");
 
@@ -1200,6 +1344,8 @@ namespace Peach.Core.IO
 			if (isDisposed)
 				throw new ObjectDisposedException("BitStream already disposed");
 
+			Flatten();
+
 			if (!(stream is MemoryStream))
 				throw new ApplicationException("Error, unable to insert into non-MemoryStream");
 
@@ -1343,11 +1489,49 @@ namespace Peach.Core.IO
 			return -1;
 		}
 
+		/// <summary>
+		/// The backing stream.  Data that references the values of other
+		/// BitStreams (see Concat()) is first copied into a MemoryStream
+		/// owned by this BitStream.
+		/// </summary>
 		public Stream Stream
+		{
+			get
+			{
+				Flatten();
+				return stream;
+			}
+		}
+
+		/// <summary>
+		/// True if the data references the values of other BitStreams
+		/// instead of holding a copy.
+		/// </summary>
+		public bool IsShared
+		{
+			get { return stream is ConcatStream; }
+		}
+
+		/// <summary>
+		/// The backing stream without copying shared data, for callers that
+		/// only read it.
+		/// </summary>
+		internal Stream SharedStream
 		{
 			get { return stream; }
 		}
 
+		void Flatten()
+		{
+			var cs = stream as ConcatStream;
+			if (cs == null)
+				return;
+
+			var ms = cs.ToMemoryStream();
+			ms.Position = cs.Position;
+			stream = ms;
+		}
+
 		public void WantBytes(long bytes)
 		{
 			if (bytes <= 0)
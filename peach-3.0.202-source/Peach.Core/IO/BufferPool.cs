@@ -0,0 +1,136 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+
+namespace Peach.Core.IO
+{
+	/// <summary>
+	/// Process wide pool of reusable byte arrays.
+	/// </summary>
+	/// <remarks>
+	/// Buffers are bucketed by power of two size between 256 bytes and
+	/// 1 MiB.  Requests outside that range are simply allocated and are
+	/// not retained on return.  Rented buffers can be larger than the
+	/// requested size and their contents are not cleared.
+	///
+	/// Only scratch buffers with a known owner come from the pool.  The
+	/// BitStream of a rendered element is not pooled: DataElement.Value
+	/// hands out cached streams that the caller may keep (parents, seed
+	/// clones, mutation variants, fault logs), so there is no point where
+	/// their buffers could safely go back to the pool.
+	/// </remarks>
+	public static class BufferPool
+	{
+		const int MinShift = 8;
+		const int MaxShift = 20;
+		const int MaxPerBucket = 16;
+
+		static readonly Stack<byte[]>[] buckets = CreateBuckets();
+
+		static Stack<byte[]>[] CreateBuckets()
+		{
+			var ret = new Stack<byte[]>[MaxShift - MinShift + 1];
+			for (int i = 0; i < ret.Length; ++i)
+				ret[i] = new Stack<byte[]>();
+			return ret;
+		}
+
+		static int Bucket(int size)
+		{
+			int shift = MinShift;
+			while ((1 << shift) < size)
+				++shift;
+			return shift - MinShift;
+		}
+
+		/// <summary>
+		/// Get a buffer that is at least 'size' bytes long.
+		/// </summary>
+		public static byte[] Rent(int size)
+		{
+			if (size < 0)
+				throw new ArgumentOutOfRangeException("size");
+
+			if (size > (1 << MaxShift))
+				return new byte[size];
+
+			int idx = Bucket(size);
+			var stack = buckets[idx];
+
+			lock (stack)
+			{
+				if (stack.Count > 0)
+					return stack.Pop();
+			}
+
+			return new byte[1 << (idx + MinShift)];
+		}
+
+		/// <summary>
+		/// Give a buffer obtained from Rent() back to the pool.
+		/// </summary>
+		public static void Return(byte[] buffer)
+		{
+			if (buffer == null)
+				return;
+
+			int len = buffer.Length;
+			if (len < (1 << MinShift) || len > (1 << MaxShift) || (len & (len - 1)) != 0)
+				return;
+
+			var stack = buckets[Bucket(len)];
+
+			lock (stack)
+			{
+				if (stack.Count < MaxPerBucket)
+					stack.Push(buffer);
+			}
+		}
+
+		/// <summary>
+		/// Get the backing array of a MemoryStream without copying.
+		/// Returns null when the stream does not expose its buffer.
+		/// </summary>
+		public static byte[] GetBuffer(MemoryStream ms)
+		{
+			try
+			{
+				return ms.GetBuffer();
+			}
+			catch (UnauthorizedAccessException)
+			{
+				return null;
+			}
+		}
+	}
+}
+
+// end
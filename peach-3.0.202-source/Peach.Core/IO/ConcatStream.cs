@@ -0,0 +1,338 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.IO;
+
+namespace Peach.Core.IO
+{
+	/// <summary>
+	/// Stream made of several other streams laid end to end.
+	/// </summary>
+	/// <remarks>
+	/// Containers render into one of these so the cached values of their
+	/// children are shared instead of copied on every render.  The parts
+	/// must not change once they are added, which holds for the cached
+	/// value of a DataElement.  The first Write() or SetLength() copies the
+	/// contents into a private MemoryStream that is used from then on, so
+	/// a writer never modifies the parts.
+	/// </remarks>
+	[Serializable]
+	public class ConcatStream : Stream
+	{
+		Stream[] _parts;
+		long[] _starts;
+		long _pos = 0;
+		MemoryStream _copy = null;
+
+		/// <summary>
+		/// Join the first lengths[i] bytes of each of 'parts'.
+		/// </summary>
+		public ConcatStream(Stream[] parts, long[] lengths)
+		{
+			if (parts.Length != lengths.Length)
+				throw new ArgumentException("Every part needs a length.", "lengths");
+
+			_parts = parts;
+			_starts = new long[parts.Length + 1];
+
+			for (int i = 0; i < parts.Length; ++i)
+				_starts[i + 1] = _starts[i] + lengths[i];
+		}
+
+		ConcatStream(ConcatStream other)
+		{
+			_parts = other._parts;
+			_starts = other._starts;
+			_pos = other._pos;
+
+			if (other._copy != null)
+				_copy = CopyOf(other._copy);
+		}
+
+		/// <summary>
+		/// Copy of this stream that shares the same parts.
+		/// </summary>
+		public ConcatStream Clone()
+		{
+			return new ConcatStream(this);
+		}
+
+		/// <summary>
+		/// Copy the contents into a new expandable MemoryStream.
+		/// </summary>
+		public MemoryStream ToMemoryStream()
+		{
+			if (_copy != null)
+				return CopyOf(_copy);
+
+			var ret = new MemoryStream((int)Length);
+			WriteRange(0, Length, ret);
+			ret.Position = 0;
+			return ret;
+		}
+
+		/// <summary>
+		/// Write everything from the current position to the end into
+		/// 'output' and move the position to the end.
+		/// </summary>
+		public void WriteTo(Stream output)
+		{
+			long end = Length;
+			if (_pos < end)
+				WriteRange(_pos, end - _pos, output);
+			_pos = end;
+		}
+
+		static MemoryStream CopyOf(MemoryStream ms)
+		{
+			var ret = new MemoryStream((int)ms.Length);
+			WritePart(ms, 0, ms.Length, ret);
+			ret.Position = 0;
+			return ret;
+		}
+
+		int Find(long offset)
+		{
+			int idx = Array.BinarySearch(_starts, offset);
+			return idx < 0 ? ~idx - 1 : idx;
+		}
+
+		void ReadAt(long offset, byte[] buffer, int index, int count)
+		{
+			if (_copy != null)
+			{
+				ReadPart(_copy, offset, buffer, index, count);
+				return;
+			}
+
+			for (int i = Find(offset); count > 0; ++i)
+			{
+				long start = offset - _starts[i];
+				int len = (int)Math.Min(count, _starts[i + 1] - _starts[i] - start);
+				if (len <= 0)
+					continue;
+
+				ReadPart(_parts[i], start, buffer, index, len);
+				offset += len;
+				index += len;
+				count -= len;
+			}
+		}
+
+		void WriteRange(long offset, long count, Stream output)
+		{
+			if (_copy != null)
+			{
+				WritePart(_copy, offset, count, output);
+				return;
+			}
+
+			for (int i = Find(offset); count > 0; ++i)
+			{
+				long start = offset - _starts[i];
+				long len = Math.Min(count, _starts[i + 1] - _starts[i] - start);
+				if (len <= 0)
+					continue;
+
+				WritePart(_parts[i], start, len, output);
+				offset += len;
+				count -= len;
+			}
+		}
+
+		static void ReadPart(Stream part, long offset, byte[] buffer, int index, int count)
+		{
+			var cs = part as ConcatStream;
+			if (cs != null)
+			{
+				cs.ReadAt(offset, buffer, index, count);
+				return;
+			}
+
+			var ms = part as MemoryStream;
+			var src = ms != null ? BufferPool.GetBuffer(ms) : null;
+			if (src != null)
+			{
+				Buffer.BlockCopy(src, (int)offset, buffer, index, count);
+				return;
+			}
+
+			long oldPos = part.Position;
+			part.Position = offset;
+
+			while (count > 0)
+			{
+				int read = part.Read(buffer, index, count);
+				if (read == 0)
+					throw new EndOfStreamException();
+
+				index += read;
+				count -= read;
+			}
+
+			part.Position = oldPos;
+		}
+
+		static void WritePart(Stream part, long offset, long count, Stream output)
+		{
+			var cs = part as ConcatStream;
+			if (cs != null)
+			{
+				cs.WriteRange(offset, count, output);
+				return;
+			}
+
+			var ms = part as MemoryStream;
+			var src = ms != null ? BufferPool.GetBuffer(ms) : null;
+			if (src != null)
+			{
+				output.Write(src, (int)offset, (int)count);
+				return;
+			}
+
+			var buf = BufferPool.Rent((int)Math.Min(count, 1024 * 1024));
+
+			try
+			{
+				while (count > 0)
+				{
+					int len = (int)Math.Min(count, buf.Length);
+					ReadPart(part, offset, buf, 0, len);
+					output.Write(buf, 0, len);
+					offset += len;
+					count -= len;
+				}
+			}
+			finally
+			{
+				BufferPool.Return(buf);
+			}
+		}
+
+		void MakeCopy()
+		{
+			if (_copy != null)
+				return;
+
+			_copy = ToMemoryStream();
+			_parts = null;
+			_starts = null;
+		}
+
+		#region Stream
+
+		public override bool CanRead
+		{
+			get { return true; }
+		}
+
+		public override bool CanSeek
+		{
+			get { return true; }
+		}
+
+		public override bool CanWrite
+		{
+			get { return true; }
+		}
+
+		public override void Flush()
+		{
+		}
+
+		public override long Length
+		{
+			get { return _copy != null ? _copy.Length : _starts[_starts.Length - 1]; }
+		}
+
+		public override long Position
+		{
+			get { return _pos; }
+			set
+			{
+				if (value < 0)
+					throw new ArgumentOutOfRangeException("value");
+
+				_pos = value;
+			}
+		}
+
+		public override int Read(byte[] buffer, int offset, int count)
+		{
+			long avail = Length - _pos;
+			if (avail <= 0)
+				return 0;
+
+			int len = (int)Math.Min(count, avail);
+			ReadAt(_pos, buffer, offset, len);
+			_pos += len;
+			return len;
+		}
+
+		public override long Seek(long offset, SeekOrigin origin)
+		{
+			switch (origin)
+			{
+				case SeekOrigin.Begin:
+					Position = offset;
+					break;
+				case SeekOrigin.Current:
+					Position = _pos + offset;
+					break;
+				case SeekOrigin.End:
+					Position = Length + offset;
+					break;
+			}
+
+			return _pos;
+		}
+
+		public override void SetLength(long value)
+		{
+			MakeCopy();
+			_copy.SetLength(value);
+			_pos = Math.Min(_pos, value);
+		}
+
+		/// <summary>
+		/// Writes at the current position into a private copy of the parts.
+		/// </summary>
+		public override void Write(byte[] buffer, int offset, int count)
+		{
+			MakeCopy();
+			_copy.Position = _pos;
+			_copy.Write(buffer, offset, count);
+			_pos = _copy.Position;
+		}
+
+		#endregion
+	}
+}
+
+// end
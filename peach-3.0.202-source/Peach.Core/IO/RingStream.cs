@@ -0,0 +1,238 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.IO;
+
+namespace Peach.Core.IO
+{
+	/// <summary>
+	/// Append only receive buffer backed by a circular byte array.
+	/// </summary>
+	/// <remarks>
+	/// Position and Length are absolute offsets from the first byte ever
+	/// written, so readers can seek around exactly as they would with a
+	/// MemoryStream.  Calling Discard() releases everything before a given
+	/// offset, which keeps the backing array sized to the unread data
+	/// instead of the lifetime of the connection.
+	/// </remarks>
+	public class RingStream : Stream
+	{
+		byte[] _buf;
+		int _head = 0;
+		int _count = 0;
+		long _base = 0;
+		long _pos = 0;
+
+		public RingStream()
+			: this(4096)
+		{
+		}
+
+		public RingStream(int capacity)
+		{
+			if (capacity <= 0)
+				throw new ArgumentOutOfRangeException("capacity");
+
+			_buf = new byte[capacity];
+		}
+
+		/// <summary>
+		/// Absolute offset of the oldest byte still held in the buffer.
+		/// </summary>
+		public long Start
+		{
+			get { return _base; }
+		}
+
+		/// <summary>
+		/// Size of the backing array.
+		/// </summary>
+		public int Capacity
+		{
+			get { return _buf.Length; }
+		}
+
+		/// <summary>
+		/// Release all bytes before the absolute offset 'position'.
+		/// </summary>
+		public void Discard(long position)
+		{
+			long end = Math.Min(position, Length);
+			if (end <= _base)
+				return;
+
+			int drop = (int)(end - _base);
+			_head = (_head + drop) % _buf.Length;
+			_count -= drop;
+			_base = end;
+
+			if (_count == 0)
+				_head = 0;
+		}
+
+		void Reserve(int needed)
+		{
+			if (needed <= _buf.Length)
+				return;
+
+			int size = _buf.Length;
+			while (size < needed)
+				size *= 2;
+
+			var buf = new byte[size];
+			CopyOut(0, buf, 0, _count);
+			_buf = buf;
+			_head = 0;
+		}
+
+		void CopyOut(int index, byte[] buffer, int offset, int count)
+		{
+			int start = (_head + index) % _buf.Length;
+			int first = Math.Min(count, _buf.Length - start);
+			Buffer.BlockCopy(_buf, start, buffer, offset, first);
+			if (first < count)
+				Buffer.BlockCopy(_buf, 0, buffer, offset + first, count - first);
+		}
+
+		void CopyIn(int index, byte[] buffer, int offset, int count)
+		{
+			int start = (_head + index) % _buf.Length;
+			int first = Math.Min(count, _buf.Length - start);
+			Buffer.BlockCopy(buffer, offset, _buf, start, first);
+			if (first < count)
+				Buffer.BlockCopy(buffer, offset + first, _buf, 0, count - first);
+		}
+
+		#region Stream
+
+		public override bool CanRead
+		{
+			get { return true; }
+		}
+
+		public override bool CanSeek
+		{
+			get { return true; }
+		}
+
+		public override bool CanWrite
+		{
+			get { return true; }
+		}
+
+		public override void Flush()
+		{
+		}
+
+		public override long Length
+		{
+			get { return _base + _count; }
+		}
+
+		public override long Position
+		{
+			get { return _pos; }
+			set
+			{
+				if (value < _base)
+					throw new ArgumentOutOfRangeException("value", "Position has already been discarded.");
+
+				_pos = value;
+			}
+		}
+
+		public override int Read(byte[] buffer, int offset, int count)
+		{
+			long avail = Length - _pos;
+			if (avail <= 0)
+				return 0;
+
+			int len = (int)Math.Min(count, avail);
+			CopyOut((int)(_pos - _base), buffer, offset, len);
+			_pos += len;
+			return len;
+		}
+
+		public override long Seek(long offset, SeekOrigin origin)
+		{
+			switch (origin)
+			{
+				case SeekOrigin.Begin:
+					Position = offset;
+					break;
+				case SeekOrigin.Current:
+					Position = _pos + offset;
+					break;
+				case SeekOrigin.End:
+					Position = Length + offset;
+					break;
+			}
+
+			return _pos;
+		}
+
+		public override void SetLength(long value)
+		{
+			if (value < _base)
+				throw new ArgumentOutOfRangeException("value", "Length has already been discarded.");
+
+			int count = (int)(value - _base);
+			if (count > _count)
+			{
+				Reserve(count);
+				CopyIn(_count, new byte[count - _count], 0, count - _count);
+			}
+
+			_count = count;
+			_pos = Math.Min(_pos, value);
+		}
+
+		/// <summary>
+		/// Writes at the current position, extending the buffer as needed.
+		/// </summary>
+		public override void Write(byte[] buffer, int offset, int count)
+		{
+			if (_pos > Length)
+				SetLength(_pos);
+
+			int index = (int)(_pos - _base);
+			int end = index + count;
+
+			Reserve(end);
+			CopyIn(index, buffer, offset, count);
+
+			_count = Math.Max(_count, end);
+			_pos += count;
+		}
+
+		#endregion
+	}
+}
+
+// end
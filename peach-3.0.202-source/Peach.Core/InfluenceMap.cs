@@ -0,0 +1,221 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Runtime.Serialization.Formatters.Binary;
+
+namespace Peach.Core
+{
+	/// <summary>
+	/// Which coverage map entries each data element was seen to change.
+	/// </summary>
+	/// <remarks>
+	/// An element is probed by running an iteration where it is the only
+	/// mutated field and comparing the coverage of that iteration with the
+	/// coverage of the last unmutated (control) iteration.  Elements that
+	/// have been probed without ever changing the coverage are inert: they
+	/// are payload bytes the target does not branch on.
+	/// </remarks>
+	[Serializable]
+	public class InfluenceMap
+	{
+		/// <summary>
+		/// Maximum number of map entries kept per element.
+		/// </summary>
+		public const int MaxEdges = 256;
+
+		[Serializable]
+		class Entry
+		{
+			public int probes;
+			public HashSet<uint> edges = new HashSet<uint>();
+		}
+
+		Dictionary<string, Entry> _entries = new Dictionary<string, Entry>();
+
+		/// <summary>
+		/// Number of elements that have been probed.
+		/// </summary>
+		public int Count
+		{
+			get { return _entries.Count; }
+		}
+
+		/// <summary>
+		/// Record the result of probing 'element'.
+		/// </summary>
+		public void Record(string element, IEnumerable<uint> edges)
+		{
+			Entry e;
+			if (!_entries.TryGetValue(element, out e))
+				_entries.Add(element, e = new Entry());
+
+			e.probes += 1;
+
+			foreach (var edge in edges)
+			{
+				if (e.edges.Count >= MaxEdges)
+					break;
+
+				e.edges.Add(edge);
+			}
+		}
+
+		/// <summary>
+		/// Number of times 'element' has been probed.
+		/// </summary>
+		public int Probes(string element)
+		{
+			Entry e;
+			return _entries.TryGetValue(element, out e) ? e.probes : 0;
+		}
+
+		/// <summary>
+		/// Has 'element' been probed without ever changing the coverage.
+		/// </summary>
+		public bool IsInert(string element)
+		{
+			Entry e;
+			return _entries.TryGetValue(element, out e) && e.edges.Count == 0;
+		}
+
+		/// <summary>
+		/// Coverage map entries 'element' has been seen to change.
+		/// </summary>
+		public IEnumerable<uint> Edges(string element)
+		{
+			Entry e;
+			if (!_entries.TryGetValue(element, out e))
+				return new uint[0];
+
+			return e.edges;
+		}
+
+		/// <summary>
+		/// Elements that have been seen to change the coverage, most influential first.
+		/// </summary>
+		public IEnumerable<string> Influential()
+		{
+			return _entries.Where(a => a.Value.edges.Count > 0).OrderByDescending(a => a.Value.edges.Count).Select(a => a.Key);
+		}
+
+		public void Save(string fileName)
+		{
+			using (var fs = new FileStream(fileName, FileMode.Create))
+			{
+				new BinaryFormatter().Serialize(fs, this);
+			}
+		}
+
+		public static InfluenceMap Load(string fileName)
+		{
+			using (var fs = new FileStream(fileName, FileMode.Open, FileAccess.Read))
+			{
+				return (InfluenceMap)new BinaryFormatter().Deserialize(fs);
+			}
+		}
+
+		#region Native Trace
+
+		[DllImport(@"peachControl", EntryPoint="trace_accum_reset")]
+		static extern void trace_accum_reset();
+
+		[DllImport(@"peachControl", EntryPoint="trace_accum_add")]
+		static extern void trace_accum_add();
+
+		[DllImport(@"peachControl", EntryPoint="trace_accum_save_base")]
+		static extern void trace_accum_save_base();
+
+		[DllImport(@"peachControl", EntryPoint="trace_accum_diff")]
+		static extern uint trace_accum_diff([Out] uint[] edges, uint max);
+
+		[DllImport(@"peachControl", EntryPoint="trace_accum_features")]
+		static extern uint trace_accum_features([Out] uint[] features, uint max);
+
+		/// <summary>
+		/// Set by analysing strategies so Action.Run() collects the coverage
+		/// of every output into the iteration trace.
+		/// </summary>
+		public static bool Tracing = false;
+
+		/// <summary>
+		/// Start collecting a new iteration trace.
+		/// </summary>
+		public static void ResetTrace()
+		{
+			trace_accum_reset();
+		}
+
+		/// <summary>
+		/// Add the classified coverage of the last output to the iteration trace.
+		/// </summary>
+		public static void AddTrace()
+		{
+			trace_accum_add();
+		}
+
+		/// <summary>
+		/// Use the current iteration trace as the unmutated baseline.
+		/// </summary>
+		public static void SaveBaseTrace()
+		{
+			trace_accum_save_base();
+		}
+
+		/// <summary>
+		/// Coverage map entries that differ between the iteration trace and the baseline.
+		/// </summary>
+		public static uint[] DiffTrace()
+		{
+			var edges = new uint[MaxEdges];
+			var count = trace_accum_diff(edges, (uint)edges.Length);
+			if (count < edges.Length)
+				Array.Resize(ref edges, (int)count);
+			return edges;
+		}
+
+		/// <summary>
+		/// Every bucket bit set in the iteration trace, as (map index &lt;&lt; 3) | bit.
+		/// </summary>
+		public static uint[] TraceFeatures()
+		{
+			var count = trace_accum_features(null, 0);
+			var features = new uint[count];
+			trace_accum_features(features, count);
+			return features;
+		}
+
+		#endregion
+	}
+}
+
+// end
@@ -0,0 +1,183 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using Peach.Core.Agent;
+
+namespace Peach.Core.Loggers
+{
+	/// <summary>
+	/// In memory index of the faults of a run.
+	/// </summary>
+	/// <remarks>
+	/// A bucket is a normalized stack hash plus the classified coverage
+	/// checksum of the faulting iteration.  Only the first MaxSamples
+	/// faults of a bucket are written to disk, the rest only bump the
+	/// counters so a shallow bug hit over and over costs no disk I/O.
+	/// </remarks>
+	public class FaultBuckets
+	{
+		public class Bucket
+		{
+			public string Stack;
+			public int Coverage;
+			public string Title;
+			public uint FirstIteration;
+			public uint LastIteration;
+			public int Count;
+			public int Saved;
+		}
+
+		Dictionary<string, Bucket> _buckets = new Dictionary<string, Bucket>();
+
+		/// <param name="maxSamples">Faults kept per bucket, 0 keeps all</param>
+		public FaultBuckets(int maxSamples)
+		{
+			MaxSamples = maxSamples;
+		}
+
+		public int MaxSamples { get; private set; }
+
+		public IEnumerable<Bucket> Buckets
+		{
+			get { return _buckets.Values; }
+		}
+
+		/// <summary>
+		/// Stack hash of a fault that does not depend on load addresses.
+		/// </summary>
+		/// <remarks>
+		/// The debugger monitors already hash module relative frames.  A
+		/// fault that only carries a sanitizer report is hashed from the
+		/// frames of the report, anything else falls back to its folder
+		/// name or title.
+		/// </remarks>
+		public static string StackHash(Fault fault)
+		{
+			if (fault.majorHash != null)
+				return fault.majorHash;
+
+			byte[] report;
+			if (fault.collectedData.TryGetValue("Asan_Report.txt", out report))
+			{
+				var parsed = new SanitizerReport();
+				parsed.Append(report);
+				if (parsed.Detected)
+					return parsed.MajorHash;
+			}
+
+			return fault.folderName ?? fault.title ?? "Unknown";
+		}
+
+		static string Key(string stack, int coverage)
+		{
+			return stack + "_" + coverage.ToString("x8");
+		}
+
+		/// <summary>
+		/// True if the bucket already holds MaxSamples faults.
+		/// </summary>
+		public bool IsFull(string stack, int coverage)
+		{
+			Bucket bucket;
+			return MaxSamples > 0 && _buckets.TryGetValue(Key(stack, coverage), out bucket) && bucket.Saved >= MaxSamples;
+		}
+
+		public Bucket Find(string stack, int coverage)
+		{
+			Bucket bucket;
+			_buckets.TryGetValue(Key(stack, coverage), out bucket);
+			return bucket;
+		}
+
+		/// <summary>
+		/// Count a fault.
+		/// </summary>
+		/// <returns>Returns true if the fault should be saved.</returns>
+		public bool Add(string stack, int coverage, uint iteration, string title)
+		{
+			Bucket bucket;
+			string key = Key(stack, coverage);
+
+			if (!_buckets.TryGetValue(key, out bucket))
+			{
+				bucket = new Bucket()
+				{
+					Stack = stack,
+					Coverage = coverage,
+					Title = title,
+					FirstIteration = iteration,
+				};
+
+				_buckets.Add(key, bucket);
+			}
+
+			bucket.Count++;
+			bucket.LastIteration = iteration;
+
+			if (MaxSamples != 0 && bucket.Saved >= MaxSamples)
+				return false;
+
+			bucket.Saved++;
+			return true;
+		}
+
+		/// <summary>
+		/// Write the counters, most hit buckets first.
+		/// </summary>
+		public void Save(string fileName)
+		{
+			File.WriteAllText(fileName, Format());
+		}
+
+		/// <summary>
+		/// The text written by Save().
+		/// </summary>
+		public string Format()
+		{
+			var sb = new StringBuilder();
+			sb.AppendLine("Stack\tCoverage\tCount\tSaved\tFirst\tLast\tTitle");
+
+			foreach (var b in _buckets.Values.OrderByDescending(b => b.Count))
+			{
+				sb.AppendFormat("{0}\t{1:x8}\t{2}\t{3}\t{4}\t{5}\t{6}",
+					b.Stack, b.Coverage, b.Count, b.Saved, b.FirstIteration, b.LastIteration, b.Title);
+				sb.AppendLine();
+			}
+
+			return sb.ToString();
+		}
+	}
+}
+
+// end
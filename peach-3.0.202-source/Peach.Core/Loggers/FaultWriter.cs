@@ -0,0 +1,232 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading;
+
+using NLog;
+
+namespace Peach.Core.Loggers
+{
+	/// <summary>
+	/// Runs fault persistence jobs in order on a background thread.
+	/// </summary>
+	/// <remarks>
+	/// Jobs only get snapshots of the fault, the engine thread is free to
+	/// start the next iteration as soon as a job is queued.  The queue is
+	/// bounded, Enqueue() blocks while it is full so a crash storm can not
+	/// grow memory without limit.  Files written with WriteFile() are kept
+	/// open and synced to disk together once the queue runs dry or
+	/// BatchSize files are pending.
+	/// </remarks>
+	public class FaultWriter : IDisposable
+	{
+		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
+
+		object _lock = new object();
+		Queue<Action> _jobs = new Queue<Action>();
+		List<FileStream> _pending = new List<FileStream>();
+		Thread _thread;
+		bool _running = false;
+		bool _stop = false;
+
+		/// <param name="capacity">Jobs queued before Enqueue() blocks</param>
+		/// <param name="batchSize">Files written before they are synced</param>
+		public FaultWriter(int capacity, int batchSize)
+		{
+			Capacity = capacity;
+			BatchSize = batchSize;
+
+			_thread = new Thread(Run);
+			_thread.Name = "FaultWriter";
+			_thread.IsBackground = true;
+			_thread.Start();
+		}
+
+		public int Capacity { get; private set; }
+
+		public int BatchSize { get; private set; }
+
+		/// <summary>
+		/// Number of times pending files were synced.
+		/// </summary>
+		public int Syncs { get; private set; }
+
+		/// <summary>
+		/// Queue a job, blocks while Capacity jobs are waiting.
+		/// </summary>
+		public void Enqueue(Action job)
+		{
+			lock (_lock)
+			{
+				if (_stop)
+					throw new ObjectDisposedException("FaultWriter");
+
+				while (_jobs.Count >= Capacity)
+					Monitor.Wait(_lock);
+
+				_jobs.Enqueue(job);
+				Monitor.PulseAll(_lock);
+			}
+		}
+
+		/// <summary>
+		/// Block until every queued job ran and its files were synced.
+		/// </summary>
+		public void Wait()
+		{
+			lock (_lock)
+			{
+				while (_jobs.Count > 0 || _running)
+					Monitor.Wait(_lock);
+			}
+		}
+
+		/// <summary>
+		/// Write a file from a job, the file is synced with the batch.
+		/// </summary>
+		public void WriteFile(string fileName, byte[] data)
+		{
+			var fs = new FileStream(fileName, FileMode.Create, FileAccess.Write);
+
+			try
+			{
+				fs.Write(data, 0, data.Length);
+			}
+			catch
+			{
+				fs.Dispose();
+				throw;
+			}
+
+			_pending.Add(fs);
+
+			if (_pending.Count >= BatchSize)
+				Sync();
+		}
+
+		public void WriteFile(string fileName, string text)
+		{
+			WriteFile(fileName, Encoding.UTF8.GetBytes(text));
+		}
+
+		/// <summary>
+		/// Sync the files written so far, call from a job before moving
+		/// folders that hold them.
+		/// </summary>
+		public void Sync()
+		{
+			if (_pending.Count == 0)
+				return;
+
+			foreach (var fs in _pending)
+			{
+				try
+				{
+					fs.Flush(true);
+				}
+				catch (Exception ex)
+				{
+					logger.Error("Unable to sync '{0}'. {1}", fs.Name, ex.Message);
+				}
+				finally
+				{
+					fs.Close();
+				}
+			}
+
+			_pending.Clear();
+			Syncs++;
+		}
+
+		void Run()
+		{
+			while (true)
+			{
+				Action job;
+
+				lock (_lock)
+				{
+					while (_jobs.Count == 0 && !_stop)
+						Monitor.Wait(_lock);
+
+					if (_jobs.Count == 0)
+						return;
+
+					job = _jobs.Dequeue();
+					_running = true;
+					Monitor.PulseAll(_lock);
+				}
+
+				try
+				{
+					job();
+				}
+				catch (Exception ex)
+				{
+					logger.Error("Unable to save fault. {0}", ex.Message);
+				}
+
+				bool drained;
+				lock (_lock)
+					drained = _jobs.Count == 0;
+
+				// End of the burst, make everything durable
+				if (drained)
+					Sync();
+
+				lock (_lock)
+				{
+					_running = false;
+					Monitor.PulseAll(_lock);
+				}
+			}
+		}
+
+		public void Dispose()
+		{
+			if (_thread == null)
+				return;
+
+			lock (_lock)
+			{
+				_stop = true;
+				Monitor.PulseAll(_lock);
+			}
+
+			_thread.Join();
+			_thread = null;
+		}
+	}
+}
+
+// end
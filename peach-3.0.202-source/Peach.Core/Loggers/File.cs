@@ -50,6 +50,7 @@ namespace Peach.Core.Loggers
 	[Logger("Filesystem", true)]
 	[Logger("logger.Filesystem")]
 	[Parameter("Path", typeof(string), "Log folder")]
+	[Parameter("MaxFaultSamples", typeof(int), "Faults saved per stack hash and coverage bucket, 0 saves all", "5")]
 	public class FileLogger : Logger
 	{
 		private static NLog.Logger logger = LogManager.GetCurrentClassLogger(); 
@@ -57,10 +58,23 @@ namespace Peach.Core.Loggers
 		string ourpath = null;
 		TextWriter log = null;
 		string reproPath = null;
+		int maxFaultSamples = 5;
+		FaultBuckets buckets = null;
+		FaultWriter writer = null;
+
+		/// <summary>
+		/// Faults waiting to be written before the engine blocks, and files
+		/// written before they are synced.
+		/// </summary>
+		const int WriterCapacity = 16;
+		const int WriterBatchSize = 64;
 
 		public FileLogger(Dictionary<string, Variant> args)
 		{
 			logpath = (string)args["Path"];
+
+			if (args.ContainsKey("MaxFaultSamples"))
+				maxFaultSamples = (int)args["MaxFaultSamples"];
 		}
 
 		public string Path
@@ -72,42 +86,127 @@ namespace Peach.Core.Loggers
 			get { return ourpath; }
 		}
 
+		/// <summary>
+		/// Counters of every fault bucket of the run, see FaultBuckets.
+		/// </summary>
+		public const string BucketsFile = "buckets.txt";
+
+		static Fault CoreFault(Fault[] faults)
+		{
+			foreach (Fault fault in faults)
+			{
+				if (fault.type == FaultType.Fault)
+					return fault;
+			}
+
+			return null;
+		}
+
 		protected override void Engine_ReproFault(RunContext context, uint currentIteration, Peach.Core.Dom.StateModel stateModel, Fault[] faults)
 		{
+			var core = CoreFault(faults);
+
+			// No need to keep the initial fault if the reproduction will be dropped
+			if (core != null && buckets.IsFull(FaultBuckets.StackHash(core), Dom.Action.hash_after_classify()))
+			{
+				reproPath = null;
+				return;
+			}
+
 			reproPath = saveFaults("Reproducing", context, currentIteration, stateModel, faults);
 		}
 
 		protected override void Engine_ReproFailed(RunContext context, uint currentIteration)
 		{
+			if (reproPath == null)
+				return;
+
+			string src = reproPath;
 			string baseName = System.IO.Path.Combine(ourpath, "Reproducing") + System.IO.Path.DirectorySeparatorChar;
-			string subdir = reproPath.Substring(baseName.Length);
+			string subdir = src.Substring(baseName.Length);
 			string dest = System.IO.Path.Combine(ourpath, "NonReproducable", System.IO.Path.GetDirectoryName(subdir));
-			if (!Directory.Exists(dest))
-				Directory.CreateDirectory(dest);
-			dest = System.IO.Path.Combine(dest, System.IO.Path.GetFileName(subdir));
-			Directory.Move(reproPath, dest);
-			Directory.Delete(System.IO.Path.Combine(ourpath, "Reproducing"), true);
+
+			writer.Enqueue(delegate()
+			{
+				writer.Sync();
+				if (!Directory.Exists(dest))
+					Directory.CreateDirectory(dest);
+				Directory.Move(src, System.IO.Path.Combine(dest, System.IO.Path.GetFileName(subdir)));
+				Directory.Delete(System.IO.Path.Combine(ourpath, "Reproducing"), true);
+			});
+
 			reproPath = null;
 		}
 
 		protected override void Engine_Fault(RunContext context, uint currentIteration, StateModel stateModel, Fault[] faults)
 		{
+			var core = CoreFault(faults);
+
+			if (core != null)
+			{
+				string stack = FaultBuckets.StackHash(core);
+				int coverage = Dom.Action.hash_after_classify();
+
+				if (!buckets.Add(stack, coverage, currentIteration, core.title))
+				{
+					var bucket = buckets.Find(stack, coverage);
+					log.WriteLine("! Duplicate fault at iteration {0} : {1}_{2:x8} hit {3} times", currentIteration, stack, coverage, bucket.Count);
+
+					if (reproPath != null)
+					{
+						string repro = System.IO.Path.Combine(ourpath, "Reproducing");
+						writer.Enqueue(delegate()
+						{
+							writer.Sync();
+							Directory.Delete(repro, true);
+						});
+						reproPath = null;
+					}
+
+					return;
+				}
+			}
+
 			string dir = saveFaults("Faults", context, currentIteration, stateModel, faults);
+			string counters = buckets.Format();
+			writer.Enqueue(delegate()
+			{
+				writer.WriteFile(System.IO.Path.Combine(ourpath, BucketsFile), counters);
+			});
+
 			if (reproPath != null)
 			{
-				string dirName = "Initial";
-				int i = 1;
-				while (Directory.Exists(System.IO.Path.Combine(dir, dirName)))
-					dirName = "Initial_" + i++;
-				Directory.Move(reproPath, System.IO.Path.Combine(dir, dirName));
-				Directory.Delete(System.IO.Path.Combine(ourpath, "Reproducing"), true);
+				string src = reproPath;
+				writer.Enqueue(delegate()
+				{
+					writer.Sync();
+					string dirName = "Initial";
+					int i = 1;
+					while (Directory.Exists(System.IO.Path.Combine(dir, dirName)))
+						dirName = "Initial_" + i++;
+					Directory.Move(src, System.IO.Path.Combine(dir, dirName));
+					Directory.Delete(System.IO.Path.Combine(ourpath, "Reproducing"), true);
+				});
 				reproPath = null;
 			}
 		}
 
-		//feilong:调用control.o
-		[DllImport(@"peachControl", EntryPoint="feilong_save")]   
-        public static unsafe extern int feilong_save(char[] path);
+		/// <summary>
+		/// Run level checkpoint of the virgin map, one generation per update.
+		/// </summary>
+		public const string CheckpointFile = "checkpoint.bin";
+
+		/// <summary>
+		/// Written to each fault folder, holds the checkpoint generation to
+		/// reproduce the fault from.
+		/// </summary>
+		public const string CheckpointRefFile = "checkpoint.txt";
+
+		[DllImport(@"peachControl", EntryPoint="ckpt_open")]
+		public static extern int ckpt_open(string path);
+
+		[DllImport(@"peachControl", EntryPoint="ckpt_commit")]
+		public static extern uint ckpt_commit();
 
 		private string saveFaults(string root, RunContext context, uint currentIteration, StateModel stateModel, Fault[] faults)
 		{
@@ -132,9 +231,6 @@ namespace Peach.Core.Loggers
 				throw new ApplicationException("Error, we should always have a fault with type = Fault!");
 
 			string faultPath = System.IO.Path.Combine(ourpath, root);
-			if (!Directory.Exists(faultPath))
-				Directory.CreateDirectory(faultPath);
-
 			if (coreFault.folderName != null)
 				faultPath = System.IO.Path.Combine(faultPath, coreFault.folderName);
 
@@ -148,12 +244,11 @@ namespace Peach.Core.Loggers
 					string.Format("{0}_{1}_{2}", coreFault.exploitability, coreFault.majorHash, coreFault.minorHash));
 			}
 
-			if (!Directory.Exists(faultPath))
-				Directory.CreateDirectory(faultPath);
-
 			faultPath = System.IO.Path.Combine(faultPath, currentIteration.ToString());
-			if (!Directory.Exists(faultPath))
-				Directory.CreateDirectory(faultPath);
+
+			// Snapshot everything the next iteration changes, the files are
+			// written by the fault writer while fuzzing continues.
+			var files = new List<KeyValuePair<string, byte[]>>();
 
 			int cnt = 0;
 			foreach (Dom.Action action in stateModel.dataActions)
@@ -161,12 +256,16 @@ namespace Peach.Core.Loggers
 				logger.Debug("Writing action: " + action.name);
 
 				cnt++;
+
+				// Qualified with the state, action names are only unique within one
+				string actionName = action.parent.name + "." + action.name;
+
 				if (action.dataModel != null)
 				{
 					string fileName = System.IO.Path.Combine(faultPath, string.Format("action_{0}_{1}_{2}.txt",
-								  cnt, action.type.ToString(), action.name));
+								  cnt, action.type.ToString(), actionName));
 
-					File.WriteAllBytes(fileName, action.dataModel.Value.Value);
+					files.Add(new KeyValuePair<string, byte[]>(fileName, action.dataModel.Value.Value));
 				}
 				else if (action.parameters.Count > 0)
 				{
@@ -175,9 +274,9 @@ namespace Peach.Core.Loggers
 					{
 						pcnt++;
 						string fileName = System.IO.Path.Combine(faultPath, string.Format("action_{0}-{1}_{2}_{3}.txt",
-										cnt, pcnt, action.type.ToString(), action.name));
+										cnt, pcnt, action.type.ToString(), actionName));
 
-						File.WriteAllBytes(fileName, param.dataModel.Value.Value);
+						files.Add(new KeyValuePair<string, byte[]>(fileName, param.dataModel.Value.Value));
 					}
 				}
 			}
@@ -187,33 +286,49 @@ namespace Peach.Core.Loggers
 			{
 				logger.Debug("Writing fault: " + fault.title);
 
+				// Monitors hand over a new buffer per fault, no copy needed
 				foreach (string key in fault.collectedData.Keys)
 				{
 					string fileName = System.IO.Path.Combine(faultPath,
 						fault.detectionSource + "_" + key);
-					File.WriteAllBytes(fileName, fault.collectedData[key]);
+					files.Add(new KeyValuePair<string, byte[]>(fileName, fault.collectedData[key]));
 				}
 
 				if (fault.description != null)
 				{
 					string fileName = System.IO.Path.Combine(faultPath,
 						fault.detectionSource + "_" + "description.txt");
-					File.WriteAllText(fileName, fault.description);
+					files.Add(new KeyValuePair<string, byte[]>(fileName, Encoding.UTF8.GetBytes(fault.description)));
 				}
 			}
 
-			//feilong:调用feilong_save，当crash时保存信息
-			Console.WriteLine("feilong:feilong_save start");
-			unsafe{
-				string path=System.IO.Path.Combine(faultPath,"repo.bin");
-				if(0 != feilong_save(path.ToCharArray())){
-					Console.WriteLine("feilong:feilong_save run error!");
-					
-				}
+			// Reference the checkpoint generation instead of copying the virgin map
+			files.Add(new KeyValuePair<string, byte[]>(System.IO.Path.Combine(faultPath, CheckpointRefFile),
+				Encoding.UTF8.GetBytes(ckpt_commit().ToString())));
+
+			// Reference the record of the faulting iteration so -repro can replay just that one
+			var journal = Peach.Core.Runtime.SHARE.replayJournal;
+			if (journal != null)
+			{
+				long offset = journal.Commit();
+				journal.Flush();
+				if (offset >= 0)
+					files.Add(new KeyValuePair<string, byte[]>(System.IO.Path.Combine(faultPath, ReplayJournal.RefFile),
+						Encoding.UTF8.GetBytes(offset.ToString())));
 			}
-			Console.WriteLine("feilong:feilong_save finish");
+
 			//feilong:保存seedpool
-			Peach.Core.Runtime.SHARE.saveSeedQueueIndexToFile(faultPath);
+			var seedQueue = new Queue<int>(Peach.Core.Runtime.SHARE.seedPoolIndexQueueCopy);
+
+			writer.Enqueue(delegate()
+			{
+				Directory.CreateDirectory(faultPath);
+
+				foreach (var kv in files)
+					writer.WriteFile(kv.Key, kv.Value);
+
+				Peach.Core.Runtime.SHARE.saveSeedQueueIndexToFile(faultPath, seedQueue);
+			});
 
 			log.Flush();
 			return faultPath;
@@ -221,6 +336,9 @@ namespace Peach.Core.Loggers
 
 		protected override void Engine_IterationStarting(RunContext context, uint currentIteration, uint currentSubIteration, uint? totalIterations)
 		{
+			if (Peach.Core.Runtime.SHARE.replayJournal != null)
+				Peach.Core.Runtime.SHARE.replayJournal.Begin(currentIteration, currentSubIteration);
+
 			if (currentIteration != 1 && currentIteration % 100 != 0)
 				return;
 
@@ -236,6 +354,12 @@ namespace Peach.Core.Loggers
 			}
 		}
 
+		protected override void Engine_IterationFinished(RunContext context, uint currentIteration)
+		{
+			if (Peach.Core.Runtime.SHARE.replayJournal != null)
+				Peach.Core.Runtime.SHARE.replayJournal.Commit();
+		}
+
 		protected override void Engine_TestError(RunContext context, Exception e)
 		{
 			log.WriteLine("! Test error: " + e.ToString());
@@ -244,6 +368,24 @@ namespace Peach.Core.Loggers
 
 		protected override void Engine_TestFinished(RunContext context)
 		{
+			// Everything queued has to be on disk before the run is over
+			if (writer != null)
+			{
+				writer.Dispose();
+				writer = null;
+			}
+
+			if (buckets != null && ourpath != null)
+				buckets.Save(System.IO.Path.Combine(ourpath, BucketsFile));
+
+			if (Peach.Core.Runtime.SHARE.replayJournal != null)
+			{
+				Peach.Core.Runtime.SHARE.replayJournal.Dispose();
+				Peach.Core.Runtime.SHARE.replayJournal = null;
+			}
+
+			CloseSeedStores();
+
 			if (log != null)
 			{
 				log.WriteLine(". Test finished: " + context.test.name);
@@ -254,6 +396,21 @@ namespace Peach.Core.Loggers
 			}
 		}
 
+		static void CloseSeedStores()
+		{
+			if (Peach.Core.Runtime.SHARE.seedStore != null)
+			{
+				Peach.Core.Runtime.SHARE.seedStore.Dispose();
+				Peach.Core.Runtime.SHARE.seedStore = null;
+			}
+
+			if (Peach.Core.Runtime.SHARE.queueStore != null)
+			{
+				Peach.Core.Runtime.SHARE.queueStore.Dispose();
+				Peach.Core.Runtime.SHARE.queueStore = null;
+			}
+		}
+
 		protected override void Engine_TestStarting(RunContext context)
 		{
 			if (log != null)
@@ -283,6 +440,21 @@ namespace Peach.Core.Loggers
 			}
 
 			log = File.CreateText(System.IO.Path.Combine(ourpath, "status.txt"));
+			buckets = new FaultBuckets(maxFaultSamples);
+
+			if (writer != null)
+				writer.Dispose();
+			writer = new FaultWriter(WriterCapacity, WriterBatchSize);
+
+			if (0 != ckpt_open(System.IO.Path.Combine(ourpath, CheckpointFile)))
+				logger.Warn("Unable to create the checkpoint file, faults can not be reproduced with -repro.");
+
+			// Seed stores are opened in the new run folder on first use
+			CloseSeedStores();
+
+			if (Peach.Core.Runtime.SHARE.replayJournal != null)
+				Peach.Core.Runtime.SHARE.replayJournal.Dispose();
+			Peach.Core.Runtime.SHARE.replayJournal = new ReplayJournal(System.IO.Path.Combine(ourpath, ReplayJournal.FileName), context.config.randomSeed);
 
 			log.WriteLine("Peach Fuzzing Run");
 			log.WriteLine("=================");
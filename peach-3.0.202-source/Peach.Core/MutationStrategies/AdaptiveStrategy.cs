@@ -0,0 +1,425 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.Linq;
+
+using Peach.Core.Dom;
+
+using NLog;
+
+namespace Peach.Core.MutationStrategies
+{
+	/// <summary>
+	/// Smoothed hit rate of a set of keys, used to weight random selection.
+	/// </summary>
+	/// <remarks>
+	/// The rate of a key is (hits + 1) / (uses + 2), so keys that have never
+	/// been tried start at 0.5 and keys that keep failing decay towards zero
+	/// without ever becoming unselectable.  Once a key has been used 'Window'
+	/// times both counters are halved so the rate keeps tracking recent results.
+	/// </remarks>
+	public class HitRates<TKey>
+	{
+		class Counts
+		{
+			public double hits;
+			public double uses;
+		}
+
+		Dictionary<TKey, Counts> _counts = new Dictionary<TKey, Counts>();
+
+		public HitRates()
+			: this(1000)
+		{
+		}
+
+		public HitRates(int window)
+		{
+			Window = window;
+		}
+
+		/// <summary>
+		/// Number of uses after which old results are aged out.
+		/// </summary>
+		public int Window { get; private set; }
+
+		/// <summary>
+		/// Record one use of 'key', and whether it found a new path.
+		/// </summary>
+		public void Record(TKey key, bool hit)
+		{
+			Counts c;
+			if (!_counts.TryGetValue(key, out c))
+				_counts.Add(key, c = new Counts());
+
+			c.uses += 1;
+			if (hit)
+				c.hits += 1;
+
+			if (c.uses >= Window)
+			{
+				c.uses /= 2;
+				c.hits /= 2;
+			}
+		}
+
+		/// <summary>
+		/// Smoothed hit rate of 'key', between 0 and 1 exclusive.
+		/// </summary>
+		public double Rate(TKey key)
+		{
+			Counts c;
+			if (!_counts.TryGetValue(key, out c))
+				return 0.5;
+
+			return (c.hits + 1) / (c.uses + 2);
+		}
+
+		/// <summary>
+		/// Pick an index into 'weights' with probability proportional to its weight.
+		/// </summary>
+		public static int Choose(Random random, IList<double> weights)
+		{
+			double total = 0;
+			foreach (var w in weights)
+				total += w;
+
+			double r = random.NextDouble() * total;
+			for (int i = 0; i < weights.Count; ++i)
+			{
+				r -= weights[i];
+				if (r < 0)
+					return i;
+			}
+
+			return weights.Count - 1;
+		}
+	}
+
+	/// <summary>
+	/// Random strategy that learns which fields and mutators find new paths.
+	/// </summary>
+	/// <remarks>
+	/// Every mutated iteration is scored by whether SHARE.cur_path moved
+	/// while it ran.  The result is credited to each element that was
+	/// mutated, to the mutator used on it, to the (element, mutator) pair
+	/// and to the number of fields mutated.  The next iteration draws each
+	/// of those choices in proportion to their HitRates instead of uniformly.
+	///
+	/// With Analyze enabled, every new path queues the recorded elements
+	/// for probing.  A batch of probes starts with a base iteration that
+	/// sends the data set unmutated.  Then each element is mutated on its
+	/// own for one iteration, and the coverage map entries that differ
+	/// from the base are added to an InfluenceMap, which is saved next to
+	/// the seed pool.  Seeds are not spliced into the base or the probes,
+	/// so every difference comes from the probed element.  Elements found
+	/// to be inert are then picked a tenth as often.
+	/// </remarks>
+	[MutationStrategy("AdaptiveRandom", true)]
+	[MutationStrategy("AdaptiveStrategy")]
+	[Parameter("SwitchCount", typeof(int), "Number of iterations to perform per-mutator befor switching.", "200")]
+	[Parameter("MaxFieldsToMutate", typeof(int), "Maximum fields to mutate at once.", "6")]
+	[Parameter("Analyze", typeof(bool), "Probe which fields change the coverage after each new path.", "false")]
+	public class AdaptiveStrategy : RandomStrategy
+	{
+		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
+
+		HitRates<int> _fieldCounts = new HitRates<int>();
+		HitRates<ElementId> _elements = new HitRates<ElementId>();
+		HitRates<string> _mutators = new HitRates<string>();
+		HitRates<Tuple<ElementId, string>> _pairs = new HitRates<Tuple<ElementId, string>>();
+
+		/// <summary>
+		/// How many times an element is probed before it is left alone.
+		/// </summary>
+		const int ProbesPerElement = 3;
+
+		/// <summary>
+		/// Weight multiplier for elements that never changed the coverage.
+		/// </summary>
+		const double InertWeight = 0.1;
+
+		List<Tuple<ElementId, string>> _applied = new List<Tuple<ElementId, string>>();
+		int _fieldCount = 0;
+		int _startPath = 0;
+
+		bool _analyze = false;
+		bool _haveBase = false;
+		bool _baseRun = false;
+		bool _probing = false;
+		InfluenceMap _influence = new InfluenceMap();
+		Queue<ElementId> _probes = new Queue<ElementId>();
+		HashSet<ElementId> _queued = new HashSet<ElementId>();
+		ElementId _probe = null;
+		Iterations _known = null;
+
+		public AdaptiveStrategy(Dictionary<string, Variant> args)
+			: base(args)
+		{
+			if (args.ContainsKey("Analyze"))
+				_analyze = bool.Parse((string)args["Analyze"]);
+		}
+
+		public HitRates<int> FieldCounts { get { return _fieldCounts; } }
+		public HitRates<string> Mutators { get { return _mutators; } }
+		public InfluenceMap Influence { get { return _influence; } }
+
+		public override void Initialize(RunContext context, Engine engine)
+		{
+			base.Initialize(context, engine);
+
+			engine.IterationFinished += new Engine.IterationFinishedEventHandler(engine_IterationFinished);
+
+			if (_analyze)
+			{
+				InfluenceMap.Tracing = true;
+				engine.IterationStarting += new Engine.IterationStartingEventHandler(engine_IterationStarting);
+			}
+		}
+
+		public override void Finalize(RunContext context, Engine engine)
+		{
+			base.Finalize(context, engine);
+
+			engine.IterationFinished -= engine_IterationFinished;
+
+			if (_analyze)
+			{
+				InfluenceMap.Tracing = false;
+				engine.IterationStarting -= engine_IterationStarting;
+				EndProbing();
+			}
+		}
+
+		static string InfluenceKey(ElementId id)
+		{
+			return id.ModelName + "/" + id.ElementName;
+		}
+
+		void engine_IterationStarting(RunContext context, uint currentIteration, uint currentSubIteration, uint? totalIterations)
+		{
+			InfluenceMap.ResetTrace();
+
+			// Runs after SelectFieldCount().  Keep seed data out of the base
+			// and the probes, it changes the coverage on its own.
+			Runtime.SHARE.if_in = _probing;
+		}
+
+		void EndProbing()
+		{
+			if (_probing)
+				Runtime.SHARE.if_in = false;
+
+			_probing = false;
+		}
+
+		void engine_IterationFinished(RunContext context, uint currentIteration)
+		{
+			if (_analyze)
+			{
+				EndProbing();
+
+				// A control iteration can switch to another data set
+				if (context.controlIteration)
+					_haveBase = false;
+
+				if (_baseRun)
+				{
+					InfluenceMap.SaveBaseTrace();
+					_haveBase = true;
+					_baseRun = false;
+				}
+			}
+
+			if (_fieldCount == 0)
+				return;
+
+			// StateModel.Run() clears has_new_path_iteration before we get here,
+			// but cur_path only ever moves forward when a new path is found.
+			bool hit = Runtime.SHARE.cur_path != _startPath;
+
+			if (_probe != null)
+			{
+				_influence.Record(InfluenceKey(_probe), InfluenceMap.DiffTrace());
+				_probe = null;
+
+				if (_probes.Count == 0)
+				{
+					SaveInfluence(context);
+					_haveBase = false;
+				}
+			}
+			else
+			{
+				_fieldCounts.Record(_fieldCount, hit);
+			}
+
+			foreach (var item in _applied)
+			{
+				_elements.Record(item.Item1, hit);
+				_mutators.Record(item.Item2, hit);
+				_pairs.Record(item, hit);
+			}
+
+			if (hit)
+			{
+				logger.Debug("Iteration {0} found a new path mutating {1} field(s).", currentIteration, _fieldCount);
+
+				if (_analyze)
+					QueueProbes();
+			}
+
+			_applied.Clear();
+			_fieldCount = 0;
+		}
+
+		void QueueProbes()
+		{
+			if (_known == null)
+				return;
+
+			foreach (var id in _known.Keys)
+			{
+				if (id.ElementName == null || _queued.Contains(id))
+					continue;
+
+				if (_influence.Probes(InfluenceKey(id)) >= ProbesPerElement)
+					continue;
+
+				_queued.Add(id);
+				_probes.Enqueue(id);
+			}
+		}
+
+		void SaveInfluence(RunContext context)
+		{
+			if (context.test.loggers.Count == 0)
+				return;
+
+			var fileLogger = context.test.loggers[0] as Peach.Core.Loggers.FileLogger;
+			if (fileLogger == null)
+				return;
+
+			try
+			{
+				Runtime.SHARE.saveInfluenceMapToFile(_influence, fileLogger);
+			}
+			catch (Exception ex)
+			{
+				logger.Debug("Unable to save influence map. {0}", ex.Message);
+			}
+		}
+
+		protected override int SelectFieldCount(int max)
+		{
+			_startPath = Runtime.SHARE.cur_path;
+			_applied.Clear();
+
+			if (_analyze && !_context.controlIteration && _probes.Count > 0)
+			{
+				_probing = true;
+
+				// Send the data set unmutated to get the base coverage
+				if (!_haveBase)
+				{
+					_baseRun = true;
+					_fieldCount = 0;
+					return _fieldCount;
+				}
+
+				// Probes mutate a single field so the coverage change is all its own
+				_fieldCount = 1;
+				return _fieldCount;
+			}
+
+			var weights = new double[max];
+			for (int i = 0; i < max; ++i)
+				weights[i] = _fieldCounts.Rate(i + 1);
+
+			_fieldCount = HitRates<int>.Choose(Random, weights) + 1;
+			return _fieldCount;
+		}
+
+		protected override KeyValuePair<ElementId, List<Mutator>>[] SelectFields(Iterations iterations, int count)
+		{
+			_known = iterations;
+
+			if (_baseRun)
+				return new KeyValuePair<ElementId, List<Mutator>>[0];
+
+			if (_analyze && _haveBase)
+			{
+				while (_probes.Count > 0)
+				{
+					var id = _probes.Dequeue();
+					_queued.Remove(id);
+
+					List<Mutator> mutators;
+					if (!iterations.TryGetValue(id, out mutators))
+						continue;
+
+					_probe = id;
+					return new KeyValuePair<ElementId, List<Mutator>>[] { new KeyValuePair<ElementId, List<Mutator>>(id, mutators) };
+				}
+			}
+
+			var items = iterations.ToList();
+			var weights = items.Select(a => _elements.Rate(a.Key) * (_influence.IsInert(InfluenceKey(a.Key)) ? InertWeight : 1.0)).ToList();
+			var ret = new List<KeyValuePair<ElementId, List<Mutator>>>();
+
+			// Weighted sample without replacement
+			while (ret.Count < count && items.Count > 0)
+			{
+				int idx = HitRates<int>.Choose(Random, weights);
+				ret.Add(items[idx]);
+				items.RemoveAt(idx);
+				weights.RemoveAt(idx);
+			}
+
+			return ret.ToArray();
+		}
+
+		protected override Mutator SelectMutator(ElementId id, List<Mutator> mutators)
+		{
+			var weights = new double[mutators.Count];
+			for (int i = 0; i < mutators.Count; ++i)
+			{
+				var m = mutators[i];
+				weights[i] = m.SelectionWeight * _mutators.Rate(m.name) * _pairs.Rate(new Tuple<ElementId, string>(id, m.name));
+			}
+
+			var mutator = mutators[HitRates<int>.Choose(Random, weights)];
+			_applied.Add(new Tuple<ElementId, string>(id, mutator.name));
+			return mutator;
+		}
+	}
+}
+
+// end
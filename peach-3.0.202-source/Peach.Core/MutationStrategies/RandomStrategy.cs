@@ -125,13 +125,91 @@ namespace Peach.Core.MutationStrategies
 				_dataSets = new OrderedDictionary<string, DataSetTracker>();
 				_mutations = null;
 			}
+			else if (Runtime.SHARE.replayRecord != null && !context.controlIteration)
+			{
+				_mutations = ReplayFields(Runtime.SHARE.replayRecord);
+			}
 			else
 			{
-				// Random.Next() Doesn't include max and we want it to
-				var fieldsToMutate = Random.Next(1, maxFieldsToMutate + 1);
+				var fieldsToMutate = SelectFieldCount(maxFieldsToMutate);
+
+				_mutations = SelectFields(_iterations, fieldsToMutate);
+			}
+		}
+
+		/// <summary>
+		/// The elements mutated by a recorded iteration, see ReplayJournal.
+		/// </summary>
+		KeyValuePair<ElementId, List<Mutator>>[] ReplayFields(ReplayRecord record)
+		{
+			var ret = new List<KeyValuePair<ElementId, List<Mutator>>>();
+
+			foreach (var m in record.Mutations)
+			{
+				var id = new ElementId(m.Model, m.Element);
+				List<Mutator> mutators;
+
+				if (!_iterations.TryGetValue(id, out mutators))
+					throw new PeachException("Error, the replay record of iteration " + record.Iteration +
+						" mutates '" + m.Element + "' which is not in the data model, was the pit changed?");
+
+				ret.Add(new KeyValuePair<ElementId, List<Mutator>>(id, mutators));
+			}
+
+			return ret.ToArray();
+		}
+
+		/// <summary>
+		/// SelectMutator() that is recorded to, or replayed from, the
+		/// replay journal.  The random state is saved before the mutator
+		/// runs so replaying does not depend on the draws of earlier
+		/// iterations.
+		/// </summary>
+		Mutator PickMutator(ElementId id, List<Mutator> mutators)
+		{
+			var record = Runtime.SHARE.replayRecord;
+			if (record != null)
+			{
+				var m = record.Find(id.ModelName, id.ElementName);
+				var mutator = m == null ? null : mutators.FirstOrDefault(x => x.name == m.Mutator);
+				if (mutator == null)
+					throw new PeachException("Error, unable to find the recorded mutator of '" + id.ElementName + "'.");
 
-				_mutations = Random.Sample(_iterations, fieldsToMutate);
+				Random.SetState(m.State);
+				return mutator;
 			}
+
+			var ret = SelectMutator(id, mutators);
+
+			if (Runtime.SHARE.replayJournal != null)
+				Runtime.SHARE.replayJournal.AddMutation(id.ModelName, id.ElementName, ret.name, Random.GetState());
+
+			return ret;
+		}
+
+		/// <summary>
+		/// Pick how many fields to mutate this iteration, between 1 and 'max' inclusive.
+		/// </summary>
+		protected virtual int SelectFieldCount(int max)
+		{
+			// Random.Next() Doesn't include max and we want it to
+			return Random.Next(1, max + 1);
+		}
+
+		/// <summary>
+		/// Pick 'count' of the recorded elements to mutate this iteration.
+		/// </summary>
+		protected virtual KeyValuePair<ElementId, List<Mutator>>[] SelectFields(Iterations iterations, int count)
+		{
+			return Random.Sample(iterations, count);
+		}
+
+		/// <summary>
+		/// Pick the mutator to apply to an element selected by SelectFields().
+		/// </summary>
+		protected virtual Mutator SelectMutator(ElementId id, List<Mutator> mutators)
+		{
+			return Random.Choice(mutators);
 		}
 
 		public override void Finalize(RunContext context, Engine engine)
@@ -467,7 +545,7 @@ namespace Peach.Core.MutationStrategies
 				var elem = dataModel.find(item.Key.ElementName);
 				if (elem != null)
 				{
-					Mutator mutator = Random.Choice(item.Value);
+					Mutator mutator = PickMutator(item.Key, item.Value);
 					OnMutating(item.Key.ElementName, mutator.name);
 					logger.Debug("Action_Starting: Fuzzing: " + item.Key.ElementName);
 					logger.Debug("Action_Starting: Mutator: " + mutator.name);
@@ -520,7 +598,7 @@ namespace Peach.Core.MutationStrategies
 				if (item.Key.ModelName != name)
 					continue;
 
-				Mutator mutator = Random.Choice(item.Value);
+				Mutator mutator = PickMutator(item.Key, item.Value);
 				OnMutating(state.name, mutator.name);
 
 				logger.Debug("MutateChangingState: Fuzzing state change: " + state.name);
@@ -195,6 +195,17 @@ namespace Peach.Core
 			return state;
 		}
 
+		/// <summary>
+		/// Allows mutation strategy to leave out an action.  Called for
+		/// every action whose 'when' expression allows it to run.
+		/// </summary>
+		/// <param name="action"></param>
+		/// <returns>True if the action should not be performed.</returns>
+		public virtual bool SkipAction(Dom.Action action)
+		{
+			return false;
+		}
+
 		/// <summary>
 		/// Call supportedDataElement method on Mutator type.
 		/// </summary>
@@ -0,0 +1,420 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+namespace Peach.Core
+{
+	/// <summary>
+	/// Parts of an iteration timed by the Profiler.
+	/// </summary>
+	public enum ProfilePhase
+	{
+		/// <summary>
+		/// Strategy picking and applying mutations
+		/// </summary>
+		Mutate,
+
+		/// <summary>
+		/// Generating the value of a data model, includes Fixup
+		/// </summary>
+		Render,
+
+		/// <summary>
+		/// Relations and fixups of an element
+		/// </summary>
+		Fixup,
+
+		/// <summary>
+		/// Publisher output
+		/// </summary>
+		Publish,
+
+		/// <summary>
+		/// Waiting for the target and reading the coverage map, includes
+		/// Settle, Poll, NewPath and Log
+		/// </summary>
+		Feedback,
+
+		/// <summary>
+		/// Fixed sleep after an output
+		/// </summary>
+		Settle,
+
+		/// <summary>
+		/// Polling termination_detection until the target is quiet
+		/// </summary>
+		Poll,
+
+		/// <summary>
+		/// newPath and count_branch walking the coverage map
+		/// </summary>
+		NewPath,
+
+		/// <summary>
+		/// Appending to the path, branch and watcher CSV files
+		/// </summary>
+		Log,
+
+		/// <summary>
+		/// Calls to the agents
+		/// </summary>
+		Agent,
+	}
+
+	/// <summary>
+	/// One timed phase, in Stopwatch ticks.
+	/// </summary>
+	public struct ProfileEvent
+	{
+		public ProfilePhase Phase;
+		public long Start;
+		public long End;
+	}
+
+	/// <summary>
+	/// Accumulates the time spent in each ProfilePhase.
+	/// </summary>
+	/// <remarks>
+	/// Phases are timed where they run, with Begin() and End().  While
+	/// disabled both only test a static flag.  Phases nest, the time of
+	/// Render includes the time of Fixup.  A phase entered again before
+	/// it ended, like the fixup of an element a relation renders, is only
+	/// counted once.
+	///
+	/// After StartTrace() every timed phase is also kept in a ring buffer
+	/// allocated up front, the oldest events are overwritten once it is
+	/// full.  WriteChromeTrace() and WriteFoldedStacks() export it for
+	/// chrome://tracing and flamegraph.pl.  The profiler is updated from
+	/// the engine thread only.  Another thread, like the Ctrl+C handler,
+	/// calls Stop() before it reads the results.
+	/// </remarks>
+	public static class Profiler
+	{
+		/// <summary>
+		/// Events kept by StartTrace() when no capacity is given.
+		/// </summary>
+		public const int DefaultCapacity = 1 << 18;
+
+		static readonly int Phases = Enum.GetValues(typeof(ProfilePhase)).Length;
+
+		static long[] _ticks = new long[Phases];
+		static long[] _counts = new long[Phases];
+		static int[] _depth = new int[Phases];
+
+		static ProfileEvent[] _events = null;
+		static int _next = 0;
+		static long _recorded = 0;
+		static long _epoch = 0;
+
+		static readonly object _lock = new object();
+
+		public static bool Enabled { get; set; }
+
+		/// <summary>
+		/// Start timing a phase.
+		/// </summary>
+		/// <returns>Returns the token to pass to End().</returns>
+		public static long Begin(ProfilePhase phase)
+		{
+			if (!Enabled)
+				return 0;
+
+			if (_depth[(int)phase]++ > 0)
+				return -1;
+
+			return Stopwatch.GetTimestamp();
+		}
+
+		public static void End(ProfilePhase phase, long start)
+		{
+			if (start == 0)
+				return;
+
+			if (--_depth[(int)phase] > 0 || start < 0)
+				return;
+
+			long end = Stopwatch.GetTimestamp();
+
+			lock (_lock)
+			{
+				// Stop() was called from another thread
+				if (!Enabled)
+					return;
+
+				_ticks[(int)phase] += end - start;
+				_counts[(int)phase]++;
+
+				if (_events == null)
+					return;
+
+				_events[_next].Phase = phase;
+				_events[_next].Start = start;
+				_events[_next].End = end;
+
+				if (++_next == _events.Length)
+					_next = 0;
+
+				_recorded++;
+			}
+		}
+
+		/// <summary>
+		/// Disable the profiler from any thread.  Once this returns the
+		/// totals and the ring buffer no longer change, so they can be
+		/// read while the engine is still running.
+		/// </summary>
+		public static void Stop()
+		{
+			lock (_lock)
+				Enabled = false;
+		}
+
+		/// <summary>
+		/// Forget the phases an exception left open, called by the engine
+		/// before each iteration.
+		/// </summary>
+		public static void BeginIteration()
+		{
+			if (Enabled)
+				Array.Clear(_depth, 0, _depth.Length);
+		}
+
+		public static TimeSpan Total(ProfilePhase phase)
+		{
+			return TimeSpan.FromSeconds((double)_ticks[(int)phase] / Stopwatch.Frequency);
+		}
+
+		/// <summary>
+		/// Number of times the phase ran.
+		/// </summary>
+		public static long Count(ProfilePhase phase)
+		{
+			return _counts[(int)phase];
+		}
+
+		public static void Reset()
+		{
+			Array.Clear(_ticks, 0, _ticks.Length);
+			Array.Clear(_counts, 0, _counts.Length);
+			Array.Clear(_depth, 0, _depth.Length);
+
+			_next = 0;
+			_recorded = 0;
+			_epoch = Stopwatch.GetTimestamp();
+		}
+
+		/// <summary>
+		/// Enable the profiler and keep the last 'capacity' events.
+		/// </summary>
+		public static void StartTrace(int capacity)
+		{
+			if (capacity <= 0)
+				throw new ArgumentOutOfRangeException("capacity");
+
+			_events = new ProfileEvent[capacity];
+			Reset();
+			Enabled = true;
+		}
+
+		/// <summary>
+		/// Disable the profiler and free the ring buffer.
+		/// </summary>
+		public static void StopTrace()
+		{
+			Stop();
+			_events = null;
+			_next = 0;
+			_recorded = 0;
+		}
+
+		public static bool Tracing
+		{
+			get { return _events != null; }
+		}
+
+		/// <summary>
+		/// Number of events overwritten because the ring buffer was full.
+		/// </summary>
+		public static long Dropped
+		{
+			get { return _events == null ? 0 : Math.Max(0, _recorded - _events.Length); }
+		}
+
+		/// <summary>
+		/// Events in the ring buffer, oldest first.
+		/// </summary>
+		public static IEnumerable<ProfileEvent> Events
+		{
+			get
+			{
+				if (_events == null)
+					yield break;
+
+				int count = (int)Math.Min(_recorded, _events.Length);
+				int first = count < _events.Length ? 0 : _next;
+
+				for (int i = 0; i < count; ++i)
+					yield return _events[(first + i) % _events.Length];
+			}
+		}
+
+		static double Microseconds(long ticks)
+		{
+			return ticks * 1000000.0 / Stopwatch.Frequency;
+		}
+
+		static string Name(ProfilePhase phase)
+		{
+			return phase.ToString().ToLower();
+		}
+
+		/// <summary>
+		/// Write the events in the Chrome trace event format.
+		/// </summary>
+		public static void WriteChromeTrace(TextWriter writer)
+		{
+			writer.Write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+			writer.Write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Peach\"}}");
+
+			foreach (var e in Events)
+			{
+				writer.Write(string.Format(CultureInfo.InvariantCulture,
+					",\n{{\"name\":\"{0}\",\"cat\":\"peach\",\"ph\":\"X\",\"ts\":{1:0.###},\"dur\":{2:0.###},\"pid\":1,\"tid\":1}}",
+					Name(e.Phase), Microseconds(e.Start - _epoch), Microseconds(e.End - e.Start)));
+			}
+
+			writer.WriteLine("]}");
+		}
+
+		static bool Contains(ProfileEvent outer, ProfileEvent inner)
+		{
+			return inner.Start < outer.End && inner.End <= outer.End;
+		}
+
+		/// <summary>
+		/// Write the events as collapsed stacks, one "outer;inner microseconds"
+		/// line per stack with the self time of its innermost phase.
+		/// </summary>
+		public static void WriteFoldedStacks(TextWriter writer)
+		{
+			var self = new Dictionary<string, long>();
+			var stack = new List<KeyValuePair<string, ProfileEvent>>();
+			var children = new List<long>();
+
+			// Outer phases start first, or at the same time and end last
+			var events = Events.OrderBy(e => e.Start).ThenByDescending(e => e.End);
+
+			// The sentinel after the last event pops the frames left
+			foreach (var e in events.Concat(new ProfileEvent[] { new ProfileEvent() { Start = long.MaxValue, End = long.MaxValue } }))
+			{
+				while (stack.Count > 0 && !Contains(stack[stack.Count - 1].Value, e))
+				{
+					int top = stack.Count - 1;
+					var frame = stack[top];
+					long ticks = frame.Value.End - frame.Value.Start - children[top];
+
+					long sum;
+					self.TryGetValue(frame.Key, out sum);
+					self[frame.Key] = sum + ticks;
+
+					stack.RemoveAt(top);
+					children.RemoveAt(top);
+				}
+
+				if (e.Start == long.MaxValue)
+					break;
+
+				string path = Name(e.Phase);
+				if (stack.Count > 0)
+				{
+					path = stack[stack.Count - 1].Key + ";" + path;
+					children[children.Count - 1] += e.End - e.Start;
+				}
+
+				stack.Add(new KeyValuePair<string, ProfileEvent>(path, e));
+				children.Add(0);
+			}
+
+			foreach (var kv in self.OrderBy(kv => kv.Key))
+			{
+				long us = (long)Microseconds(kv.Value);
+				if (us > 0)
+					writer.WriteLine("{0} {1}", kv.Key, us);
+			}
+		}
+
+		/// <summary>
+		/// Write the events to 'fileName', as collapsed stacks when it ends
+		/// with .folded and as a Chrome trace otherwise.
+		/// </summary>
+		public static void Save(string fileName)
+		{
+			using (var writer = new StreamWriter(fileName))
+			{
+				if (fileName.EndsWith(".folded", StringComparison.OrdinalIgnoreCase))
+					WriteFoldedStacks(writer);
+				else
+					WriteChromeTrace(writer);
+			}
+		}
+
+		/// <summary>
+		/// Time and count of every phase that ran, one line each.
+		/// </summary>
+		public static string Summary()
+		{
+			var sb = new StringBuilder();
+
+			foreach (ProfilePhase phase in Enum.GetValues(typeof(ProfilePhase)))
+			{
+				long count = Count(phase);
+				if (count == 0)
+					continue;
+
+				double ms = Total(phase).TotalMilliseconds;
+				sb.AppendFormat("  {0,-9} {1,12:0.000} ms {2,10} times {3,10:0.0} us avg",
+					Name(phase), ms, count, ms * 1000 / count);
+				sb.AppendLine();
+			}
+
+			if (Dropped > 0)
+				sb.AppendFormat("  {0} events were dropped, the trace only holds the last {1}.", Dropped, _events.Length).AppendLine();
+
+			return sb.ToString();
+		}
+	}
+}
+
+// end
@@ -201,6 +201,13 @@ namespace Peach.Core
 			throw new PeachException("Error, action 'input' not supported by publisher");
 		}
 
+		/// <summary>
+		/// Send any outputs queued while batching.
+		/// </summary>
+		protected virtual void OnFlush()
+		{
+		}
+
 		#endregion
 
 		#region Ctor
@@ -281,6 +288,21 @@ namespace Peach.Core
 				return;
 
 			Logger.Debug("close()");
+
+			// Outputs left queued by a run of actions that was cut short,
+			// by an exception or a state change, still go out
+			if (IsBatching)
+			{
+				try
+				{
+					flush();
+				}
+				catch (Exception ex)
+				{
+					Logger.Warn("Unable to send queued output on close. {0}", ex.Message);
+				}
+			}
+
 			OnClose();
 
 			_isOpen = false;
@@ -294,6 +316,9 @@ namespace Peach.Core
 		/// <returns>Returns resulting data</returns>
 		public Variant call(string method, List<ActionParameter> args)
 		{
+			if (IsBatching)
+				flush();
+
 			Logger.Debug("call({0}, {1})", method, args);
 			return OnCall(method, args);
 		}
@@ -337,10 +362,35 @@ namespace Peach.Core
 		/// </summary>
 		public void input()
 		{
+			if (IsBatching)
+				flush();
+
 			Logger.Debug("input()");
 			OnInput();
 		}
 
+		/// <summary>
+		/// When true, output() only queues data and nothing is sent
+		/// until flush() is called.  The Output actions of a state
+		/// are flushed together at the end of each consecutive run.
+		/// </summary>
+		public virtual bool IsBatching
+		{
+			get { return false; }
+		}
+
+		/// <summary>
+		/// Send everything queued by output() while batching.
+		/// </summary>
+		public void flush()
+		{
+			if (!_isOpen)
+				return;
+
+			Logger.Debug("flush()");
+			OnFlush();
+		}
+
 		/// <summary>
 		/// Blocking stream based publishers override this to wait
 		/// for a certian amount of bytes to be available for reading.
@@ -3,6 +3,8 @@ using System.Collections.Generic;
 using System.IO;
 using System.Threading;
 
+using Peach.Core.IO;
+
 namespace Peach.Core.Publishers
 {
 	/// <summary>
@@ -13,6 +15,10 @@ namespace Peach.Core.Publishers
 	/// Most derived classes should only need to override OnOpen()
 	/// and in the implementation open _client and call StartClient()
 	/// to begin async reads from _client to _buffer.
+	/// 
+	/// Received data is kept in a ring buffer that only holds the
+	/// bytes not yet consumed by a previous input action.  Readers
+	/// blocked in WantBytes() are woken as soon as data arrives.
 	/// </summary>
 	public abstract class BufferedStreamPublisher : Publisher
 	{
@@ -24,7 +30,7 @@ namespace Peach.Core.Publishers
 		protected string _clientName = null;
 		protected ManualResetEvent _event = null;
 		protected Stream _client = null;
-		protected MemoryStream _buffer = null;
+		protected RingStream _buffer = null;
 		protected bool _timeout = false;
 
 		public BufferedStreamPublisher(Dictionary<string, Variant> args)
@@ -84,6 +90,9 @@ namespace Peach.Core.Publishers
 
 							if (Logger.IsDebugEnabled)
 								Logger.Debug("\n\n" + Utilities.HexDump(_buffer));
+
+							// Wake up anyone blocked in WantBytes()
+							Monitor.PulseAll(_bufferLock);
 						}
 
 						ScheduleRead();
@@ -107,7 +116,7 @@ namespace Peach.Core.Publishers
 			System.Diagnostics.Debug.Assert(_client != null);
 			System.Diagnostics.Debug.Assert(_buffer == null);
 
-			_buffer = new MemoryStream();
+			_buffer = new RingStream();
 			_event.Reset();
 			ScheduleRead();
 		}
@@ -123,6 +132,12 @@ namespace Peach.Core.Publishers
 				_client = null;
 				_clientName = null;
 				_event.Set();
+
+				// No more data is coming, release anyone blocked in WantBytes()
+				lock (_bufferLock)
+				{
+					Monitor.PulseAll(_bufferLock);
+				}
 			}
 		}
 
@@ -216,6 +231,14 @@ namespace Peach.Core.Publishers
 
 		protected override void OnInput()
 		{
+			// Data consumed by previous input actions will never be
+			// read again, release it so the buffer only holds new data.
+			lock (_bufferLock)
+			{
+				if (_buffer != null)
+					_buffer.Discard(_buffer.Position);
+			}
+
 			// Try to make sure 1 byte is available for reading.  Without doing this,
 			// state models with an initial state of input can miss the message.
 			WantBytes(1);
@@ -248,33 +271,30 @@ namespace Peach.Core.Publishers
 			if (count == 0)
 				return;
 
-			lock (_clientLock)
-			{
-				// If the connection has been closed, we are not going to get anymore bytes.
-				if (_client == null)
-					return;
-
-				// If we have already timed out, 
-			}
-
-			DateTime start = DateTime.Now;
+			int expires = Environment.TickCount + Timeout;
 
-			// Wait up to Timeout milliseconds to see if count bytes become available
-			while (true)
+			// Wait up to Timeout milliseconds to see if count bytes become available.
+			// OnReadComplete() and CloseClient() pulse _bufferLock when this changes.
+			lock (_bufferLock)
 			{
-				lock (_bufferLock)
+				while (true)
 				{
 					if ((_buffer.Length - _buffer.Position) >= count || _timeout)
 						return;
 
-					if ((DateTime.Now - start) >= TimeSpan.FromMilliseconds(Timeout))
+					// If the connection has been closed, we are not going to get anymore bytes.
+					if (_client == null)
+						return;
+
+					int remain = expires - Environment.TickCount;
+					if (remain <= 0)
 					{
 						_timeout = true;
 						return;
 					}
-				}
 
-				Thread.Sleep(100);
+					Monitor.Wait(_bufferLock, remain);
+				}
 			}
 		}
 
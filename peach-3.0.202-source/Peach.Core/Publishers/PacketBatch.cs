@@ -0,0 +1,89 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using Peach.Core.IO;
+
+namespace Peach.Core.Publishers
+{
+	/// <summary>
+	/// Packets queued by a batching publisher until the next flush.
+	/// </summary>
+	/// <remarks>
+	/// The caller's buffer is reused for every action, so each packet
+	/// is copied into a buffer rented from BufferPool.  Clear() hands
+	/// the buffers back to the pool.
+	/// </remarks>
+	public class PacketBatch
+	{
+		List<ArraySegment<byte>> _packets = new List<ArraySegment<byte>>();
+
+		/// <summary>
+		/// Number of queued packets.
+		/// </summary>
+		public int Count
+		{
+			get { return _packets.Count; }
+		}
+
+		/// <summary>
+		/// Queued packets, in the order they were added.
+		/// </summary>
+		public IList<ArraySegment<byte>> Packets
+		{
+			get { return _packets; }
+		}
+
+		/// <summary>
+		/// Queue a copy of 'count' bytes of 'buffer' starting at 'offset'.
+		/// </summary>
+		public ArraySegment<byte> Add(byte[] buffer, int offset, int count)
+		{
+			var buf = BufferPool.Rent(count);
+			Buffer.BlockCopy(buffer, offset, buf, 0, count);
+
+			var seg = new ArraySegment<byte>(buf, 0, count);
+			_packets.Add(seg);
+			return seg;
+		}
+
+		/// <summary>
+		/// Drop all queued packets.
+		/// </summary>
+		public void Clear()
+		{
+			foreach (var seg in _packets)
+				BufferPool.Return(seg.Array);
+
+			_packets.Clear();
+		}
+	}
+}
+
+// end
@@ -76,6 +76,7 @@ namespace Peach.Core.Publishers
 	[Parameter("Timeout", typeof(int), "How many milliseconds to wait for data/connection (default 3000)", "3000")]
 	[Parameter("MinMTU", typeof(uint), "Minimum allowable MTU property value", DefaultMinMTU)]
 	[Parameter("MaxMTU", typeof(uint), "Maximum allowable MTU property value", DefaultMaxMTU)]
+	[Parameter("Batch", typeof(bool), "Queue consecutive outputs and send them together (default false)", "false")]
 	public class RawV4Publisher : SocketPublisher
 	{
 		private static NLog.Logger logger = LogManager.GetCurrentClassLogger();
@@ -128,6 +129,7 @@ namespace Peach.Core.Publishers
 	[Parameter("Timeout", typeof(int), "How many milliseconds to wait for data/connection (default 3000)", "3000")]
 	[Parameter("MinMTU", typeof(uint), "Minimum allowable MTU property value", DefaultMinMTU)]
 	[Parameter("MaxMTU", typeof(uint), "Maximum allowable MTU property value", DefaultMaxMTU)]
+	[Parameter("Batch", typeof(bool), "Queue consecutive outputs and send them together (default false)", "false")]
 	public class RawIPv4Publisher : SocketPublisher
 	{
 		private static NLog.Logger logger = LogManager.GetCurrentClassLogger();
@@ -87,6 +87,7 @@ namespace Peach.Core.Publishers
 		public int Timeout { get; set; }
 		public uint MinMTU { get; set; }
 		public uint MaxMTU { get; set; }
+		public bool Batch { get; set; }
 
 		public static int MaxSendSize = 65000;
 
@@ -101,6 +102,7 @@ namespace Peach.Core.Publishers
 		private MemoryStream _recvBuffer = null;
 		private uint? _origMtu = null;
 		private uint? _mtu = null;
+		private PacketBatch _batch = new PacketBatch();
 
 		protected abstract bool AddressFamilySupported(AddressFamily af);
 
@@ -654,10 +656,47 @@ namespace Peach.Core.Publishers
 			}
 		}
 
+		public override bool IsBatching
+		{
+			get { return Batch; }
+		}
+
 		protected override void OnOutput(byte[] buffer, int offset, int count)
 		{
 			System.Diagnostics.Debug.Assert(_socket != null);
 
+			if (Logger.IsDebugEnabled)
+				Logger.Debug("\n\n" + Utilities.HexDump(buffer, offset, count));
+
+			// Queued packets are filtered when they are sent
+			if (Batch)
+			{
+				_batch.Add(buffer, offset, count);
+				return;
+			}
+
+			SendPacket(buffer, offset, count);
+		}
+
+		protected override void OnFlush()
+		{
+			System.Diagnostics.Debug.Assert(_socket != null);
+
+			// Send the queued packets back to back so the target
+			// sees the burst with the same spacing as the pit intends
+			try
+			{
+				foreach (var seg in _batch.Packets)
+					SendPacket(seg.Array, seg.Offset, seg.Count);
+			}
+			finally
+			{
+				_batch.Clear();
+			}
+		}
+
+		private void SendPacket(byte[] buffer, int offset, int count)
+		{
 			int size = count;
 
 			if (size > MaxSendSize)
@@ -666,9 +705,6 @@ namespace Peach.Core.Publishers
 				size = MaxSendSize;
 			}
 
-			if (Logger.IsDebugEnabled)
-				Logger.Debug("\n\n" + Utilities.HexDump(buffer, offset, count));
-
 			try
 			{
 				FilterOutput(buffer, offset, count);
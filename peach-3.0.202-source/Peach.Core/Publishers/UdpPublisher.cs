@@ -17,6 +17,7 @@ namespace Peach.Core.Publishers
 	[Parameter("SrcPort", typeof(ushort), "Source port number", "0")]
 	[Parameter("MinMTU", typeof(uint), "Minimum allowable MTU property value", DefaultMinMTU)]
 	[Parameter("MaxMTU", typeof(uint), "Maximum allowable MTU property value", DefaultMaxMTU)]
+	[Parameter("Batch", typeof(bool), "Queue consecutive outputs and send them together (default false)", "false")]
 	public class UdpPublisher : SocketPublisher
 	{
 		private static NLog.Logger logger = LogManager.GetCurrentClassLogger();
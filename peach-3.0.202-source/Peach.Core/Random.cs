@@ -23,6 +23,19 @@ namespace Peach.Core
 			get { return _seed; }
 		}
 
+		/// <summary>
+		/// Position in the sequence, restore it with SetState().
+		/// </summary>
+		public uint[] GetState()
+		{
+			return _prng.GetState();
+		}
+
+		public void SetState(uint[] state)
+		{
+			_prng.SetState(state);
+		}
+
 		// 0 <= X < max
 		public int Next(int max)
 		{
@@ -86,6 +99,12 @@ namespace Peach.Core
 
 			return (ulong)(_prng.Sample() * diff) + min;
 		}
+		// 0 <= X < 1
+		public double NextDouble()
+		{
+			return _prng.Sample();
+		}
+
 		// int.MinValue <= X <= int.MaxValue
 		public int NextInt32()
 		{
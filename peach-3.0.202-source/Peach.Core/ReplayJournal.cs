@@ -0,0 +1,273 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using Peach.Core.Runtime;
+
+namespace Peach.Core
+{
+	/// <summary>
+	/// Where the splice source of an iteration came from, see
+	/// DataElement.FeilongGetMutatedValue().
+	/// </summary>
+	public enum ReplaySource : byte
+	{
+		None = 0,
+		Queue = 1,
+		Pool = 2,
+	}
+
+	/// <summary>
+	/// One mutation applied by the strategy, with the state of the
+	/// strategy's random generator right before the mutator ran.
+	/// </summary>
+	public class ReplayMutation
+	{
+		public string Model;
+
+		/// <summary>
+		/// Null for a state change, see RandomStrategy.MutateChangingState().
+		/// </summary>
+		public string Element;
+		public string Mutator;
+		public uint[] State;
+	}
+
+	/// <summary>
+	/// Everything needed to generate the input of one iteration again.
+	/// </summary>
+	public class ReplayRecord
+	{
+		public uint Iteration;
+		public uint SubIteration;
+		public ReplaySource Source;
+
+		/// <summary>
+		/// Seed pool index for Pool, queue entry index for Queue.
+		/// </summary>
+		public int Head;
+
+		public List<ReplayMutation> Mutations = new List<ReplayMutation>();
+
+		public ReplayMutation Find(string model, string element)
+		{
+			return Mutations.FirstOrDefault(m => m.Model == model && m.Element == element);
+		}
+
+		internal void Write(BinaryWriter writer)
+		{
+			writer.Write(Iteration);
+			writer.Write(SubIteration);
+			writer.Write((byte)Source);
+			writer.Write(Head);
+			writer.Write(Mutations.Count);
+
+			foreach (var m in Mutations)
+			{
+				writer.Write(m.Model);
+				writer.Write(m.Element ?? "");
+				writer.Write(m.Mutator);
+				writer.Write((byte)m.State.Length);
+				foreach (var x in m.State)
+					writer.Write(x);
+			}
+		}
+
+		internal static ReplayRecord Read(BinaryReader reader)
+		{
+			var ret = new ReplayRecord();
+			ret.Iteration = reader.ReadUInt32();
+			ret.SubIteration = reader.ReadUInt32();
+			ret.Source = (ReplaySource)reader.ReadByte();
+			ret.Head = reader.ReadInt32();
+
+			int count = reader.ReadInt32();
+			for (int i = 0; i < count; ++i)
+			{
+				var m = new ReplayMutation();
+				m.Model = reader.ReadString();
+				m.Element = reader.ReadString();
+				if (m.Element.Length == 0)
+					m.Element = null;
+				m.Mutator = reader.ReadString();
+				m.State = new uint[reader.ReadByte()];
+				for (int j = 0; j < m.State.Length; ++j)
+					m.State[j] = reader.ReadUInt32();
+				ret.Mutations.Add(m);
+			}
+
+			return ret;
+		}
+	}
+
+	/// <summary>
+	/// Append only log of a ReplayRecord per iteration.
+	/// </summary>
+	/// <remarks>
+	/// A fault folder stores the offset of its record in RefFile, so -repro
+	/// can rebuild the faulting input from the record, the splice source
+	/// it names and the random state of each mutation instead of running
+	/// every iteration since the last checkpoint against the target.
+	/// </remarks>
+	public class ReplayJournal : IDisposable
+	{
+		public const string FileName = "replay.bin";
+		public const string RefFile = "replay.txt";
+
+		/// <summary>
+		/// Folder of the run holding the queue entries a record can name.
+		/// </summary>
+		public const string QueueFolder = "queue";
+
+		const uint Magic = 0x4c505250; // "RPPL"
+		const uint Version = 1;
+
+		BinaryWriter _writer;
+		ReplayRecord _pending;
+		long _last = -1;
+
+		public ReplayJournal(string fileName, uint seed)
+		{
+			_writer = new BinaryWriter(new FileStream(fileName, FileMode.Create, FileAccess.Write, FileShare.Read, 64 * 1024));
+			_writer.Write(Magic);
+			_writer.Write(Version);
+			_writer.Write(seed);
+		}
+
+		/// <summary>
+		/// Start the record of an iteration, the splice source is taken
+		/// from the PeachStar queues as they stand.
+		/// </summary>
+		public void Begin(uint iteration, uint subIteration)
+		{
+			Commit();
+
+			_pending = new ReplayRecord();
+			_pending.Iteration = iteration;
+			_pending.SubIteration = subIteration;
+
+			// Same precedence as DataElement.FeilongGetMutatedValue()
+			if (SHARE.seed_pool_to_use_cnt != 0 && SHARE.seedPoolIndexQueue.Count != 0)
+			{
+				_pending.Source = ReplaySource.Pool;
+				_pending.Head = SHARE.seedPoolIndexQueue.Peek();
+			}
+			else if (SHARE.queueLengthBeforeIteration != 0 && SHARE.dataModelsToMutateIndex.Count != 0)
+			{
+				_pending.Source = ReplaySource.Queue;
+				_pending.Head = SHARE.dataModelsToMutateIndex.Peek();
+			}
+		}
+
+		public void AddMutation(string model, string element, string mutator, uint[] state)
+		{
+			if (_pending == null)
+				return;
+
+			_pending.Mutations.Add(new ReplayMutation()
+			{
+				Model = model,
+				Element = element,
+				Mutator = mutator,
+				State = state,
+			});
+		}
+
+		/// <summary>
+		/// Write the pending record.
+		/// </summary>
+		/// <returns>Returns the offset of the last record written, -1 if none.</returns>
+		public long Commit()
+		{
+			if (_pending != null)
+			{
+				_last = _writer.BaseStream.Position;
+				_pending.Write(_writer);
+				_pending = null;
+			}
+
+			return _last;
+		}
+
+		public void Flush()
+		{
+			_writer.Flush();
+		}
+
+		public void Dispose()
+		{
+			if (_writer == null)
+				return;
+
+			Commit();
+			_writer.Close();
+			_writer = null;
+		}
+
+		static BinaryReader Open(string fileName, out uint seed)
+		{
+			var reader = new BinaryReader(File.OpenRead(fileName));
+
+			if (reader.ReadUInt32() != Magic || reader.ReadUInt32() != Version)
+			{
+				reader.Close();
+				throw new PeachException("Error, '" + fileName + "' is not a replay journal.");
+			}
+
+			seed = reader.ReadUInt32();
+			return reader;
+		}
+
+		/// <summary>
+		/// Random seed of the run that wrote the journal.
+		/// </summary>
+		public static uint ReadSeed(string fileName)
+		{
+			uint seed;
+			using (var reader = Open(fileName, out seed))
+				return seed;
+		}
+
+		public static ReplayRecord Read(string fileName, long offset)
+		{
+			uint seed;
+			using (var reader = Open(fileName, out seed))
+			{
+				reader.BaseStream.Seek(offset, SeekOrigin.Begin);
+				return ReplayRecord.Read(reader);
+			}
+		}
+	}
+}
+
+// end
@@ -112,6 +112,16 @@ namespace Peach.Core
 		[NonSerialized]
 		public Dictionary<string, object> iterationStateStore = new Dictionary<string, object>();
 
+		/// <summary>
+		/// Per-action wait time calibration.  Null unless the test
+		/// enables adaptiveWaitTime.
+		/// </summary>
+		/// <remarks>
+		/// Currently the Engine code sets this.
+		/// </remarks>
+		[NonSerialized]
+		public WaitTimeCalibrator waitTimeCalibrator = null;
+
 		#region Control Iterations
 
 		/// <summary>
@@ -34,17 +34,44 @@ using System.Diagnostics;
 
 using Peach.Core;
 using Peach.Core.Agent;
+using Peach.Core.Loggers;
 
 using NLog;
 
 namespace Peach.Core.Runtime
 {
+	/// <summary>
+	/// Console output of a fuzzing run.
+	/// </summary>
+	/// <remarks>
+	/// Every StatusInterval a status block is printed with the execution
+	/// speed, the coverage, the PeachStar queue and seed pool and the
+	/// faults found so far.  The block is rendered from counters kept by
+	/// the engine and SHARE, nothing is written between two blocks.
+	/// </remarks>
 	public class ConsoleWatcher : Watcher
 	{
 		Stopwatch timer = new Stopwatch();
 		uint startIteration = 0;
 		bool reproducing = false;
 
+		long execs = 0;
+		long lastExecs = 0;
+		long lastStatus = 0;
+		int faults = 0;
+		HashSet<string> stacks = new HashSet<string>();
+
+		public ConsoleWatcher()
+		{
+			StatusInterval = TimeSpan.FromSeconds(5);
+		}
+
+		/// <summary>
+		/// Time between two status blocks.  Zero prints a line per iteration
+		/// and the mutators used, like Peach does.
+		/// </summary>
+		public TimeSpan StatusInterval { get; set; }
+
 		protected override void Engine_ReproFault(RunContext context, uint currentIteration, Peach.Core.Dom.StateModel stateModel, Fault [] faultData)
 		{
 			var color = Console.ForegroundColor;
@@ -71,6 +98,15 @@ namespace Peach.Core.Runtime
 				reproducing ? "Reproduced" : "Caught"));
 			Console.ForegroundColor = color;
 			reproducing = false;
+
+			foreach (var fault in faultData)
+			{
+				if (fault.type != FaultType.Fault)
+					continue;
+
+				faults++;
+				stacks.Add(FaultBuckets.StackHash(fault));
+			}
 		}
 
 		protected override void Engine_HaveCount(RunContext context, uint totalIterations)
@@ -105,6 +141,7 @@ namespace Peach.Core.Runtime
 			string strTotal = "-";
 			string strEta = "-";
 
+			++execs;
 
 			if (!timer.IsRunning)
 			{
@@ -133,6 +170,14 @@ namespace Peach.Core.Runtime
 				strEta = remain.ToString("g");
 			}
 
+			if (StatusInterval > TimeSpan.Zero)
+			{
+				long now = timer.ElapsedMilliseconds;
+				if (execs == 1 || now - lastStatus >= StatusInterval.TotalMilliseconds)
+					WriteStatus(string.Format("{0}{1}.{2},{3},{4}", controlIteration, currentIteration, currentSubIteration, strTotal, strEta), now);
+
+				return;
+			}
 
 			var color = Console.ForegroundColor;
 			Console.ForegroundColor = ConsoleColor.DarkGray;
@@ -174,12 +219,68 @@ namespace Peach.Core.Runtime
 
 		protected override void MutationStrategy_Mutating(string elementName, string mutatorName)
 		{
+			if (StatusInterval > TimeSpan.Zero)
+				return;
+
 			WriteInfoMark();
 			Console.WriteLine("Fuzzing: {0}", elementName);
 			WriteInfoMark();
 			Console.WriteLine("Mutator: {0}", mutatorName);
 		}
 
+		void WriteStatus(string iteration, long now)
+		{
+			double seconds = (now - lastStatus) / 1000.0;
+			double speed = seconds > 0 ? (execs - lastExecs) / seconds : 0;
+			double average = now > 0 ? execs * 1000.0 / now : 0;
+
+			lastStatus = now;
+			lastExecs = execs;
+
+			var color = Console.ForegroundColor;
+			Console.ForegroundColor = ConsoleColor.DarkGray;
+			Console.Write("\n[");
+			Console.ForegroundColor = ConsoleColor.Gray;
+			Console.Write(iteration);
+			Console.ForegroundColor = ConsoleColor.DarkGray;
+			Console.Write("] ");
+			Console.ForegroundColor = ConsoleColor.DarkGreen;
+			Console.WriteLine("Status");
+			Console.ForegroundColor = color;
+
+			WriteStatusLine("run time", "{0}, {1} execs, {2:0.0}/sec ({3:0.0}/sec average)",
+				FormatTime(TimeSpan.FromMilliseconds(now)), execs, speed, average);
+
+			if (SHARE.ifuse)
+			{
+				int edges = Dom.Action.count_edges();
+				WriteStatusLine("coverage", "{0} paths, {1} edges, {2:0.00}% map density",
+					SHARE.cur_path, edges, edges * 100.0 / Dom.Action.MapSize);
+				WriteStatusLine("last path", SHARE.cur_path == 0 ? "none yet" :
+					FormatTime(DateTime.Now - SHARE.last_path_time) + " ago");
+
+				var pool = SHARE.valuableDataModels;
+				WriteStatusLine("queue", "{0} queued, {1} in seed pool ({2} in memory, {3:0.0}% read back)",
+					SHARE.dataModelsToMutate.Count, pool.Count, pool.Resident, pool.ReloadRate * 100);
+			}
+
+			WriteStatusLine("faults", "{0} in {1} unique stacks", faults, stacks.Count);
+		}
+
+		static void WriteStatusLine(string name, string format, params object[] args)
+		{
+			var color = Console.ForegroundColor;
+			Console.ForegroundColor = ConsoleColor.DarkGray;
+			Console.Write("  {0,-10} ", name);
+			Console.ForegroundColor = color;
+			Console.WriteLine(format, args);
+		}
+
+		static string FormatTime(TimeSpan time)
+		{
+			return string.Format("{0}:{1:00}:{2:00}", (int)time.TotalHours, time.Minutes, time.Seconds);
+		}
+
 		public static void WriteInfoMark()
 		{
 			var foregroundColor = Console.ForegroundColor;
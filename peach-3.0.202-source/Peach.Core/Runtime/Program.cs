@@ -28,6 +28,7 @@
 
 using System;
 using System.Collections.Generic;
+using System.Linq;
 using System.Text;
 using System.Reflection;
 using System.IO;
@@ -65,8 +66,11 @@ namespace Peach.Core.Runtime
 		public static string pathSrc = @"/tmp/peachPath";
 		public static string pathWather = @"/tmp/peachWather";
 		public static string pathAsanReport = @"/tmp/";		// Directory to save ASAN report
+		public static bool keepAsanReports = false;		// -asanLog given, keep a copy of every report
 		public static Queue<DataModel> dataModelsToMutate = new Queue<DataModel>();
-		public static Queue<DataModel> valuableDataModels = new Queue<DataModel>();
+		public static Queue<int> dataModelsToMutateIndex = new Queue<int>();	// id of each dataModelsToMutate entry
+		public static int queueEntryIndex = 0;
+		public static SeedPool valuableDataModels = new SeedPool(64L * 1024 * 1024);	// 种子池, 超出内存预算的种子落盘, 见SeedPool
 		public static int queueLengthBeforeIteration = 0;
 
 		public static int seed_pool_to_use_cnt = 0; 	// in this iteration, number of seeds to use in seed pool
@@ -110,29 +114,108 @@ namespace Peach.Core.Runtime
 
 		public static int peachStarRepoStartIteration;
 
+		//--seedpool给出的种子池, 复现时找不到的种子也从这里读
+		public static string seedPoolResume = null;
+
+		//每个iteration的变异记录, 见ReplayJournal
+		public static ReplayJournal replayJournal = null;
+
+		//-repro按记录重放时要复现的iteration和它拼接的DataModel
+		public static ReplayRecord replayRecord = null;
+		public static Queue<DataModel> replayHead = null;
+
+		//种子池和队列的存储, 见SeedStore. 由FileLogger在每个test开始时关闭
+		public static SeedStore seedStore = null;
+		public static SeedStore queueStore = null;
+
+		public static void ResetSplicing(){
+
+			//清空等待拼接的队列和种子池, 之后的iteration只发送自己的数据
+			dataModelsToMutate.Clear();
+			dataModelsToMutateIndex.Clear();
+			valuableDataModels.Clear();
+			seedPoolIndexQueue.Clear();
+			queueLengthBeforeIteration = 0;
+			seed_pool_to_use_cnt = 0;
+			has_new_path = false;
+			has_new_path_branch = false;
+			has_new_path_iteration = false;
+			if_replace_just_now = false;
+			replayRecord = null;
+			replayHead = null;
+		}
+
+		public static int saveQueueEntryToFile(DataModel dataModel, int index, Peach.Core.Loggers.FileLogger logger){
+
+			//保存队列中的DataModel, 重放时按id读回
+			if (queueStore == null)
+				queueStore = new SeedStore(logger.OurPath + "/" + ReplayJournal.QueueFolder, false);
+			queueStore.Add(index, dataModel);
+
+			return 0;
+		}
+
+		public static DataModel readDataModelFromFile(string filepath){
+			FileStream fs = new FileStream (filepath, FileMode.Open);
+			BinaryFormatter bf = new BinaryFormatter ();
+			DataModel dataModel = bf.Deserialize(fs) as DataModel;
+			fs.Close();
+			return dataModel;
+		}
+
+		public static Dictionary<int, DataModel> readSeedsFromFolder(string folder, IEnumerable<int> indexes){
+			//新的run使用SeedStore, 旧的run每个种子一个.bin
+			if (SeedStore.Exists(folder)){
+				using (var store = new SeedStore(folder, true))
+					return store.ReadAll(indexes);
+			}
+
+			var ret = new Dictionary<int, DataModel>();
+			foreach (int index in indexes){
+				string path = folder + "/" + index.ToString() + ".bin";
+				if (File.Exists(path))
+					ret[index] = readDataModelFromFile(path);
+			}
+			return ret;
+		}
+
+		public static DataModel readSeedFromFolder(string folder, int index){
+			DataModel ret;
+			readSeedsFromFolder(folder, new int[] { index }).TryGetValue(index, out ret);
+			return ret;
+		}
+
 		public static int saveNewSeedToFile(DataModel dataModel,Peach.Core.Loggers.FileLogger logger){
 			
 			//保存新的Seed(valuableDataModel)进入文件系统
-			Peach.Core.Loggers.FileLogger fileLogger = logger; 
-			string seedPoolPath = fileLogger.OurPath + "/seedpool";
-			Console.WriteLine("feilong:seedPoolPath:{0}",seedPoolPath);
+			if (seedStore == null)
+				seedStore = new SeedStore(logger.OurPath + "/seedpool", false);
+			seedStore.Add(Peach.Core.Runtime.SHARE.seedPoolIndex, dataModel);
+
+			return 0;
+		}
+
+		public static int saveInfluenceMapToFile(InfluenceMap map, Peach.Core.Loggers.FileLogger logger){
+
+			//保存字段影响表到种子池目录
+			string seedPoolPath = logger.OurPath + "/seedpool";
 			if (!Directory.Exists(seedPoolPath))
 				Directory.CreateDirectory(seedPoolPath);
-			string seedFilePath = seedPoolPath + "/" + Peach.Core.Runtime.SHARE.seedPoolIndex + ".bin";
-			FileStream fs = new FileStream (seedFilePath, FileMode.Create);
-			BinaryFormatter bf = new BinaryFormatter ();
-			bf.Serialize (fs, dataModel);
-			fs.Close ();
+			map.Save(seedPoolPath + "/influence.bin");
 
 			return 0;
 		}
 
 		public static int saveSeedQueueIndexToFile(string path){
+			return saveSeedQueueIndexToFile(path, seedPoolIndexQueueCopy);
+		}
+
+		public static int saveSeedQueueIndexToFile(string path, Queue<int> indexQueue){
 			
 			string filepath = path + "/seedPoolIndex.bin";
 			FileStream fs = new FileStream (filepath, FileMode.Create);
 			BinaryFormatter bf = new BinaryFormatter ();
-			bf.Serialize (fs, seedPoolIndexQueueCopy);
+			bf.Serialize (fs, indexQueue);
 			fs.Close ();
 
 			return 0;			
@@ -150,18 +233,24 @@ namespace Peach.Core.Runtime
 
 			seedPoolIndexQueueCopy = new Queue<int>(seedPoolIndexQueue);
 
-			valuableDataModels = new Queue<DataModel>();
+			valuableDataModels.Clear();
+
+			//一次读出所有种子, 找不到的再从--seedpool读
+			var seeds = readSeedsFromFolder(filepath, seedPoolIndexQueue);
+			var missing = seedPoolIndexQueue.Where(i => !seeds.ContainsKey(i)).ToList();
+			if (missing.Count != 0 && seedPoolResume != null){
+				foreach (var kv in readSeedsFromFolder(seedPoolResume, missing))
+					seeds[kv.Key] = kv.Value;
+			}
 
 			while(seedPoolIndexQueueCopy.Count!=0){
 				int thisIndex = seedPoolIndexQueueCopy.Peek();
 				seedPoolIndexQueueCopy.Dequeue();
 
-				string thisSeedPath = filepath + "/" + thisIndex.ToString() + ".bin";
-				FileStream newfs = new FileStream (thisSeedPath, FileMode.Open);
-				BinaryFormatter newbf = new BinaryFormatter ();
-				DataModel dataModel = newbf.Deserialize(newfs) as DataModel;
-				newfs.Close();
-				valuableDataModels.Enqueue(dataModel);
+				DataModel dataModel;
+				if (!seeds.TryGetValue(thisIndex, out dataModel))
+					throw new PeachException("Error, unable to find seed " + thisIndex + " in '" + filepath + "'.");
+				valuableDataModels.Enqueue(thisIndex, dataModel);
 			}
 
 			seedPoolIndexQueueCopy = new Queue<int>(seedPoolIndexQueue);
@@ -189,6 +278,16 @@ namespace Peach.Core.Runtime
 
 		public int exitCode = 1;
 
+		/// <summary>
+		/// Seconds between two status blocks of the ConsoleWatcher
+		/// </summary>
+		protected int statusInterval = 5;
+
+		/// <summary>
+		/// Where --profile saves the phase trace, null when not profiling
+		/// </summary>
+		protected static string profileFile = null;
+
 		/// <summary>
 		/// Copyright message
 		/// </summary>
@@ -213,12 +312,15 @@ namespace Peach.Core.Runtime
 		//feilong:调用control.o
 		[DllImport(@"peachControl", EntryPoint="feilong_read")]   
         public static unsafe extern int feilong_read(char[] path, ref int iteration);
+		[DllImport(@"peachControl", EntryPoint="ckpt_read")]
+		public static extern int ckpt_read(string path, uint generation, ref int iteration);
 		[DllImport(@"peachControl", EntryPoint="init")]   
 		public static unsafe extern int init();
 
 		public Program(string[] args)
 		{
 			AppDomain.CurrentDomain.DomainUnload += new EventHandler(CurrentDomain_DomainUnload);
+			AppDomain.CurrentDomain.ProcessExit += new EventHandler(CurrentDomain_DomainUnload);
 			Console.CancelKeyPress += new ConsoleCancelEventHandler(Console_CancelKeyPress);
 			RunConfiguration config = new RunConfiguration();
 			config.debug = false;
@@ -230,6 +332,15 @@ namespace Peach.Core.Runtime
 				string agent = null;
 				var definedValues = new List<string>();
 				bool parseOnly = false;
+				string tmin = null;
+				int tminJobs = 1;
+				bool tminCoverage = false;
+				int tminWorker = -1;
+				string minset = null;
+				string minsetOut = null;
+				int minsetJobs = 1;
+				int minsetWorker = -1;
+				bool trace = false;
 
 				var color = Console.ForegroundColor;
 				Console.Write("\n");
@@ -252,6 +363,9 @@ namespace Peach.Core.Runtime
 					{ "h|?|help", v => Syntax() },
 					{ "analyzer=", v => analyzer = v },
 					{ "debug", v => config.debug = true },
+					{ "trace", v => { config.debug = true; trace = true; } },
+					{ "status=", v => statusInterval = Convert.ToInt32(v) },
+					{ "profile=", v => profileFile = v },
 					{ "1", v => config.singleIteration = true},
 					{ "range=", v => ParseRange(config, v)},
 					{ "t|test", v => test = true},
@@ -270,10 +384,20 @@ namespace Peach.Core.Runtime
 					{ "pro", v => SHARE.ifuse = true },
 					{ "pathp=", v => SHARE.pathSrc = v },
 					{ "salva=", v => SHARE.seed_pool_to_use_cnt_limit = Convert.ToInt32(v) },
+					{ "seedmem=", v => SHARE.valuableDataModels.Budget = Convert.ToInt64(v) * 1024 * 1024 },
 					{ "pathb=", v => SHARE.pathSSrc = v },
 					{ "usep" , v => SHARE.usep = true},
 					{ "repro=", v => SHARE.repro = v},
-					{ "asanLog=", v => SHARE.pathAsanReport = v}
+					{ "tmin=", v => tmin = v},
+					{ "tminJobs=", v => tminJobs = Convert.ToInt32(v)},
+					{ "tminCoverage", v => tminCoverage = true},
+					{ "tminWorker=", v => tminWorker = Convert.ToInt32(v)},
+					{ "minset=", v => minset = v},
+					{ "minsetOut=", v => minsetOut = v},
+					{ "minsetJobs=", v => minsetJobs = Convert.ToInt32(v)},
+					{ "minsetWorker=", v => minsetWorker = Convert.ToInt32(v)},
+					{ "seedpool=", v => SHARE.seedPoolResume = v},
+					{ "asanLog=", v => { SHARE.pathAsanReport = v; SHARE.keepAsanReports = true; } }
 				};
 
 				List<string> extra = p.Parse(args);
@@ -319,7 +443,44 @@ namespace Peach.Core.Runtime
 					return;
 				}
 				//feilong:加载共享内存
-				if(SHARE.repro != null ){
+				string replayRef = SHARE.repro == null ? null : System.IO.Path.Combine(SHARE.repro, ReplayJournal.RefFile);
+				string replayPath = SHARE.repro == null ? null : SHARE.repro + "/../../../" + ReplayJournal.FileName;
+				if(replayRef != null && File.Exists(replayRef) && File.Exists(replayPath)){
+					//只重放出错的那一个iteration, 不需要从checkpoint开始跑
+					SHARE.replayRecord = ReplayJournal.Read(replayPath, Convert.ToInt64(File.ReadAllText(replayRef).Trim()));
+
+					string runPath = SHARE.repro + "/../../../";
+					string headFolder = null;
+					DataModel head = null;
+					if(SHARE.replayRecord.Source == ReplaySource.Queue){
+						headFolder = runPath + ReplayJournal.QueueFolder;
+						head = SHARE.readSeedFromFolder(headFolder, SHARE.replayRecord.Head);
+					}
+					else if(SHARE.replayRecord.Source == ReplaySource.Pool){
+						headFolder = runPath + "seedpool";
+						head = SHARE.readSeedFromFolder(headFolder, SHARE.replayRecord.Head);
+						if (head == null && SHARE.seedPoolResume != null)
+							head = SHARE.readSeedFromFolder(SHARE.seedPoolResume, SHARE.replayRecord.Head);
+					}
+
+					if(headFolder != null){
+						if(head == null){
+							Console.WriteLine("Error, unable to find seed " + SHARE.replayRecord.Head + " of '" + headFolder + "' used by the replay record.");
+							return;
+						}
+						SHARE.replayHead = new Queue<DataModel>();
+						SHARE.replayHead.Enqueue(head);
+					}
+
+					SHARE.ifuse = false;
+					config.randomSeed = ReplayJournal.ReadSeed(replayPath);
+					config.range = true;
+					config.rangeStart = SHARE.replayRecord.Iteration;
+					config.rangeStop = SHARE.replayRecord.Iteration;
+					Console.WriteLine("Replaying iteration {0} sub iteration {1} with seed {2}.",
+						SHARE.replayRecord.Iteration, SHARE.replayRecord.SubIteration, config.randomSeed);
+				}
+				else if(SHARE.repro != null ){
 					
 					// if(SHARE.ifuse == false){
 					// 	//feilong:使用repo模式但是却没有开pro，错误
@@ -338,7 +499,16 @@ namespace Peach.Core.Runtime
 					Console.WriteLine("feilong:feilong_read start");
 					unsafe{
 						int read_iteration=0;
-						if(0 != feilong_read((SHARE.repro + "/repo.bin").ToCharArray(), ref read_iteration)){
+						string ckptRef = System.IO.Path.Combine(SHARE.repro, Peach.Core.Loggers.FileLogger.CheckpointRefFile);
+						if(File.Exists(ckptRef)){
+							//从run的checkpoint中恢复fault引用的那一代virgin_bits
+							string ckptPath = SHARE.repro + "/../../../" + Peach.Core.Loggers.FileLogger.CheckpointFile;
+							if(0 != ckpt_read(ckptPath, Convert.ToUInt32(File.ReadAllText(ckptRef).Trim()), ref read_iteration)){
+								Console.WriteLine("Error, unable to read generation from checkpoint '" + ckptPath + "'.");
+								return;
+							}
+						}
+						else if(0 != feilong_read((SHARE.repro + "/repo.bin").ToCharArray(), ref read_iteration)){
 							Console.WriteLine("feilong: feilong_read run error!");
 							return;
 						}
@@ -353,6 +523,13 @@ namespace Peach.Core.Runtime
 
 					SHARE.readSeedPoolFromFile(SHARE.repro + "/../../../seedpool/",SHARE.repro);
 				}
+				else if (SHARE.seedPoolResume != null)
+				{
+					// Resume from a reduced seed pool written by -minset
+					SHARE.readSeedPoolFromFile(SHARE.seedPoolResume, SHARE.seedPoolResume);
+					foreach (int index in SHARE.seedPoolIndexQueue)
+						SHARE.seedPoolIndex = Math.Max(SHARE.seedPoolIndex, index);
+				}
 				
 
 				if (extra.Count == 0 && agent == null && analyzer == null)
@@ -382,7 +559,7 @@ namespace Peach.Core.Runtime
 					nconfig.AddTarget("console", consoleTarget);
 					consoleTarget.Layout = "${logger} ${message}";
 
-					var rule = new LoggingRule("*", LogLevel.Debug, consoleTarget);
+					var rule = new LoggingRule("*", trace ? LogLevel.Trace : LogLevel.Debug, consoleTarget);
 					nconfig.LoggingRules.Add(rule);
 
 					LogManager.Configuration = nconfig;
@@ -457,9 +634,26 @@ namespace Peach.Core.Runtime
 				if (parseOnly)
 					return;
 
+				if (tmin != null)
+				{
+					RunMinimizer(args, parserArgs, extra, tmin, tminJobs, tminCoverage, tminWorker);
+					exitCode = 0;
+					return;
+				}
+
+				if (minset != null)
+				{
+					RunSeedMinset(args, parserArgs, extra, minset, minsetOut, minsetJobs, minsetWorker);
+					exitCode = 0;
+					return;
+				}
+
 				foreach (string arg in args)
 					config.commandLine += arg + " ";
 
+				if (profileFile != null)
+					Profiler.StartTrace(Profiler.DefaultCapacity);
+
 				if (extra.Count > 1)
 				{
 					if (!dom.tests.ContainsKey(extra[1]))
@@ -489,6 +683,8 @@ namespace Peach.Core.Runtime
 			}
 			finally
 			{
+				SaveProfile();
+
 				// HACK - Required on Mono with NLog 2.0
 				LogManager.Configuration = null;
 
@@ -497,9 +693,279 @@ namespace Peach.Core.Runtime
 			}
 		}
 
+		/// <summary>
+		/// Minimize the fault saved in 'faultPath'.  With several jobs the
+		/// candidates are replayed by worker processes, started like the
+		/// minset workers with their own copy of the SHM_ENV_VAR map.  Each
+		/// job parses the pit with Peach.TminWorker defined to its number, so
+		/// pits can give every job its own target instance (port, pipe, etc).
+		/// </summary>
+		protected void RunMinimizer(string[] args, Dictionary<string, object> parserArgs, List<string> extra, string faultPath, int jobs, bool coverage, int worker)
+		{
+			string testName = extra.Count > 1 ? extra[1] : "Default";
+			var first = ParseWorkerDom(parserArgs, extra, "Peach.TminWorker", Math.Max(0, worker));
+
+			if (worker >= 0)
+			{
+				RunMinimizerWorker(first, testName, coverage);
+				return;
+			}
+
+			var replayers = new List<Peach.Core.Analysis.IReplayer>();
+			var maps = new List<string>();
+
+			try
+			{
+				if (jobs > 1)
+				{
+					for (int i = 0; i < jobs; ++i)
+						replayers.Add(new Peach.Core.Analysis.WorkerReplayer(WorkerStartInfo(args, "--tminWorker=" + i, i, maps)));
+				}
+				else
+				{
+					replayers.Add(new Peach.Core.Analysis.EngineReplayer(first, testName, coverage));
+				}
+
+				var original = Peach.Core.Analysis.ReplayCase.Load(faultPath, first.tests[testName].stateModel);
+				var minimizer = new Peach.Core.Analysis.Minimizer(replayers);
+				minimizer.CheckCoverage = coverage;
+				minimizer.StepKept += delegate(Peach.Core.Analysis.Minimizer sender, string step, int actions, long bytes)
+				{
+					ConsoleWatcher.WriteInfoMark();
+					Console.WriteLine("Kept '{0}': {1} actions, {2} bytes", step, actions, bytes);
+				};
+
+				ConsoleWatcher.WriteInfoMark();
+				Console.WriteLine("Minimizing {0}: {1} actions, {2} bytes", faultPath, original.ActionCount, original.ByteCount);
+
+				var result = minimizer.Run(original);
+				string outPath = System.IO.Path.Combine(faultPath, "minimized");
+				result.Save(outPath);
+
+				ConsoleWatcher.WriteInfoMark();
+				Console.WriteLine("Fault {0} minimized to {1} actions, {2} bytes after {3} replays. Saved to {4}",
+					minimizer.FaultSignature, result.ActionCount, result.ByteCount, minimizer.Replays, outPath);
+			}
+			finally
+			{
+				foreach (var r in replayers.OfType<IDisposable>())
+					r.Dispose();
+
+				foreach (var m in maps)
+					System.IO.File.Delete(m);
+			}
+		}
+
+		/// <summary>
+		/// Replay the cases the --tmin parent writes to stdin until it closes
+		/// it, printing each result for its WorkerReplayer.
+		/// </summary>
+		void RunMinimizerWorker(Peach.Core.Dom.Dom workerDom, string testName, bool coverage)
+		{
+			var replayer = new Peach.Core.Analysis.EngineReplayer(workerDom, testName, coverage);
+			var reader = new BinaryReader(Console.OpenStandardInput());
+
+			while (true)
+			{
+				var replayCase = Peach.Core.Analysis.ReplayCase.Read(reader);
+				if (replayCase == null)
+					break;
+
+				Peach.Core.Analysis.ReplayResult result = null;
+				Exception error = null;
+
+				try
+				{
+					result = replayer.Replay(replayCase);
+				}
+				catch (Exception ex)
+				{
+					error = ex;
+				}
+
+				Console.WriteLine(Peach.Core.Analysis.WorkerReplayer.FormatResult(result, error));
+				Console.Out.Flush();
+			}
+		}
+
+		/// <summary>
+		/// Parse the pit with 'define' set to the job number 'worker'.
+		/// </summary>
+		Peach.Core.Dom.Dom ParseWorkerDom(Dictionary<string, object> parserArgs, List<string> extra, string define, int worker)
+		{
+			var defines = new Dictionary<string, string>(DefinedValues);
+			defines[define] = worker.ToString();
+
+			var workerArgs = new Dictionary<string, object>(parserArgs);
+			workerArgs[PitParser.DEFINED_VALUES] = defines;
+
+			return GetParser(new Engine(null)).asParser(workerArgs, extra[0]);
+		}
+
+		/// <summary>
+		/// Reduce the seed pool in 'seedPool' to the seeds needed to keep its
+		/// coverage.  With several jobs the seeds are split between worker
+		/// processes.  The coverage map is per process, so each worker gets
+		/// its own copy of the SHM_ENV_VAR map and Peach.MinsetWorker
+		/// defined to its number; the pit must start the target itself
+		/// (e.g. with a Process monitor) so the target inherits the map.
+		/// </summary>
+		protected void RunSeedMinset(string[] args, Dictionary<string, object> parserArgs, List<string> extra, string seedPool, string outPath, int jobs, int worker)
+		{
+			if (outPath == null)
+				outPath = seedPool.TrimEnd('/', '\\') + ".min";
+
+			string testName = extra.Count > 1 ? extra[1] : "Default";
+			string tracesFolder = System.IO.Path.Combine(outPath, "traces");
+			var seeds = Peach.Core.Analysis.SeedMinset.SeedIds(seedPool);
+			var ms = new Peach.Core.Analysis.SeedMinset();
+
+			ms.TraceStarting += delegate(Peach.Core.Analysis.Minset sender, string fileName, int count, int totalCount)
+			{
+				ConsoleWatcher.WriteInfoMark();
+				Console.WriteLine("Replaying seed {0} of {1}: {2}", count, totalCount, fileName);
+			};
+
+			if (worker < 0 && System.IO.Directory.Exists(tracesFolder))
+				System.IO.Directory.Delete(tracesFolder, true);
+
+			if (worker < 0 && jobs > 1)
+			{
+				RunMinsetWorkers(args, jobs);
+			}
+			else
+			{
+				var workerDom = ParseWorkerDom(parserArgs, extra, "Peach.MinsetWorker", Math.Max(0, worker));
+				var replayer = new Peach.Core.Analysis.EngineReplayer(workerDom, testName, false);
+				var mine = seeds.Where((s, i) => worker < 0 || i % jobs == worker).ToList();
+
+				ms.RunSeedTraces(replayer, tracesFolder, seedPool, mine);
+
+				// The parent collects the traces of every worker
+				if (worker >= 0)
+					return;
+			}
+
+			var traces = new Dictionary<int, uint[]>();
+			foreach (var index in seeds)
+			{
+				string traceFile = System.IO.Path.Combine(tracesFolder, index.ToString() + ".trace");
+				if (System.IO.File.Exists(traceFile))
+					traces.Add(index, Peach.Core.Analysis.SeedMinset.LoadTrace(traceFile));
+			}
+
+			var keep = ms.RunSeedCoverage(traces);
+			Peach.Core.Analysis.SeedMinset.SaveSeedPool(seedPool, keep, outPath);
+
+			ConsoleWatcher.WriteInfoMark();
+			Console.WriteLine("Kept {0} of {1} seeds covering {2} features. Saved to {3}, resume with --seedpool={3}",
+				keep.Length, seeds.Length, ms.Features, outPath);
+		}
+
+		/// <summary>
+		/// Run this command line again in 'jobs' worker processes with
+		/// --minsetWorker added, and wait for all of them.
+		/// </summary>
+		void RunMinsetWorkers(string[] args, int jobs)
+		{
+			var workers = new List<System.Diagnostics.Process>();
+			var maps = new List<string>();
+
+			try
+			{
+				for (int i = 0; i < jobs; ++i)
+					workers.Add(System.Diagnostics.Process.Start(WorkerStartInfo(args, "--minsetWorker=" + i, i, maps)));
+
+				for (int i = 0; i < workers.Count; ++i)
+				{
+					workers[i].WaitForExit();
+					if (workers[i].ExitCode != 0)
+						throw new PeachException("Error, minset job " + i + " failed with exit code " + workers[i].ExitCode + ".");
+				}
+			}
+			finally
+			{
+				foreach (var w in workers)
+				{
+					if (!w.HasExited)
+						w.Kill();
+				}
+
+				foreach (var m in maps)
+					System.IO.File.Delete(m);
+			}
+		}
+
+		/// <summary>
+		/// Start info to run this command line again with 'workerArg' added.
+		/// The coverage map is per process, so job 'i' gets its own copy of
+		/// the SHM_ENV_VAR map, which is added to 'maps' for the caller to
+		/// delete.
+		/// </summary>
+		System.Diagnostics.ProcessStartInfo WorkerStartInfo(string[] args, string workerArg, int i, List<string> maps)
+		{
+			string exe = System.Reflection.Assembly.GetEntryAssembly().Location;
+			string cmdLine = string.Join(" ", args.Select(a => "\"" + a + "\"").ToArray());
+			bool mono = Type.GetType("Mono.Runtime") != null;
+
+			var si = new System.Diagnostics.ProcessStartInfo();
+			si.FileName = mono ? System.Diagnostics.Process.GetCurrentProcess().MainModule.FileName : exe;
+			si.Arguments = (mono ? "\"" + exe + "\" " : "") + cmdLine + " " + workerArg;
+			si.UseShellExecute = false;
+
+			string map = Environment.GetEnvironmentVariable("SHM_ENV_VAR");
+			if (map != null)
+			{
+				string workerMap = map + "." + i;
+				using (var fs = new System.IO.FileStream(workerMap, System.IO.FileMode.Create))
+					fs.SetLength(new System.IO.FileInfo(map).Length);
+				maps.Add(workerMap);
+
+				si.EnvironmentVariables["SHM_ENV_VAR"] = workerMap;
+			}
+
+			return si;
+		}
+
 		protected static void CurrentDomain_DomainUnload(object sender, EventArgs e)
 		{
 			Console.ForegroundColor = DefaultForground;
+
+			// Remove the spilled seeds
+			SHARE.valuableDataModels.Dispose();
+
+			// Ctrl+C exits without running the finally of Run()
+			SaveProfile();
+		}
+
+		/// <summary>
+		/// Print the time spent in each phase and save the trace to the
+		/// --profile file.
+		/// </summary>
+		protected static void SaveProfile()
+		{
+			// Ctrl+C runs this while the engine thread is still going
+			string fileName = Interlocked.Exchange(ref profileFile, null);
+			if (fileName == null || !Profiler.Tracing)
+				return;
+
+			Profiler.Stop();
+
+			Console.WriteLine();
+			Console.WriteLine(" --- Profile ---");
+			Console.Write(Profiler.Summary());
+
+			try
+			{
+				Profiler.Save(fileName);
+				Console.WriteLine(" Trace saved to '{0}'.", fileName);
+			}
+			catch (Exception ex)
+			{
+				Console.WriteLine(" Unable to save trace to '{0}'. {1}", fileName, ex.Message);
+			}
+
+			Profiler.StopTrace();
 		}
 
 		/// <summary>
@@ -540,6 +1006,13 @@ Syntax:
   --debug                    Enable debug messages. Usefull when debugging
                              your Peach XML file.  Warning: Messages are very
                              cryptic sometimes.
+  --trace                    Enable debug messages and the per element
+                             PeachStar messages.  Slows fuzzing down.
+  --status N                 Print the status every N seconds (default 5).
+                             0 prints every iteration and mutator instead.
+  --profile=FILE             Time each phase of the iterations and save the
+                             last events to FILE, as a Chrome trace or as
+                             flamegraph stacks when FILE ends with .folded
   --seed N                   Sets the seed used by the random number generator
   --parseonly                Test parse a Peach XML file
   --showenv                  Print a list of all DataElements, Fixups, Monitors
@@ -552,6 +1025,16 @@ Syntax:
   -D/define=KEY=VALUE        Define a substitution value.  In your PIT you can
                              ##KEY## and it will be replaced for VALUE.
   --definedvalues=FILENAME   XML file containing defined values
+  --tmin=FAULT_FOLDER        Minimize the fault saved in FAULT_FOLDER
+  --tminJobs=N               Replay N candidates at once while minimizing
+  --tminCoverage             Also require the same coverage while minimizing
+  --minset=SEED_POOL         Reduce SEED_POOL to the seeds needed to keep
+                             its coverage
+  --minsetOut=FOLDER         Where to write the reduced seed pool
+  --minsetJobs=N             Replay seeds in N worker processes
+  --seedpool=FOLDER          Start fuzzing from the seeds in FOLDER
+  --seedmem=MB               Memory for the seed pool, seeds beyond it are
+                             spilled to disk (default 64, 0 for no limit)
 
 
 Peach Agent
@@ -779,7 +1262,7 @@ Debug Peach XML File
 
 		protected virtual Watcher GetUIWatcher()
 		{
-			return new ConsoleWatcher();
+			return new ConsoleWatcher() { StatusInterval = TimeSpan.FromSeconds(statusInterval) };
 		}
 
 		protected virtual Analyzer GetParser(Engine engine)
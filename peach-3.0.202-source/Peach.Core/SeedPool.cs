@@ -0,0 +1,293 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using NLog;
+
+using Peach.Core.Dom;
+
+namespace Peach.Core
+{
+	/// <summary>
+	/// The PeachStar seed pool, a queue of seeds kept under a memory budget.
+	/// </summary>
+	/// <remarks>
+	/// Seeds are held as SeedStore records instead of DataModel clones, only
+	/// the seed at the head is decoded.  Once the records use more than
+	/// Budget bytes, the seeds furthest from the head are spilled to a
+	/// SeedStore in a temporary folder and read back when they reach the
+	/// head.  The pool is used round robin, so the seed used least recently
+	/// is the next one due and evicting it, as a LRU would, reloads every
+	/// seed once the pool outgrows the budget.  Evicting from the tail
+	/// keeps the seeds that are due soon resident.
+	///
+	/// The use_time and p of a seed live in its entry, a spilled record is
+	/// never rewritten.
+	/// </remarks>
+	public class SeedPool : IDisposable
+	{
+		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
+
+		/// <summary>
+		/// Bytes accounted to an entry on top of its record.
+		/// </summary>
+		const int EntryOverhead = 64;
+
+		class Entry
+		{
+			public int Id;
+			public int UseTime;
+			public double P;
+			public byte[] Record;
+			public LinkedListNode<Entry> Resident;
+		}
+
+		LinkedList<Entry> _queue = new LinkedList<Entry>();
+		LinkedList<Entry> _resident = new LinkedList<Entry>();
+		string _spillFolder;
+		SeedStore _spill;
+		int _headId = -1;
+		DataModel _head;
+
+		public SeedPool(long budget)
+		{
+			Budget = budget;
+		}
+
+		/// <summary>
+		/// Bytes the resident records may use, 0 for no limit.
+		/// </summary>
+		public long Budget { get; set; }
+
+		public int Count
+		{
+			get { return _queue.Count; }
+		}
+
+		/// <summary>
+		/// Number of seeds held in memory.
+		/// </summary>
+		public int Resident
+		{
+			get { return _resident.Count; }
+		}
+
+		public long ResidentBytes { get; private set; }
+
+		/// <summary>
+		/// Number of records written to the spill store.
+		/// </summary>
+		public int Spills { get; private set; }
+
+		/// <summary>
+		/// Number of seeds decoded at the head from memory.
+		/// </summary>
+		public int Hits { get; private set; }
+
+		/// <summary>
+		/// Number of seeds read back from the spill store.
+		/// </summary>
+		public int Loads { get; private set; }
+
+		/// <summary>
+		/// Share of the seeds decoded at the head that had to be read back.
+		/// </summary>
+		public double ReloadRate
+		{
+			get { return Hits + Loads == 0 ? 0 : (double)Loads / (Hits + Loads); }
+		}
+
+		/// <summary>
+		/// Ids of the seeds, head first.
+		/// </summary>
+		public IEnumerable<int> Ids
+		{
+			get { return _queue.Select(e => e.Id); }
+		}
+
+		public void Enqueue(int id, DataModel model)
+		{
+			var entry = new Entry();
+			entry.Id = id;
+			entry.UseTime = model.use_time;
+			entry.P = model.p;
+			entry.Record = SeedStore.Encode(id, model);
+			entry.Resident = _resident.AddLast(entry);
+			ResidentBytes += entry.Record.Length + EntryOverhead;
+
+			_queue.AddLast(entry);
+
+			Trim();
+		}
+
+		/// <summary>
+		/// The seed at the head of the pool.
+		/// </summary>
+		/// <remarks>
+		/// The model is decoded once and returned until Dequeue(), changes
+		/// to its use_time are kept.
+		/// </remarks>
+		public DataModel Peek()
+		{
+			if (_queue.Count == 0)
+				throw new InvalidOperationException("Seed pool is empty.");
+
+			var entry = _queue.First.Value;
+			if (_head != null && _headId == entry.Id)
+				return _head;
+
+			if (entry.Record != null)
+			{
+				Hits++;
+				_head = SeedStore.Decode(entry.Record);
+			}
+			else
+			{
+				Loads++;
+				logger.Trace("Peek: Reading seed {0} back from the spill store.", entry.Id);
+				_head = _spill.Read(entry.Id);
+			}
+
+			_head.use_time = entry.UseTime;
+			_head.p = entry.P;
+			_headId = entry.Id;
+
+			return _head;
+		}
+
+		/// <summary>
+		/// Take the seed at the head out of the pool.
+		/// </summary>
+		/// <returns>Returns the id of the seed.</returns>
+		public int Dequeue()
+		{
+			if (_queue.Count == 0)
+				throw new InvalidOperationException("Seed pool is empty.");
+
+			var entry = _queue.First.Value;
+			_queue.RemoveFirst();
+
+			if (entry.Resident != null)
+				Evict(entry);
+
+			if (_headId == entry.Id)
+			{
+				_head = null;
+				_headId = -1;
+			}
+
+			return entry.Id;
+		}
+
+		/// <summary>
+		/// Remove every seed and delete the spill store.
+		/// </summary>
+		public void Clear()
+		{
+			_queue.Clear();
+			_resident.Clear();
+			ResidentBytes = 0;
+			_head = null;
+			_headId = -1;
+
+			CloseSpill();
+		}
+
+		/// <summary>
+		/// Spill the resident seeds furthest from the head until the
+		/// records fit the budget.  The head itself always stays.
+		/// </summary>
+		void Trim()
+		{
+			if (Budget <= 0)
+				return;
+
+			while (ResidentBytes > Budget && _resident.Count > 0)
+			{
+				var entry = _resident.Last.Value;
+				if (entry == _queue.First.Value)
+					break;
+
+				if (_spill == null)
+				{
+					_spillFolder = Path.Combine(Path.GetTempPath(), "peach-seedpool-" + Path.GetRandomFileName());
+					_spill = new SeedStore(_spillFolder, false);
+				}
+
+				// Records do not change, a seed is written at most once
+				if (!_spill.Contains(entry.Id))
+				{
+					_spill.Add(entry.Id, entry.Record);
+					Spills++;
+				}
+
+				Evict(entry);
+			}
+		}
+
+		void Evict(Entry entry)
+		{
+			_resident.Remove(entry.Resident);
+			ResidentBytes -= entry.Record.Length + EntryOverhead;
+			entry.Resident = null;
+			entry.Record = null;
+		}
+
+		void CloseSpill()
+		{
+			if (_spill == null)
+				return;
+
+			_spill.Dispose();
+			_spill = null;
+
+			try
+			{
+				Directory.Delete(_spillFolder, true);
+			}
+			catch (Exception ex)
+			{
+				logger.Debug("Unable to delete seed spill folder '{0}'. {1}", _spillFolder, ex.Message);
+			}
+
+			_spillFolder = null;
+		}
+
+		public void Dispose()
+		{
+			Clear();
+		}
+	}
+}
+
+// end
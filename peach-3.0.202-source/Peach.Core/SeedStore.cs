@@ -0,0 +1,647 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Linq;
+using System.Text;
+
+using Peach.Core.Dom;
+using Peach.Core.IO;
+
+namespace Peach.Core
+{
+	/// <summary>
+	/// Append only store for the seeds of a PeachStar seed pool or queue.
+	/// </summary>
+	/// <remarks>
+	/// DataFile is a log of length prefixed records, IndexFile a log of
+	/// (seed id, record offset) entries, an offset of -1 retires the seed.
+	/// A record only holds the element type, name and cached value of each
+	/// element, which is all FeilongGetMutatedValue() splices from, instead
+	/// of the BinaryFormatter graph of a whole DataModel.  Seeds read back
+	/// are rebuilt with the same element types, a Choice holding only its
+	/// selected branch, and the cached values restored as they were, so a
+	/// transformed container keeps its encoded value and stays a container.
+	/// An element type that can't be found is read back as a Block or Blob.
+	///
+	/// Retired seeds stay readable until Compact(), fault folders may
+	/// still reference them through their seed queue snapshot.
+	/// </remarks>
+	public class SeedStore : IDisposable
+	{
+		public const string DataFile = "seeds.dat";
+		public const string IndexFile = "seeds.idx";
+
+		const uint DataMagic = 0x53445350; // "PSDS"
+		const uint IndexMagic = 0x58445350; // "PSDX"
+		const uint Version = 2;
+		const int HeaderSize = 8;
+		const int IndexEntrySize = 12;
+
+		const byte KindLeaf = 0;
+		const byte KindContainer = 1;
+
+		static Dictionary<string, Type> _elementTypes = new Dictionary<string, Type>();
+
+		string _folder;
+		bool _readOnly;
+		FileStream _data;
+		FileStream _index;
+		Dictionary<int, long> _offsets = new Dictionary<int, long>();
+		List<int> _order = new List<int>();
+		HashSet<int> _retired = new HashSet<int>();
+
+		/// <summary>
+		/// Open the store in 'folder', creating it unless readOnly.
+		/// </summary>
+		public SeedStore(string folder, bool readOnly)
+		{
+			_folder = folder;
+			_readOnly = readOnly;
+
+			string dataPath = Path.Combine(folder, DataFile);
+			string indexPath = Path.Combine(folder, IndexFile);
+
+			if (readOnly)
+			{
+				_data = new FileStream(dataPath, FileMode.Open, FileAccess.Read, FileShare.ReadWrite);
+				CheckHeader(_data, DataMagic, dataPath);
+
+				if (File.Exists(indexPath))
+				{
+					using (var index = new FileStream(indexPath, FileMode.Open, FileAccess.Read, FileShare.ReadWrite))
+						LoadIndex(index, indexPath);
+				}
+				else
+				{
+					Rebuild();
+				}
+
+				return;
+			}
+
+			if (!Directory.Exists(folder))
+				Directory.CreateDirectory(folder);
+
+			_data = new FileStream(dataPath, FileMode.OpenOrCreate, FileAccess.ReadWrite, FileShare.Read);
+			_index = new FileStream(indexPath, FileMode.OpenOrCreate, FileAccess.ReadWrite, FileShare.Read);
+
+			if (_data.Length == 0)
+			{
+				WriteHeader(_data, DataMagic);
+				_index.SetLength(0);
+			}
+			else
+			{
+				CheckHeader(_data, DataMagic, dataPath);
+			}
+
+			if (_index.Length == 0)
+			{
+				WriteHeader(_index, IndexMagic);
+				Rebuild();
+				foreach (int id in _order)
+					AppendIndex(id, _offsets[id]);
+			}
+			else
+			{
+				LoadIndex(_index, indexPath);
+			}
+
+			// Drop a record torn by a crash so the log stays parseable
+			long end = HeaderSize;
+			foreach (long offset in _offsets.Values)
+				end = Math.Max(end, offset + 4 + ReadLength(offset));
+			if (_data.Length > end)
+				_data.SetLength(end);
+
+			_data.Seek(0, SeekOrigin.End);
+			_index.Seek(0, SeekOrigin.End);
+		}
+
+		/// <summary>
+		/// True if 'folder' holds a seed store.
+		/// </summary>
+		public static bool Exists(string folder)
+		{
+			return File.Exists(Path.Combine(folder, DataFile));
+		}
+
+		/// <summary>
+		/// Ids of the seeds that are not retired, in the order they were added.
+		/// </summary>
+		public IEnumerable<int> Ids
+		{
+			get { return _order.Where(id => !_retired.Contains(id)); }
+		}
+
+		public int Count
+		{
+			get { return _order.Count - _retired.Count; }
+		}
+
+		/// <summary>
+		/// True if the seed can be read, retired seeds included.
+		/// </summary>
+		public bool Contains(int id)
+		{
+			return _offsets.ContainsKey(id);
+		}
+
+		public bool IsRetired(int id)
+		{
+			return _retired.Contains(id);
+		}
+
+		#region Writing
+
+		public void Add(int id, DataModel model)
+		{
+			Add(id, Encode(id, model));
+		}
+
+		/// <summary>
+		/// Add a record made by Encode().
+		/// </summary>
+		public void Add(int id, byte[] payload)
+		{
+			if (_readOnly)
+				throw new InvalidOperationException("Seed store is read only.");
+
+			long offset = _data.Seek(0, SeekOrigin.End);
+			var writer = new BinaryWriter(_data);
+			writer.Write(payload.Length);
+			writer.Write(payload);
+			writer.Flush();
+
+			// The index entry goes last so a torn record is never referenced
+			AppendIndex(id, offset);
+
+			if (!_offsets.ContainsKey(id))
+				_order.Add(id);
+			_offsets[id] = offset;
+			_retired.Remove(id);
+		}
+
+		/// <summary>
+		/// Take a seed out of the pool, it is dropped by the next Compact().
+		/// </summary>
+		public void Retire(int id)
+		{
+			if (_readOnly)
+				throw new InvalidOperationException("Seed store is read only.");
+
+			if (!_offsets.ContainsKey(id) || !_retired.Add(id))
+				return;
+
+			AppendIndex(id, -1);
+		}
+
+		/// <summary>
+		/// Rewrite the store without the retired seeds.
+		/// </summary>
+		public void Compact()
+		{
+			if (_readOnly)
+				throw new InvalidOperationException("Seed store is read only.");
+
+			if (_retired.Count == 0)
+				return;
+
+			string tmp = _folder + ".compact";
+			CopyTo(tmp, Ids);
+
+			_data.Close();
+			_index.Close();
+
+			foreach (var name in new string[] { DataFile, IndexFile })
+			{
+				File.Delete(Path.Combine(_folder, name));
+				File.Move(Path.Combine(tmp, name), Path.Combine(_folder, name));
+			}
+
+			Directory.Delete(tmp, true);
+
+			_offsets.Clear();
+			_order.Clear();
+			_retired.Clear();
+
+			_data = new FileStream(Path.Combine(_folder, DataFile), FileMode.Open, FileAccess.ReadWrite, FileShare.Read);
+			_index = new FileStream(Path.Combine(_folder, IndexFile), FileMode.Open, FileAccess.ReadWrite, FileShare.Read);
+			LoadIndex(_index, IndexFile);
+			_data.Seek(0, SeekOrigin.End);
+			_index.Seek(0, SeekOrigin.End);
+		}
+
+		/// <summary>
+		/// Write the records of 'ids', in that order, to a new store in 'folder'.
+		/// </summary>
+		public void CopyTo(string folder, IEnumerable<int> ids)
+		{
+			if (!Directory.Exists(folder))
+				Directory.CreateDirectory(folder);
+
+			using (var data = new BinaryWriter(File.Create(Path.Combine(folder, DataFile))))
+			using (var index = new BinaryWriter(File.Create(Path.Combine(folder, IndexFile))))
+			{
+				data.Write(DataMagic);
+				data.Write(Version);
+				index.Write(IndexMagic);
+				index.Write(Version);
+
+				foreach (int id in ids)
+				{
+					var payload = ReadPayload(id);
+					index.Write(id);
+					index.Write(data.BaseStream.Position);
+					data.Write(payload.Length);
+					data.Write(payload);
+				}
+			}
+		}
+
+		void AppendIndex(int id, long offset)
+		{
+			var writer = new BinaryWriter(_index);
+			writer.Write(id);
+			writer.Write(offset);
+			writer.Flush();
+		}
+
+		static void WriteHeader(FileStream fs, uint magic)
+		{
+			var writer = new BinaryWriter(fs);
+			writer.Write(magic);
+			writer.Write(Version);
+			writer.Flush();
+		}
+
+		#endregion
+
+		#region Reading
+
+		/// <summary>
+		/// Read one seed, O(1) through the index.
+		/// </summary>
+		public DataModel Read(int id)
+		{
+			return Decode(ReadPayload(id));
+		}
+
+		/// <summary>
+		/// Read many seeds with a single sequential pass over a mapping of
+		/// the data file.
+		/// </summary>
+		/// <returns>Returns the seeds found, by id.</returns>
+		public Dictionary<int, DataModel> ReadAll(IEnumerable<int> ids)
+		{
+			var ret = new Dictionary<int, DataModel>();
+			var wanted = new List<KeyValuePair<long, int>>();
+
+			foreach (int id in ids.Distinct())
+			{
+				long offset;
+				if (_offsets.TryGetValue(id, out offset))
+					wanted.Add(new KeyValuePair<long, int>(offset, id));
+			}
+
+			if (wanted.Count == 0)
+				return ret;
+
+			wanted.Sort((a, b) => a.Key.CompareTo(b.Key));
+
+			long length = wanted[wanted.Count - 1].Key + 4 + ReadLength(wanted[wanted.Count - 1].Key);
+
+			using (var mmf = MemoryMappedFile.CreateFromFile(_data, null, 0, MemoryMappedFileAccess.Read, null, HandleInheritability.None, true))
+			using (var view = mmf.CreateViewStream(0, length, MemoryMappedFileAccess.Read))
+			{
+				var reader = new BinaryReader(view);
+
+				foreach (var kv in wanted)
+				{
+					view.Position = kv.Key;
+					int size = reader.ReadInt32();
+					ret[kv.Value] = Decode(reader.ReadBytes(size));
+				}
+			}
+
+			return ret;
+		}
+
+		int ReadLength(long offset)
+		{
+			_data.Seek(offset, SeekOrigin.Begin);
+			var ret = new BinaryReader(_data).ReadInt32();
+			_data.Seek(0, SeekOrigin.End);
+			return ret;
+		}
+
+		byte[] ReadPayload(int id)
+		{
+			long offset;
+			if (!_offsets.TryGetValue(id, out offset))
+				throw new PeachException("Error, seed " + id + " is not in the seed store '" + _folder + "'.");
+
+			_data.Seek(offset, SeekOrigin.Begin);
+			var reader = new BinaryReader(_data);
+			var ret = reader.ReadBytes(reader.ReadInt32());
+			_data.Seek(0, SeekOrigin.End);
+			return ret;
+		}
+
+		static void CheckHeader(FileStream fs, uint magic, string fileName)
+		{
+			var reader = new BinaryReader(fs);
+			if (fs.Length < HeaderSize || reader.ReadUInt32() != magic || reader.ReadUInt32() != Version)
+				throw new PeachException("Error, '" + fileName + "' is not a seed store.");
+		}
+
+		void LoadIndex(FileStream fs, string fileName)
+		{
+			fs.Seek(0, SeekOrigin.Begin);
+			CheckHeader(fs, IndexMagic, fileName);
+
+			long dataLength = _data.Length;
+			var reader = new BinaryReader(fs);
+
+			// A torn last entry is ignored
+			long entries = (fs.Length - HeaderSize) / IndexEntrySize;
+			for (long i = 0; i < entries; ++i)
+			{
+				int id = reader.ReadInt32();
+				long offset = reader.ReadInt64();
+
+				if (offset < 0)
+				{
+					if (_offsets.ContainsKey(id))
+						_retired.Add(id);
+				}
+				else if (offset < dataLength)
+				{
+					if (!_offsets.ContainsKey(id))
+						_order.Add(id);
+					_offsets[id] = offset;
+					_retired.Remove(id);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Recover the index from the records, retirements are lost.
+		/// </summary>
+		void Rebuild()
+		{
+			_data.Seek(HeaderSize, SeekOrigin.Begin);
+			var reader = new BinaryReader(_data);
+
+			while (_data.Length - _data.Position >= 8)
+			{
+				long offset = _data.Position;
+				int size = reader.ReadInt32();
+				if (size < 4 || _data.Length - _data.Position < size)
+					break;
+
+				int id = reader.ReadInt32();
+				_data.Seek(size - 4, SeekOrigin.Current);
+
+				if (!_offsets.ContainsKey(id))
+					_order.Add(id);
+				_offsets[id] = offset;
+			}
+		}
+
+		#endregion
+
+		#region Record Format
+
+		/// <summary>
+		/// Record of a seed: id, model name, p, use_time, the element types
+		/// used, the model value and the element tree.
+		/// </summary>
+		public static byte[] Encode(int id, DataModel model)
+		{
+			var types = new List<string>();
+			var body = new MemoryStream();
+			var bodyWriter = new BinaryWriter(body);
+
+			WriteValue(bodyWriter, model.CachedValue);
+			bodyWriter.Write(model.Count);
+			foreach (var child in model)
+				EncodeElement(bodyWriter, child, types);
+			bodyWriter.Flush();
+
+			var ms = new MemoryStream();
+			var writer = new BinaryWriter(ms);
+
+			writer.Write(id);
+			writer.Write(model.name);
+			writer.Write(model.p);
+			writer.Write(model.use_time);
+			writer.Write(types.Count);
+			foreach (var type in types)
+				writer.Write(type);
+			body.WriteTo(ms);
+
+			writer.Flush();
+			return ms.ToArray();
+		}
+
+		static void EncodeElement(BinaryWriter writer, DataElement elem, List<string> types)
+		{
+			string type = elem.elementType;
+			int index = types.IndexOf(type);
+			if (index < 0)
+			{
+				index = types.Count;
+				types.Add(type);
+			}
+
+			var cont = elem as DataElementContainer;
+
+			writer.Write(cont != null ? KindContainer : KindLeaf);
+			writer.Write((ushort)index);
+			writer.Write(elem.name);
+			WriteValue(writer, elem.CachedValue);
+
+			// A Choice only holds its selected branch
+			if (cont != null)
+			{
+				writer.Write(cont.Count);
+				foreach (var child in cont)
+					EncodeElement(writer, child, types);
+			}
+		}
+
+		static void WriteValue(BinaryWriter writer, BitStream value)
+		{
+			if (value == null)
+			{
+				writer.Write(-1L);
+				return;
+			}
+
+			var buf = value.Value;
+			writer.Write(value.LengthBits);
+			writer.Write(buf.Length);
+			writer.Write(buf);
+		}
+
+		public static DataModel Decode(byte[] payload)
+		{
+			var reader = new BinaryReader(new MemoryStream(payload));
+
+			reader.ReadInt32();
+			var model = new DataModel(reader.ReadString());
+			model.p = reader.ReadDouble();
+			model.use_time = reader.ReadInt32();
+			model.isMutable = false;
+
+			var types = new string[reader.ReadInt32()];
+			for (int i = 0; i < types.Length; ++i)
+				types[i] = reader.ReadString();
+
+			// Adding children clears the caches of the parents, so the
+			// values are only restored once the tree is complete
+			var values = new List<KeyValuePair<DataElement, BitStream>>();
+			values.Add(new KeyValuePair<DataElement, BitStream>(model, ReadValue(reader)));
+
+			int count = reader.ReadInt32();
+			for (int i = 0; i < count; ++i)
+				model.Add(DecodeElement(reader, types, values));
+
+			foreach (var kv in values)
+				kv.Key.CachedValue = kv.Value;
+
+			return model;
+		}
+
+		static DataElement DecodeElement(BinaryReader reader, string[] types, List<KeyValuePair<DataElement, BitStream>> values)
+		{
+			byte kind = reader.ReadByte();
+			string type = types[reader.ReadUInt16()];
+			string name = reader.ReadString();
+			var value = ReadValue(reader);
+
+			DataElement elem = CreateElement(type, name, kind == KindContainer);
+			elem.isMutable = false;
+			values.Add(new KeyValuePair<DataElement, BitStream>(elem, value));
+
+			// Also stands in for leaves of unknown types
+			if (value != null && elem is Blob)
+				elem.DefaultValue = new Variant(value);
+
+			if (kind == KindContainer)
+			{
+				var cont = (DataElementContainer)elem;
+				var choice = elem as Choice;
+
+				int count = reader.ReadInt32();
+				for (int i = 0; i < count; ++i)
+				{
+					var child = DecodeElement(reader, types, values);
+
+					if (choice != null)
+					{
+						choice.choiceElements.Add(child.name, child);
+						child.parent = choice;
+						choice.SelectedElement = child;
+					}
+					else
+					{
+						cont.Add(child);
+					}
+				}
+			}
+
+			return elem;
+		}
+
+		static DataElement CreateElement(string type, string name, bool container)
+		{
+			Type t;
+
+			lock (_elementTypes)
+			{
+				if (!_elementTypes.TryGetValue(type, out t))
+				{
+					t = ClassLoader.FindTypeByAttribute<DataElementAttribute>((x, a) => a.elementName == type);
+					_elementTypes.Add(type, t);
+				}
+			}
+
+			if (t != null && typeof(DataElementContainer).IsAssignableFrom(t) == container && t != typeof(DataModel))
+				return (DataElement)Activator.CreateInstance(t, name);
+
+			if (container)
+				return new Block(name);
+
+			return new Blob(name);
+		}
+
+		static BitStream ReadValue(BinaryReader reader)
+		{
+			long bits = reader.ReadInt64();
+			if (bits < 0)
+				return null;
+
+			var buf = reader.ReadBytes(reader.ReadInt32());
+			var bs = new BitStream();
+			int full = (int)(bits / 8);
+			int rem = (int)(bits % 8);
+
+			bs.WriteBytes(buf, 0, full);
+			if (rem != 0)
+				bs.WriteBits((ulong)(buf[full] >> (8 - rem)), rem);
+			bs.SeekBits(0, SeekOrigin.Begin);
+
+			return bs;
+		}
+
+		#endregion
+
+		public void Dispose()
+		{
+			if (_data != null)
+			{
+				_data.Close();
+				_data = null;
+			}
+
+			if (_index != null)
+			{
+				_index.Close();
+				_index = null;
+			}
+		}
+	}
+}
+
+// end
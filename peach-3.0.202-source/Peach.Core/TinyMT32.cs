@@ -59,6 +59,21 @@ namespace Peach.Core
 		{
 			return GenerateUInt() * 1.0 / DENOMINATOR;
 		}
+
+		// Copy of the internal state, see SetState()
+		public uint[] GetState()
+		{
+			return (uint[])status.Clone();
+		}
+
+		// Continue the sequence from a state returned by GetState()
+		public void SetState(uint[] state)
+		{
+			if (state == null || state.Length != status.Length)
+				throw new ArgumentException("state");
+
+			status = (uint[])state.Clone();
+		}
 		#endregion
 
 		#region Implementation
@@ -0,0 +1,209 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+
+namespace Peach.Core
+{
+	/// <summary>
+	/// Learns how long the target takes to go quiet after each action and
+	/// derives per-action wait times from the observed latencies.
+	/// </summary>
+	/// <remarks>
+	/// Samples recorded during control iterations form the calibration phase.
+	/// Once an action has enough samples, its wait time is the configured
+	/// percentile of the most recent samples scaled by a safety margin.  Every
+	/// later iteration keeps feeding samples so the estimate tracks the target
+	/// online.
+	/// </remarks>
+	[Serializable]
+	public class WaitTimeCalibrator
+	{
+		/// <summary>
+		/// Sliding window of latency samples for a single action.
+		/// </summary>
+		[Serializable]
+		class Samples
+		{
+			public int[] values;
+			public int next;
+			public int count;
+			public int wait;
+
+			public Samples(int size)
+			{
+				values = new int[size];
+			}
+		}
+
+		Dictionary<string, Samples> _samples = new Dictionary<string, Samples>();
+
+		public WaitTimeCalibrator()
+		{
+			DefaultWait = 100;
+			MinimumWait = 10;
+			MaximumWait = 5000;
+			Percentile = 0.95;
+			Margin = 1.5;
+			WindowSize = 64;
+			MinimumSamples = 3;
+		}
+
+		/// <summary>
+		/// Wait in milliseconds used while an action is still being calibrated.
+		/// </summary>
+		public int DefaultWait { get; set; }
+
+		/// <summary>
+		/// Lower bound in milliseconds for any derived wait.
+		/// </summary>
+		public int MinimumWait { get; set; }
+
+		/// <summary>
+		/// Upper bound in milliseconds for any derived wait.
+		/// </summary>
+		public int MaximumWait { get; set; }
+
+		/// <summary>
+		/// Percentile (0.0 - 1.0) of observed latencies used as the wait time.
+		/// </summary>
+		public double Percentile { get; set; }
+
+		/// <summary>
+		/// Multiplier applied to the percentile to absorb jitter.
+		/// </summary>
+		public double Margin { get; set; }
+
+		/// <summary>
+		/// Number of most recent samples kept per action.
+		/// </summary>
+		public int WindowSize { get; set; }
+
+		/// <summary>
+		/// Samples required before an action leaves the calibration phase.
+		/// </summary>
+		public int MinimumSamples { get; set; }
+
+		/// <summary>
+		/// Has the action collected enough samples to use a derived wait.
+		/// </summary>
+		public bool IsCalibrated(string key)
+		{
+			Samples s;
+			return _samples.TryGetValue(key, out s) && s.count >= MinimumSamples;
+		}
+
+		/// <summary>
+		/// Record how many milliseconds the target took to go quiet after an action.
+		/// </summary>
+		public void Record(string key, int milliseconds)
+		{
+			Samples s;
+			if (!_samples.TryGetValue(key, out s))
+			{
+				s = new Samples(WindowSize);
+				_samples.Add(key, s);
+			}
+
+			s.values[s.next] = Math.Max(0, milliseconds);
+			s.next = (s.next + 1) % s.values.Length;
+			s.count = Math.Min(s.count + 1, s.values.Length);
+			s.wait = Derive(s);
+		}
+
+		/// <summary>
+		/// Wait time in milliseconds for an action.  Returns DefaultWait
+		/// until the action has been calibrated.
+		/// </summary>
+		public int GetWait(string key)
+		{
+			Samples s;
+			if (!_samples.TryGetValue(key, out s) || s.count < MinimumSamples)
+				return DefaultWait;
+
+			return s.wait;
+		}
+
+		/// <summary>
+		/// Largest wait currently in effect across all calibrated actions.
+		/// </summary>
+		public int MaxWait
+		{
+			get
+			{
+				int ret = 0;
+				foreach (var s in _samples.Values)
+				{
+					if (s.count >= MinimumSamples)
+						ret = Math.Max(ret, s.wait);
+					else
+						ret = Math.Max(ret, DefaultWait);
+				}
+
+				return ret;
+			}
+		}
+
+		/// <summary>
+		/// Clamp a wait configured in the pit (seconds) to what calibration
+		/// has shown the target actually needs.  Returns the configured value
+		/// until every action has been calibrated.
+		/// </summary>
+		public decimal Clamp(decimal seconds)
+		{
+			if (seconds <= 0 || _samples.Count == 0)
+				return seconds;
+
+			foreach (var s in _samples.Values)
+			{
+				if (s.count < MinimumSamples)
+					return seconds;
+			}
+
+			return Math.Min(seconds, (decimal)MaxWait / 1000);
+		}
+
+		int Derive(Samples s)
+		{
+			var sorted = new int[s.count];
+			Array.Copy(s.values, sorted, s.count);
+			Array.Sort(sorted);
+
+			int idx = (int)Math.Ceiling(Percentile * s.count) - 1;
+			idx = Math.Max(0, Math.Min(s.count - 1, idx));
+
+			int wait = (int)Math.Ceiling(sorted[idx] * Margin);
+			return Math.Max(MinimumWait, Math.Min(MaximumWait, wait));
+		}
+	}
+}
+
+// end
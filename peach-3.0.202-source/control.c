@@ -34,13 +34,16 @@ static u8 trace_bits_snap[MAP_SIZE];
 
 static u8 virgin_bits[MAP_SIZE];     /* Regions yet untouched by fuzzing */
 
-//feilong：添加virgin_bits_maintain，保存的最近一次队列为空时的virgin_bits
-static u8 virgin_bits_maintain[MAP_SIZE];
-//feilogn:添加iteration_maintain,保存的最近一次队列为空时的iteration
-static int iteration_maintain;
+#define CKPT_PAGE_SHIFT     12
+#define CKPT_PAGES          (MAP_SIZE >> CKPT_PAGE_SHIFT)
+
+static u8 virgin_dirty[CKPT_PAGES];  /* Pages of virgin_bits changed since the last checkpoint */
 
 static u8 session_virgin_bits[MAP_SIZE];     /* Regions yet untouched while the SUT is still running */
 
+static u8 trace_accum[MAP_SIZE];     /* Classified hits of every output in this iteration */
+static u8 trace_base[MAP_SIZE];      /* trace_accum of the last unmutated iteration      */
+
 static const u8 count_class_lookup8[256] = { 
   [0]           = 0,
   [1]           = 1,
@@ -98,6 +101,20 @@ u32 count_branch() {
 
 }
 
+/* Number of map entries hit so far, for the map density on the console. */
+
+u32 count_edges() {
+
+  u32 i;
+  u32 ret = 0;
+
+  for (i = 0; i < MAP_SIZE; i++)
+    if (virgin_bits[i] != 0xff) ret++;
+
+  return ret;
+
+}
+
 #ifdef __x86_64__
 
 static inline void classify_counts(u64* mem) {
@@ -293,6 +310,9 @@ u8 has_new_bits(u8* virgin_map, u8* trace_bit) {
 
       *virgin &= ~*current; 
 
+      if (virgin_map == virgin_bits)
+        virgin_dirty[((u8*)virgin - virgin_bits) >> CKPT_PAGE_SHIFT] = 1;
+
     } 
 
     current++;
@@ -331,55 +351,325 @@ int newPath()
     classify_counts((u32*)trace_bits);
 #endif /* ^__x86_64__ */
 
-    u8 hnb = has_new_bits(virgin_bits, trace_bits);
+    /* Called for every output, the caller reports new paths. */
+    return has_new_bits(virgin_bits, trace_bits);
+}
+
+/* Field influence analysis.  newPath() leaves trace_bits classified, so
+   every hit count is a single bucket bit and OR-ing the outputs of one
+   iteration together gives the union of the buckets it reached. */
+
+void trace_accum_reset()
+{
+    memset(trace_accum, 0, MAP_SIZE);
+}
+
+void trace_accum_add()
+{
+  u64* src = (u64*)trace_bits;
+  u64* dst = (u64*)trace_accum;
+  u32  i   = (MAP_SIZE >> 3);
+
+  while (i--) {
+
+    if (unlikely(*src)) *dst |= *src;
+
+    src++;
+    dst++;
+
+  }
+}
+
+void trace_accum_save_base()
+{
+    memcpy(trace_base, trace_accum, MAP_SIZE);
+}
+
+/* Store up to 'max' indexes of map bytes that differ between this iteration
+   and the base in 'edges'.  Returns the total number of differing bytes. */
+
+u32 trace_accum_diff(u32* edges, u32 max)
+{
+  u64* cur  = (u64*)trace_accum;
+  u64* base = (u64*)trace_base;
+  u32  i, j, ret = 0;
+
+  for (i = 0; i < (MAP_SIZE >> 3); i++) {
+
+    if (likely(cur[i] == base[i])) continue;
+
+    u8* c = (u8*)&cur[i];
+    u8* b = (u8*)&base[i];
+
+    for (j = 0; j < 8; j++) {
+
+      if (c[j] == b[j]) continue;
+      if (ret < max) edges[ret] = (i << 3) + j;
+      ret++;
 
-    printf("hnb = %d\n", hnb);
-    if (hnb != 0)
-    {
-        printf("new path found !!!\n");
-        return hnb;
-    } 
-    else
-    {
-        printf("opps! No path found !!!\n");
-        return 0;
     }
-            
+
+  }
+
+  return ret;
 }
 
-//feilong:添加virgin_bit和iteration相关函数
-//feilong：添加内存内更新最近一次virgin_bit和iteration的函数
-int feilong_update(int iteration){
-    printf("feilong:feilong_update start\n");
-    memcpy(virgin_bits_maintain,virgin_bits,MAP_SIZE);
-    iteration_maintain=iteration;
-    printf("feilong:feilong_update end\n");
+/* Seed pool minimization.  Store up to 'max' features of the iteration trace
+   in 'features', one per bucket bit: (map index << 3) | bit.  Returns the
+   total number of features so callers can size the buffer. */
+
+u32 trace_accum_features(u32* features, u32 max)
+{
+  u64* cur = (u64*)trace_accum;
+  u32  i, j, b, ret = 0;
+
+  for (i = 0; i < (MAP_SIZE >> 3); i++) {
+
+    if (likely(!cur[i])) continue;
+
+    u8* c = (u8*)&cur[i];
+
+    for (j = 0; j < 8; j++) {
+
+      if (!c[j]) continue;
+
+      for (b = 0; b < 8; b++) {
+
+        if (!(c[j] & (1 << b))) continue;
+        if (ret < max) features[ret] = (((i << 3) + j) << 3) + b;
+        ret++;
+
+      }
+
+    }
+
+  }
+
+  return ret;
+}
+
+/* Run checkpoints.  Instead of copying the whole virgin map at every
+   queue-empty point and dumping it into every fault directory, the run keeps
+   one checkpoint file that grows by one generation per update.  A generation
+   only stores the runs of virgin bytes that changed since the previous one,
+   found through the pages has_new_bits() marked dirty, so an update costs
+   the size of what changed.  Faults just record the current generation.
+
+   File:        u32 magic, u32 version, u32 map size
+   Generation:  u32 generation, s32 iteration, u32 run count, then per run
+                u32 offset, u16 length, length bytes of virgin_bits */
+
+#define CKPT_MAGIC      0x504b4350 /* "PCKP" */
+#define CKPT_VERSION    1
+#define CKPT_GAP        8          /* Merge runs closer than this */
+
+static u8 virgin_bits_ckpt[MAP_SIZE]; /* virgin_bits as of the last generation */
+static FILE* ckpt_fp;
+static u32 ckpt_generation;
+static s32 ckpt_iteration = -1;
+static s32 ckpt_pending = -1;     /* Iteration of an update not written yet */
+static u8* ckpt_buf;
+static u32 ckpt_buf_size;
+
+static int ckpt_reserve(u32 size)
+{
+    u32 new_size = ckpt_buf_size;
+    u8* buf;
+
+    if (size <= ckpt_buf_size) return 0;
+
+    while (new_size < size)
+        new_size = new_size ? new_size * 2 : 4096;
+
+    buf = realloc(ckpt_buf, new_size);
+    if (!buf) return 1;
+
+    ckpt_buf = buf;
+    ckpt_buf_size = new_size;
+
     return 0;
 }
 
-//feilong:添加crash时保存到文件系统函数
-int feilong_save(char * path){
-    //feilong：保存iteartion和virgin_bit到文件系统中
-    //如果没创建path上的路径，创建
-    FILE *fp= fopen(path,"wb");
-    if(fp==NULL){
-        printf("feilong:feilong_save function fopen error!\n");
+/* Start the checkpoint of a new run at 'path'.  Every page is marked dirty
+   so the first generation holds everything found before the run started
+   (e.g. a map loaded by ckpt_read). */
+
+int ckpt_open(char* path)
+{
+    u32 hdr[3] = { CKPT_MAGIC, CKPT_VERSION, MAP_SIZE };
+
+    if (ckpt_fp) fclose(ckpt_fp);
+
+    ckpt_fp = fopen(path, "wb");
+    if (!ckpt_fp) return 1;
+
+    if (fwrite(hdr, sizeof(hdr), 1, ckpt_fp) != 1) {
+        fclose(ckpt_fp);
+        ckpt_fp = NULL;
         return 1;
     }
-    //写入iteration_maintain
-    if(1 != fwrite(&iteration_maintain,sizeof(iteration_maintain),1,fp)){
-        printf("feilong:feilong_save function writes error iteration!\n");
-        return 1;
+
+    fflush(ckpt_fp);
+
+    memset(virgin_bits_ckpt, 255, MAP_SIZE);
+    memset(virgin_dirty, 1, CKPT_PAGES);
+    ckpt_generation = 0;
+    ckpt_iteration = -1;
+    ckpt_pending = -1;
+
+    return 0;
+}
+
+static int ckpt_write(u32 len, u32 runs, s32 iteration)
+{
+    ckpt_generation++;
+    ckpt_iteration = iteration;
+    ckpt_pending = -1;
+
+    memcpy(ckpt_buf, &ckpt_generation, 4);
+    memcpy(ckpt_buf + 4, &ckpt_iteration, 4);
+    memcpy(ckpt_buf + 8, &runs, 4);
+
+    if (fwrite(ckpt_buf, len, 1, ckpt_fp) != 1) return 1;
+    fflush(ckpt_fp);
+
+    return 0;
+}
+
+/* Append a generation for the current virgin map, to be resumed from
+   'iteration'.  When the map did not change only the iteration is kept,
+   and written by ckpt_commit() if a fault needs it.  The dirty pages are
+   only cleared once the whole generation is built, so running out of
+   memory leaves them for the next update. */
+
+int ckpt_update(int iteration)
+{
+    u32 len = 12, runs = 0, page;
+
+    if (!ckpt_fp) return 1;
+
+    if (ckpt_reserve(len)) return 1;
+
+    for (page = 0; page < CKPT_PAGES; page++) {
+
+        if (!virgin_dirty[page]) continue;
+
+        u32 i   = page << CKPT_PAGE_SHIFT;
+        u32 end = i + (1 << CKPT_PAGE_SHIFT);
+
+        while (i < end) {
+
+            if (virgin_bits[i] == virgin_bits_ckpt[i]) { i++; continue; }
+
+            /* Extend the run over changed bytes and short unchanged gaps */
+
+            u32 start = i, last = i;
+
+            while (i < end && i - last <= CKPT_GAP) {
+                if (virgin_bits[i] != virgin_bits_ckpt[i]) last = i;
+                i++;
+            }
+
+            u16 n = last - start + 1;
+
+            if (ckpt_reserve(len + 6 + n)) return 1;
+
+            memcpy(ckpt_buf + len, &start, 4);
+            memcpy(ckpt_buf + len + 4, &n, 2);
+            memcpy(ckpt_buf + len + 6, virgin_bits + start, n);
+            len += 6 + n;
+            runs++;
+
+            i = last + 1;
+
+        }
+
     }
-    //写入virgin_bit
-    int return_byte_num = fwrite(virgin_bits_maintain,1,MAP_SIZE,fp);
-    if(return_byte_num != MAP_SIZE){
-        printf("feilong:feilong_save function writes error virgin_bit!\n");
+
+    for (page = 0; page < CKPT_PAGES; page++) {
+
+        if (!virgin_dirty[page]) continue;
+
+        memcpy(virgin_bits_ckpt + (page << CKPT_PAGE_SHIFT),
+               virgin_bits + (page << CKPT_PAGE_SHIFT), 1 << CKPT_PAGE_SHIFT);
+        virgin_dirty[page] = 0;
+
+    }
+
+    if (!runs) {
+        ckpt_pending = iteration == ckpt_iteration ? -1 : iteration;
+        return 0;
+    }
+
+    return ckpt_write(len, runs, iteration);
+}
+
+/* Write any pending update and return the generation a fault found now
+   should be reproduced from, 0 if there is none yet. */
+
+u32 ckpt_commit()
+{
+    if (ckpt_fp && ckpt_pending != -1 && !ckpt_reserve(12))
+        ckpt_write(12, 0, ckpt_pending);
+
+    return ckpt_generation;
+}
+
+/* Rebuild virgin_bits as of 'generation' of the checkpoint at 'path' and
+   return the iteration to resume from in 'iteration'.  The map is rebuilt
+   aside and virgin_bits is left alone unless the generation is found. */
+
+int ckpt_read(char* path, u32 generation, int* iteration)
+{
+    u32 hdr[3], rec[3], r;
+    u32 offset;
+    u16 n;
+    s32 resume = 1;
+    int ret = 1;
+    u8* map;
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return 1;
+
+    map = malloc(MAP_SIZE);
+    if (!map) {
+        fclose(fp);
         return 1;
     }
-    //关闭文件写流
+
+    if (fread(hdr, sizeof(hdr), 1, fp) != 1 || hdr[0] != CKPT_MAGIC ||
+        hdr[1] != CKPT_VERSION || hdr[2] != MAP_SIZE) goto out;
+
+    memset(map, 255, MAP_SIZE);
+
+    /* Generation 0 is the pristine map at the start of the run */
+    if (!generation) ret = 0;
+
+    while (ret && fread(rec, sizeof(rec), 1, fp) == 1 && rec[0] <= generation) {
+
+        for (r = 0; r < rec[2]; r++) {
+
+            if (fread(&offset, 4, 1, fp) != 1 || fread(&n, 2, 1, fp) != 1 ||
+                offset + n > MAP_SIZE || fread(map + offset, n, 1, fp) != 1)
+              goto out;
+
+        }
+
+        resume = (s32)rec[1];
+        if (rec[0] == generation) ret = 0;
+
+    }
+
+    if (!ret) {
+        memcpy(virgin_bits, map, MAP_SIZE);
+        *iteration = resume;
+    }
+
+out:
+
+    free(map);
     fclose(fp);
-    return 0;
+    return ret;
 }
 
 //feilong:添加读取函数
@@ -391,7 +681,7 @@ int feilong_read(char *path,int * iteration){
         return 1;
     }
     //读取iteration_maintain
-    if(1 != fread(iteration,sizeof(iteration_maintain),1,fp)){
+    if(1 != fread(iteration,sizeof(int),1,fp)){
         printf("feilong:feilong_read function reads error iteration!\n");
         return 1;
     }
@@ -0,0 +1,790 @@
+/* Native crash monitor used by the LinuxDebugger monitor.
+
+   The target is started by a monitor thread that forks, traces the child
+   and stays in waitpid() for the life of the target.  ptrace requests have
+   to come from the tracing thread, so every ptrace call happens here and
+   the C# side only reads the state under the lock.
+
+   Nothing is collected while the target runs.  Registers and a backtrace
+   are only read when a thread stops with a crash signal; the target is
+   then killed and the report is kept for dbg_report().  CPU idleness is
+   measured from /proc/pid/stat between polls of a pidfd, which also
+   wakes up as soon as the target exits.
+
+   Sanitizer reports are streamed instead of written to a file.  With a
+   log prefix set, the sanitizer log_path of the target (prefix.pid) is
+   created as a FIFO before the target runs and a reader thread copies
+   whatever the runtime writes into memory.  The log is drained again
+   before a crash or exit is published, so a report is complete by the
+   time dbg_state() stops returning DBG_RUNNING.
+
+   Build:  clang debugger.c -fPIC -shared -lpthread -o libpeachDebugger.so
+   With libunwind (better backtraces without frame pointers):
+           clang debugger.c -fPIC -shared -DHAVE_LIBUNWIND -lpthread \
+                 -lunwind-ptrace -lunwind-generic -o libpeachDebugger.so */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+
+#ifdef HAVE_LIBUNWIND
+#include <libunwind-ptrace.h>
+#endif
+
+typedef uint8_t  u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+#define DBG_NONE            0
+#define DBG_RUNNING         1
+#define DBG_EXITED          2
+#define DBG_CRASHED         3
+
+#define DBG_IDLE            0 /* dbg_wait_idle() results */
+#define DBG_GONE            1
+#define DBG_TIMEOUT         2
+
+#define DBG_REPORT_SIZE     16384
+#define DBG_MAX_FRAMES      32
+#define DBG_MAJOR_FRAMES    5
+#define DBG_MAX_MAPS        1024
+#define DBG_LOG_MAX         (1 << 20)
+#define DBG_LOG_POLL_MS     100
+
+typedef struct {
+  pthread_t       thread;
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+
+  char*           file;
+  char**          argv;
+  char**          envp;
+
+  pid_t           pid;
+  int             pidfd;
+  int             state;
+  int             status;        /* Exit code, or signal when > 255 */
+  volatile int    stopping;
+
+  char            report[DBG_REPORT_SIZE];
+  u32             report_len;
+
+  char*           log_prefix;    /* Sanitizer log_path, NULL if unused */
+  char            log_path[4096];
+  int             log_fd;
+  pthread_t       log_thread;
+  pthread_mutex_t log_lock;
+  volatile int    log_stop;
+  char*           log;
+  u32             log_len, log_size;
+} dbg_t;
+
+typedef struct {
+  u64   start, end, offset;
+  char  path[256];
+} dbg_map;
+
+static char** dbg_copy(const char** src, int count)
+{
+  char** ret = calloc(count + 1, sizeof(char*));
+  int i;
+
+  for (i = 0; i < count; i++)
+    ret[i] = strdup(src[i]);
+
+  return ret;
+}
+
+static void dbg_free(char** arr)
+{
+  char** p;
+
+  if (!arr) return;
+
+  for (p = arr; *p; p++)
+    free(*p);
+
+  free(arr);
+}
+
+static void dbg_set_state(dbg_t* d, int state, int status)
+{
+  pthread_mutex_lock(&d->lock);
+
+  /* A crash stays a crash while the killed target is reaped */
+  if (d->state != DBG_CRASHED) d->state = state;
+  d->status = status;
+
+  pthread_cond_broadcast(&d->cond);
+  pthread_mutex_unlock(&d->lock);
+}
+
+static int dbg_is_crash(int sig)
+{
+  switch (sig) {
+    case SIGSEGV:
+    case SIGABRT:
+    case SIGBUS:
+    case SIGILL:
+    case SIGFPE:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static void dbg_printf(dbg_t* d, const char* fmt, ...)
+{
+  va_list ap;
+  int n;
+
+  if (d->report_len >= DBG_REPORT_SIZE - 1) return;
+
+  va_start(ap, fmt);
+  n = vsnprintf(d->report + d->report_len, DBG_REPORT_SIZE - d->report_len, fmt, ap);
+  va_end(ap);
+
+  if (n > 0) d->report_len += n;
+  if (d->report_len > DBG_REPORT_SIZE - 1) d->report_len = DBG_REPORT_SIZE - 1;
+}
+
+/* Read what is pending on the log FIFO.  Called from the reader thread
+   and, with the target stopped, from the monitor thread. */
+
+static void dbg_log_drain(dbg_t* d)
+{
+  char buf[4096];
+  ssize_t n;
+
+  if (d->log_fd < 0) return;
+
+  pthread_mutex_lock(&d->log_lock);
+
+  while ((n = read(d->log_fd, buf, sizeof(buf))) > 0) {
+
+    if (d->log_len + n > d->log_size) {
+      u32 size = d->log_size ? d->log_size : sizeof(buf);
+      while (size < d->log_len + n) size <<= 1;
+      if (size > DBG_LOG_MAX) size = DBG_LOG_MAX;
+      d->log = realloc(d->log, size);
+      d->log_size = size;
+    }
+
+    if (n > d->log_size - d->log_len) n = d->log_size - d->log_len;
+    memcpy(d->log + d->log_len, buf, n);
+    d->log_len += n;
+
+  }
+
+  pthread_mutex_unlock(&d->log_lock);
+}
+
+static void* dbg_log_thread(void* arg)
+{
+  dbg_t* d = arg;
+  struct pollfd pfd = { d->log_fd, POLLIN, 0 };
+
+  while (!d->log_stop) {
+
+    /* Once the writer closes, POLLHUP stays up until the next open */
+    if (poll(&pfd, 1, DBG_LOG_POLL_MS) > 0) {
+      if (pfd.revents & POLLIN) dbg_log_drain(d);
+      else usleep(DBG_LOG_POLL_MS * 1000);
+    }
+
+  }
+
+  return NULL;
+}
+
+static void dbg_log_open(dbg_t* d, pid_t pid)
+{
+  if (!d->log_prefix) return;
+
+  snprintf(d->log_path, sizeof(d->log_path), "%s.%d", d->log_prefix, pid);
+  unlink(d->log_path);
+
+  if (mkfifo(d->log_path, 0600)) return;
+
+  d->log_fd = open(d->log_path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (d->log_fd < 0) {
+    unlink(d->log_path);
+    return;
+  }
+
+  /* Let a whole report fit without blocking the writer */
+  fcntl(d->log_fd, F_SETPIPE_SZ, DBG_LOG_MAX);
+
+  if (pthread_create(&d->log_thread, NULL, dbg_log_thread, d)) {
+    close(d->log_fd);
+    d->log_fd = -1;
+    unlink(d->log_path);
+  }
+}
+
+static void dbg_log_close(dbg_t* d)
+{
+  if (d->log_fd < 0) return;
+
+  d->log_stop = 1;
+  pthread_join(d->log_thread, NULL);
+
+  dbg_log_drain(d);
+
+  close(d->log_fd);
+  d->log_fd = -1;
+  unlink(d->log_path);
+}
+
+static int dbg_read_maps(pid_t pid, dbg_map* maps, int max)
+{
+  char path[64], line[512];
+  int count = 0;
+  FILE* fp;
+
+  snprintf(path, sizeof(path), "/proc/%d/maps", pid);
+  fp = fopen(path, "r");
+  if (!fp) return 0;
+
+  while (count < max && fgets(line, sizeof(line), fp)) {
+
+    dbg_map* m = &maps[count];
+    char perms[8];
+    int off = 0;
+
+    if (sscanf(line, "%lx-%lx %7s %lx %*s %*s %n", (unsigned long*)&m->start,
+               (unsigned long*)&m->end, perms, (unsigned long*)&m->offset, &off) < 4)
+      continue;
+
+    if (!off || line[off] != '/') continue;
+
+    strncpy(m->path, line + off, sizeof(m->path) - 1);
+    m->path[sizeof(m->path) - 1] = 0;
+    m->path[strcspn(m->path, "\n")] = 0;
+    count++;
+
+  }
+
+  fclose(fp);
+  return count;
+}
+
+/* Module relative location of 'addr', stable across ASLR */
+
+static void dbg_symbolize(u64 addr, dbg_map* maps, int count, char* out, size_t size)
+{
+  int i;
+
+  for (i = 0; i < count; i++) {
+
+    if (addr < maps[i].start || addr >= maps[i].end) continue;
+
+    const char* name = strrchr(maps[i].path, '/');
+    snprintf(out, size, "%s+0x%lx", name ? name + 1 : maps[i].path,
+             (unsigned long)(addr - maps[i].start + maps[i].offset));
+    return;
+
+  }
+
+  snprintf(out, size, "0x%lx", (unsigned long)addr);
+}
+
+static u32 dbg_hash(u32 h, const char* s)
+{
+  while (*s) {
+    h ^= (u8)*s++;
+    h *= 16777619;
+  }
+
+  return h;
+}
+
+static int dbg_backtrace(pid_t tid, u64* frames, int max)
+{
+  int n = 0;
+
+#ifdef HAVE_LIBUNWIND
+
+  unw_addr_space_t as = unw_create_addr_space(&_UPT_accessors, 0);
+  void* ui = _UPT_create(tid);
+  unw_cursor_t cursor;
+
+  if (as && ui && !unw_init_remote(&cursor, as, ui)) {
+
+    do {
+
+      unw_word_t ip;
+      if (unw_get_reg(&cursor, UNW_REG_IP, &ip) || !ip) break;
+      frames[n++] = ip;
+
+    } while (n < max && unw_step(&cursor) > 0);
+
+  }
+
+  if (ui) _UPT_destroy(ui);
+  if (as) unw_destroy_addr_space(as);
+
+#elif defined(__x86_64__)
+
+  /* Frame pointer walk, good enough for targets built with
+     -fno-omit-frame-pointer (the default for ASAN builds) */
+
+  struct user_regs_struct regs;
+  u64 bp;
+
+  if (ptrace(PTRACE_GETREGS, tid, 0, &regs)) return 0;
+
+  frames[n++] = regs.rip;
+  bp = regs.rbp;
+
+  while (n < max && bp) {
+
+    long ret, next;
+
+    errno = 0;
+    next = ptrace(PTRACE_PEEKDATA, tid, (void*)bp, 0);
+    ret  = ptrace(PTRACE_PEEKDATA, tid, (void*)(bp + 8), 0);
+    if (errno || !ret) break;
+
+    frames[n++] = ret;
+    if ((u64)next <= bp) break;
+    bp = next;
+
+  }
+
+#endif /* ^HAVE_LIBUNWIND */
+
+  return n;
+}
+
+/* Same classification words as the gdb exploitable plugin, so fault
+   folders keep their names. */
+
+static const char* dbg_classify(int sig, u64 addr, u64 pc)
+{
+  if (sig == SIGILL) return "PROBABLY_EXPLOITABLE";
+  if ((sig == SIGSEGV || sig == SIGBUS) && addr == pc) return "EXPLOITABLE";
+  if ((sig == SIGSEGV || sig == SIGBUS) && addr < 0x10000) return "PROBABLY_NOT_EXPLOITABLE";
+  if (sig == SIGFPE) return "PROBABLY_NOT_EXPLOITABLE";
+  return "UNKNOWN";
+}
+
+static void dbg_capture(dbg_t* d, pid_t tid, int sig)
+{
+  dbg_map* maps = malloc(sizeof(dbg_map) * DBG_MAX_MAPS);
+  u64 frames[DBG_MAX_FRAMES];
+  char where[DBG_MAX_FRAMES][300];
+  u32 major = 2166136261u, minor = 2166136261u;
+  siginfo_t si;
+  u64 addr = 0, pc = 0;
+  int nmaps, nframes, i;
+
+  memset(&si, 0, sizeof(si));
+  if (!ptrace(PTRACE_GETSIGINFO, tid, 0, &si))
+    addr = (u64)(uintptr_t)si.si_addr;
+
+  /* The runtime has written its report before raising the signal */
+  dbg_log_drain(d);
+
+  nmaps   = dbg_read_maps(d->pid, maps, DBG_MAX_MAPS);
+  nframes = dbg_backtrace(tid, frames, DBG_MAX_FRAMES);
+
+  for (i = 0; i < nframes; i++) {
+
+    dbg_symbolize(frames[i], maps, nmaps, where[i], sizeof(where[i]));
+
+    if (i < DBG_MAJOR_FRAMES) major = dbg_hash(major, where[i]);
+    minor = dbg_hash(minor, where[i]);
+
+  }
+
+  if (nframes) pc = frames[0];
+
+  pthread_mutex_lock(&d->lock);
+
+  d->report_len = 0;
+
+  dbg_printf(d, "*** Crash detected. ***\n");
+  dbg_printf(d, "Signal: %s (%d), si_code %d, address 0x%lx, thread %d\n",
+             strsignal(sig), sig, si.si_code, (unsigned long)addr, tid);
+  dbg_printf(d, "Short description: %s at %s\n", strsignal(sig),
+             nframes ? where[0] : "unknown location");
+  dbg_printf(d, "Hash: %08x.%08x\n", major, minor);
+  dbg_printf(d, "Exploitability Classification: %s\n", dbg_classify(sig, addr, pc));
+
+#ifdef __x86_64__
+  {
+    struct user_regs_struct r;
+
+    if (!ptrace(PTRACE_GETREGS, tid, 0, &r)) {
+      dbg_printf(d, "\nRegisters:\n");
+      dbg_printf(d, "rax 0x%016llx rbx 0x%016llx rcx 0x%016llx rdx 0x%016llx\n", r.rax, r.rbx, r.rcx, r.rdx);
+      dbg_printf(d, "rsi 0x%016llx rdi 0x%016llx rbp 0x%016llx rsp 0x%016llx\n", r.rsi, r.rdi, r.rbp, r.rsp);
+      dbg_printf(d, "r8  0x%016llx r9  0x%016llx r10 0x%016llx r11 0x%016llx\n", r.r8, r.r9, r.r10, r.r11);
+      dbg_printf(d, "r12 0x%016llx r13 0x%016llx r14 0x%016llx r15 0x%016llx\n", r.r12, r.r13, r.r14, r.r15);
+      dbg_printf(d, "rip 0x%016llx eflags 0x%08llx\n", r.rip, r.eflags);
+    }
+  }
+#endif /* ^__x86_64__ */
+
+  dbg_printf(d, "\nBacktrace:\n");
+  for (i = 0; i < nframes; i++)
+    dbg_printf(d, "#%-2d 0x%016lx in %s\n", i, (unsigned long)frames[i], where[i]);
+
+  d->state = DBG_CRASHED;
+  pthread_cond_broadcast(&d->cond);
+  pthread_mutex_unlock(&d->lock);
+
+  free(maps);
+}
+
+static void* dbg_thread(void* arg)
+{
+  dbg_t* d = arg;
+  pid_t pid, tid;
+  int status = 0;
+
+  pid = fork();
+
+  if (!pid) {
+
+    /* Own process group so waitpid(-pid) only sees the target's threads */
+    setpgid(0, 0);
+    ptrace(PTRACE_TRACEME, 0, 0, 0);
+    execve(d->file, d->argv, d->envp);
+    _exit(127);
+
+  }
+
+  if (pid < 0) {
+    dbg_set_state(d, DBG_EXITED, -1);
+    return NULL;
+  }
+
+  if (waitpid(pid, &status, __WALL) < 0) {
+    /* Never saw the child stop, don't leave it running untraced */
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, __WALL);
+    dbg_set_state(d, DBG_EXITED, -1);
+    return NULL;
+  }
+
+  if (!WIFSTOPPED(status)) {
+    /* execve failed (127) or the child died before it */
+    dbg_set_state(d, DBG_EXITED, WIFEXITED(status) ? WEXITSTATUS(status) : 256 + WTERMSIG(status));
+    return NULL;
+  }
+
+  /* Stopped on the SIGTRAP that follows execve */
+
+  dbg_log_open(d, pid);
+
+  ptrace(PTRACE_SETOPTIONS, pid, 0,
+         PTRACE_O_EXITKILL | PTRACE_O_TRACECLONE | PTRACE_O_TRACEEXEC);
+
+  pthread_mutex_lock(&d->lock);
+  d->pid = pid;
+  d->pidfd = syscall(SYS_pidfd_open, pid, 0);
+  d->state = DBG_RUNNING;
+  pthread_cond_broadcast(&d->cond);
+  pthread_mutex_unlock(&d->lock);
+
+  ptrace(PTRACE_CONT, pid, 0, 0);
+
+  for (;;) {
+
+    tid = waitpid(-pid, &status, __WALL);
+
+    if (tid < 0) {
+      if (errno == EINTR) continue;
+      dbg_log_close(d);
+      dbg_set_state(d, DBG_EXITED, -1);
+      break;
+    }
+
+    if (WIFEXITED(status) || WIFSIGNALED(status)) {
+
+      if (tid != pid) continue;
+
+      dbg_log_close(d);
+
+      if (WIFSIGNALED(status) && dbg_is_crash(WTERMSIG(status)) && !d->stopping &&
+          d->state == DBG_RUNNING) {
+
+        /* Died in a thread we were not tracing */
+        pthread_mutex_lock(&d->lock);
+        d->report_len = 0;
+        dbg_printf(d, "*** Crash detected. ***\nShort description: %s, no thread state\n",
+                   strsignal(WTERMSIG(status)));
+        d->state = DBG_CRASHED;
+        pthread_mutex_unlock(&d->lock);
+
+      }
+
+      dbg_set_state(d, DBG_EXITED, WIFEXITED(status) ? WEXITSTATUS(status) : 256 + WTERMSIG(status));
+      break;
+
+    }
+
+    if (!WIFSTOPPED(status)) continue;
+
+    int sig = WSTOPSIG(status);
+
+    if (status >> 16) {
+
+      /* clone/exec events */
+      ptrace(PTRACE_CONT, tid, 0, 0);
+
+    } else if (sig == SIGSTOP && tid != pid) {
+
+      /* New threads start stopped */
+      ptrace(PTRACE_CONT, tid, 0, 0);
+
+    } else if (dbg_is_crash(sig) && !d->stopping) {
+
+      dbg_capture(d, tid, sig);
+      kill(pid, SIGKILL);
+
+    } else {
+
+      ptrace(PTRACE_CONT, tid, 0, sig);
+
+    }
+
+  }
+
+  return NULL;
+}
+
+/* Prepare to run 'file'.  'argv' and 'envp' hold argc and envc strings. */
+
+dbg_t* dbg_create(const char* file, const char** argv, int argc, const char** envp, int envc)
+{
+  dbg_t* d = calloc(1, sizeof(dbg_t));
+
+  pthread_mutex_init(&d->lock, NULL);
+  pthread_mutex_init(&d->log_lock, NULL);
+  pthread_cond_init(&d->cond, NULL);
+
+  d->file  = strdup(file);
+  d->argv  = dbg_copy(argv, argc);
+  d->envp  = dbg_copy(envp, envc);
+  d->pidfd = -1;
+  d->log_fd = -1;
+
+  return d;
+}
+
+/* Stream sanitizer reports of the target, 'prefix' is the log_path
+   given to the runtime.  Call before dbg_start(). */
+
+void dbg_set_log(dbg_t* d, const char* prefix)
+{
+  free(d->log_prefix);
+  d->log_prefix = prefix && *prefix ? strdup(prefix) : NULL;
+}
+
+/* Start the target, returns its pid or -1 if it could not be started. */
+
+int dbg_start(dbg_t* d)
+{
+  int ret;
+
+  if (pthread_create(&d->thread, NULL, dbg_thread, d)) return -1;
+
+  pthread_mutex_lock(&d->lock);
+  while (d->state == DBG_NONE)
+    pthread_cond_wait(&d->cond, &d->lock);
+  ret = d->pid ? d->pid : -1;
+  pthread_mutex_unlock(&d->lock);
+
+  return ret;
+}
+
+int dbg_state(dbg_t* d)
+{
+  int ret;
+
+  pthread_mutex_lock(&d->lock);
+  ret = d->state;
+  pthread_mutex_unlock(&d->lock);
+
+  return ret;
+}
+
+int dbg_status(dbg_t* d)
+{
+  return d->status;
+}
+
+/* Copy the crash report to 'buf', returns its length. */
+
+int dbg_report(dbg_t* d, char* buf, int size)
+{
+  int n;
+
+  pthread_mutex_lock(&d->lock);
+  n = d->report_len < (u32)size ? (int)d->report_len : size;
+  memcpy(buf, d->report, n);
+  pthread_mutex_unlock(&d->lock);
+
+  return n;
+}
+
+/* Copy the sanitizer log from 'offset' to 'buf', returns the length
+   copied.  The log only grows while the target runs. */
+
+int dbg_log(dbg_t* d, char* buf, int size, int offset)
+{
+  int n = 0;
+
+  pthread_mutex_lock(&d->log_lock);
+
+  if (offset >= 0 && (u32)offset < d->log_len) {
+    n = d->log_len - offset < (u32)size ? (int)(d->log_len - offset) : size;
+    memcpy(buf, d->log + offset, n);
+  }
+
+  pthread_mutex_unlock(&d->log_lock);
+
+  return n;
+}
+
+/* Wait up to 'timeout' ms (-1 is infinite) for the target to go away.
+   Returns the state. */
+
+int dbg_wait(dbg_t* d, int timeout)
+{
+  struct timespec ts;
+  int ret;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec  += timeout / 1000;
+  ts.tv_nsec += (long)(timeout % 1000) * 1000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
+
+  pthread_mutex_lock(&d->lock);
+
+  while (d->state == DBG_RUNNING) {
+    if (timeout < 0) pthread_cond_wait(&d->cond, &d->lock);
+    else if (pthread_cond_timedwait(&d->cond, &d->lock, &ts) == ETIMEDOUT) break;
+  }
+
+  ret = d->state;
+  pthread_mutex_unlock(&d->lock);
+
+  return ret;
+}
+
+static u64 dbg_cpu_ticks(pid_t pid)
+{
+  char path[64], buf[1024];
+  unsigned long utime = 0, stime = 0;
+  char* p;
+  int fd, n;
+
+  snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+  fd = open(path, O_RDONLY);
+  if (fd < 0) return 0;
+
+  n = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  if (n <= 0) return 0;
+  buf[n] = 0;
+
+  /* Fields 14 and 15, counted after the ')' closing the command name */
+  p = strrchr(buf, ')');
+  if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                   &utime, &stime) != 2)
+    return 0;
+
+  return (u64)utime + stime;
+}
+
+/* Wait up to 'timeout' ms (-1 is infinite) for the target to stop using
+   the CPU, sampling every 'interval' ms. */
+
+int dbg_wait_idle(dbg_t* d, int timeout, int interval)
+{
+  u64 last = 0, ticks;
+  int elapsed;
+
+  for (elapsed = 0; timeout < 0 || elapsed < timeout; elapsed += interval) {
+
+    if (dbg_state(d) != DBG_RUNNING) return DBG_GONE;
+
+    ticks = dbg_cpu_ticks(d->pid);
+    if (elapsed && ticks == last) return DBG_IDLE;
+    last = ticks;
+
+    if (d->pidfd >= 0) {
+
+      struct pollfd pfd = { d->pidfd, POLLIN, 0 };
+      if (poll(&pfd, 1, interval) > 0) {
+        dbg_wait(d, 1000);
+        return DBG_GONE;
+      }
+
+    } else if (dbg_wait(d, interval) != DBG_RUNNING) {
+      return DBG_GONE;
+    }
+
+  }
+
+  return DBG_TIMEOUT;
+}
+
+/* Ask the target to exit, kill it after 'grace' ms. */
+
+void dbg_stop(dbg_t* d, int grace)
+{
+  if (dbg_state(d) == DBG_RUNNING) {
+
+    d->stopping = 1;
+    kill(d->pid, SIGTERM);
+
+    if (dbg_wait(d, grace) == DBG_RUNNING) {
+      kill(d->pid, SIGKILL);
+      dbg_wait(d, -1);
+    }
+
+  }
+}
+
+void dbg_destroy(dbg_t* d)
+{
+  dbg_stop(d, 0);
+
+  if (d->state != DBG_NONE) pthread_join(d->thread, NULL);
+  if (d->pidfd >= 0) close(d->pidfd);
+
+  free(d->file);
+  free(d->log_prefix);
+  free(d->log);
+  dbg_free(d->argv);
+  dbg_free(d->envp);
+
+  pthread_cond_destroy(&d->cond);
+  pthread_mutex_destroy(&d->lock);
+  pthread_mutex_destroy(&d->log_lock);
+  free(d);
+}